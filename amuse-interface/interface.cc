@@ -24,6 +24,47 @@ extern "C" {
     // flags
     static bool particle_list_change_flag=true;
 
+    // kinds of particle modifications since the last recommit, ordered from cheap to expensive
+    // velocity: patched in system_soft, energy corrected exactly
+    // mass: the mass of one particle is patched in system_soft, the potential energy change dm*pot is exact for one particle;
+    //       when more particles change mass, the pair terms between them are missing, thus a full update is used
+    // full: positions, the particle list or more than one mass changed, a new initial step is needed
+    enum class ParticleUpdate{none=0, velocity=1, mass=2, full=3};
+    static ParticleUpdate particle_update = ParticleUpdate::none;
+    static double dekin_particle_update_loc = 0.0; // local kinetic energy change due to velocity and mass modifications
+    static double depot_particle_update_loc = 0.0; // local potential energy change due to the mass modification
+    static int n_mass_update = 0; // number of mass modifications since the last recommit
+
+    static void registerParticleUpdate(const ParticleUpdate _type) {
+        if (_type>particle_update) particle_update = _type;
+    }
+
+    // patch the velocity of a local particle and record the kinetic energy change
+    static void patchVelocity(FPSoft& _p, const PS::F64vec& _vel) {
+        dekin_particle_update_loc += 0.5*_p.mass*(_vel*_vel - _p.vel*_p.vel);
+#ifdef CLUSTER_VELOCITY
+        // shift the c.m. velocity of the group used in the cluster search, exact when all members get the same kick (bridge)
+        if (Ptcl::group_data_mode==GroupDataMode::cm && _p.group_data.cm.mass>0.0) {
+            PS::F64vec dv = _vel - _p.vel;
+            _p.group_data.cm.vel.x += dv.x;
+            _p.group_data.cm.vel.y += dv.y;
+            _p.group_data.cm.vel.z += dv.z;
+        }
+#endif
+        _p.vel = _vel;
+    }
+
+    // patch the mass of a local particle and record the energy change, the potential energy change is exact only if no other mass changes
+    static void patchMass(FPSoft& _p, const double _mass) {
+        double dm = _mass - _p.mass;
+        depot_particle_update_loc += dm*_p.pot_tot;
+        dekin_particle_update_loc += 0.5*dm*(_p.vel*_p.vel);
+#ifdef CLUSTER_VELOCITY
+        if (Ptcl::group_data_mode==GroupDataMode::cm && _p.group_data.cm.mass>0.0) _p.group_data.cm.mass += dm;
+#endif
+        _p.mass = _mass;
+    }
+
     // common
 
     int initialize_code() {
@@ -160,6 +201,7 @@ extern "C" {
         ptr->stat.n_real_glb++;
 
         particle_list_change_flag = true;
+        registerParticleUpdate(ParticleUpdate::full);
 
         return 0;
     }
@@ -180,6 +222,7 @@ extern "C" {
         else return -1;
 #endif
         particle_list_change_flag = true;
+        registerParticleUpdate(ParticleUpdate::full);
 
         return 0;
     }
@@ -264,6 +307,7 @@ extern "C" {
 #else
         else return -1;
 #endif
+        registerParticleUpdate(ParticleUpdate::full);
         return 0;
     }
 
@@ -294,7 +338,7 @@ extern "C" {
         int index = ptr->getParticleAdrFromID(index_of_the_particle);
         if (index>=0) {
             FPSoft* p = &(ptr->system_soft[index]);
-            p->mass = mass;
+            patchMass(*p, mass);
         }    
 #ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
         int check = PS::Comm::getMaxValue(index);
@@ -302,6 +346,8 @@ extern "C" {
 #else
         else return -1;
 #endif
+        n_mass_update++;
+        registerParticleUpdate((mass>0.0&&n_mass_update==1)? ParticleUpdate::mass: ParticleUpdate::full);
         return 0;
     }
 
@@ -359,6 +405,7 @@ extern "C" {
 #else
         else return -1;
 #endif
+        registerParticleUpdate(ParticleUpdate::full);
         return 0;
     }
 
@@ -410,9 +457,7 @@ extern "C" {
         int index = ptr->getParticleAdrFromID(index_of_the_particle);
         if (index>=0) {
             FPSoft* p = &(ptr->system_soft[index]);
-            p->vel.x = vx;
-            p->vel.y = vy;
-            p->vel.z = vz;
+            patchVelocity(*p, PS::F64vec(vx, vy, vz));
         }    
 #ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
         int check = PS::Comm::getMaxValue(index);
@@ -420,6 +465,7 @@ extern "C" {
 #else
         else return -1;
 #endif
+        registerParticleUpdate(ParticleUpdate::velocity);
         return 0;
     }
 
@@ -772,10 +818,20 @@ extern "C" {
     int recommit_particles() {
         // this function is called too frequent (every time when set_xx is used).
         // thus only register the flag and do update at once in the begining of evolve_model
+        // velocity and mass modifications are already patched in system_soft. Since clusters, groups and forces are rebuilt
+        // at the begining of each integration, only the energy references need a correction; otherwise do a new initial step.
 #ifdef INTERFACE_DEBUG_PRINT
-        if(ptr->my_rank==0) std::cout<<"PETAR: recommit_particles start\n";
+        if(ptr->my_rank==0) std::cout<<"PETAR: recommit_particles start, update type "<<int(particle_update)<<"\n";
 #endif
-        if (ptr->n_interrupt_glb==0) ptr->initial_step_flag = false;
+        if (ptr->n_interrupt_glb==0) {
+            if (particle_update==ParticleUpdate::full) ptr->initial_step_flag = false;
+            else if (particle_update!=ParticleUpdate::none && ptr->initial_step_flag) 
+                ptr->correctEnergyExternalModification(dekin_particle_update_loc, depot_particle_update_loc);
+        }
+        particle_update = ParticleUpdate::none;
+        dekin_particle_update_loc = 0.0;
+        depot_particle_update_loc = 0.0;
+        n_mass_update = 0;
         reconstruct_particle_list();
 #ifdef INTERFACE_DEBUG_PRINT
         if(ptr->my_rank==0) std::cout<<"PETAR: recommit_particles end\n";
@@ -1,6 +1,7 @@
 #include "interface.h"
 #include <cstdio>
 #include <cassert>
+#include <cmath>
 #include "mpi.h"
 
 int main(int argc, char **argv) {
@@ -147,6 +148,40 @@ int main(int argc, char **argv) {
         printf("T=%f Ekin=%f Epot=%f \n",time,ekin,epot);
     }
 
+    // velocity and mass updates without a new initial step: the corrected energies should agree with the ones of a new initial step
+    double state[5];
+    // a position update forces a new initial step, thus the energies and potentials are up to date
+    error = get_position(index[0], &state[0], &state[1], &state[2]);
+    MPI_Bcast(state, 3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    set_position(index[0], state[0], state[1], state[2]);
+    recommit_particles();
+    get_kinetic_energy(&ekin);
+
+    error = get_velocity(index[0], &state[0], &state[1], &state[2]);
+    get_mass(index[2], &state[3]);
+    MPI_Bcast(state, 4, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    error = set_velocity(index[0], state[0]+0.1, state[1]-0.2, state[2]);
+    if (my_rank==0) assert(error==0);
+    error = set_mass(index[2], 1.1*state[3]);
+    if (my_rank==0) assert(error==0);
+    recommit_particles();
+    double ekin_fast, epot_fast;
+    get_kinetic_energy(&ekin_fast);
+    get_potential_energy(&epot_fast);
+
+    error = get_position(index[0], &state[0], &state[1], &state[2]);
+    MPI_Bcast(state, 3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    set_position(index[0], state[0], state[1], state[2]);
+    recommit_particles();
+    double ekin_full, epot_full;
+    get_kinetic_energy(&ekin_full);
+    get_potential_energy(&epot_full);
+    if (my_rank==0) {
+        printf("Velocity and mass update: Ekin=%f (new initial step %f) Epot=%f (new initial step %f)\n", ekin_fast, ekin_full, epot_fast, epot_full);
+        assert(fabs(ekin_fast-ekin_full)<=1e-10*fabs(ekin_full));
+        assert(fabs(epot_fast-epot_full)<=1e-8*fabs(epot_full));
+    }
+
     cleanup_code();
 
     return 0;
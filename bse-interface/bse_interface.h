@@ -6,6 +6,7 @@
 #include <string>
 #include <getopt.h>
 #include "../src/io.hpp"
+#include "sse_table.h"
 
 /*!
   This file provides the interface classes to connect the BSE-based code to PeTar.
@@ -355,6 +356,23 @@ struct StarParameter{
              <<std::setw(_width)<<lum;
     }
 
+    //! add data of class members to an event record, same columns as printColumn
+    /*! @param[out] _record: event record with add() for integer and floating-point columns
+     */
+    template <class Trecord>
+    void recordColumn(Trecord& _record) const{
+        _record.add(kw);
+        _record.add(m0);
+        _record.add(mt);
+        _record.add(r);
+        _record.add(mc);
+        _record.add(rc);
+        _record.add(ospin);
+        _record.add(epoch);
+        _record.add(tphys);
+        _record.add(lum);
+    }
+
     //! print column title with meaning (each line for one column)
     /*! @param[out] _fout: std::ostream output object
       @param[in] _counter: offset of the number counter for each line to indicate the column index (defaulted 0)
@@ -398,8 +416,9 @@ struct StarParameterOut{
     double tm;   ///> Main sequence lifetime
     double vkick[4]; ///> kick velocity for NS/BH formation
     double dm;   ///> mass loss
+    double dt_next; ///> next time step estimated from SSE tables [Myr], zero if the tables are not used
 
-    StarParameterOut(): kw0(0), dtmiss(0.0), menv(0.0), renv(0.0), tm(0.0), vkick{0.0}, dm(0.0) {}
+    StarParameterOut(): kw0(0), dtmiss(0.0), menv(0.0), renv(0.0), tm(0.0), vkick{0.0}, dm(0.0), dt_next(0.0) {}
 
     //! print titles of class members using column style
     /*! print titles of class members in one line for column style
@@ -610,6 +629,19 @@ public:
         _fout<<std::setw(_width)<<int(record[9][_index]);
         for (int i=10; i<20; i++) _fout<<std::setw(_width)<<record[i][_index];
     }
+
+    //! add data of class members to an event record, same columns as printColumn
+    /*! @param[out] _record: event record with add() for integer and floating-point columns
+      @param[in] _index: event index to record
+     */
+    template <class Trecord>
+    void recordColumn(Trecord& _record, const int _index) const{
+        for (int i=0; i<3; i++) _record.add(record[i][_index]);
+        for (int i=3; i<5; i++) _record.add(int(record[i][_index]));
+        for (int i=5; i<9; i++) _record.add(record[i][_index]);
+        _record.add(int(record[9][_index]));
+        for (int i=10; i<20; i++) _record.add(record[i][_index]);
+    }
 };
 
 //! IO parameters manager for BSE based code 
@@ -662,6 +694,8 @@ public:
     IOParams<double> mscale;
     IOParams<double> vscale;
     IOParams<double> z;
+    IOParams<long long int> sse_table;
+    IOParams<std::string> sse_table_prefix;
 
     bool print_flag;
 
@@ -705,6 +739,8 @@ public:
 #else
                    z     (input_par_store, 0.001, "bse-metallicity", "Metallicity Z, ranging from 0.0001 to 0.03"),
 #endif
+                   sse_table(input_par_store, 0,  "bse-sse-table", "Use interpolation tables of single star tracks for non-interacting single stars: 0: off; 1: on"),
+                   sse_table_prefix(input_par_store, "sse_table", "bse-sse-table-prefix", "Filename prefix of the cached SSE tables; the suffix is the key of SSE/BSE parameters"),
                    print_flag(false) {}
 #elif MOBSE
     IOParamsBSE(): input_par_store(),
@@ -741,6 +777,8 @@ public:
                    mscale(input_par_store, 1.0,     "mobse-msclae", "Mass scale factor from input data unit (IN) to Msun (m[Msun]=m[IN]*mscale)"),
                    vscale(input_par_store, 1.0,     "mobse-vsclae",  "Velocity scale factor from input data unit(IN) to km/s (v[km/s]=v[IN]*vscale)"),
                    z     (input_par_store, 0.001,   "mobse-metallicity",    "Metallicity"),
+                   sse_table(input_par_store, 0,    "mobse-sse-table", "Use interpolation tables of single star tracks for non-interacting single stars: 0: off; 1: on"),
+                   sse_table_prefix(input_par_store, "sse_table", "mobse-sse-table-prefix", "Filename prefix of the cached SSE tables; the suffix is the key of SSE/BSE parameters"),
                    print_flag(false) {}
 #endif
 
@@ -796,6 +834,8 @@ public:
             {rscale.key, required_argument, &sse_flag, 19},
             {mscale.key, required_argument, &sse_flag, 20},
             {vscale.key, required_argument, &sse_flag, 21},
+            {sse_table.key, required_argument, &sse_flag, 31},
+            {sse_table_prefix.key, required_argument, &sse_flag, 32},
             {z.key,      required_argument, 0, 'z'},
             {"help",     no_argument,       0, 'h'},
             {0,0,0,0}
@@ -982,6 +1022,16 @@ public:
                     opt_used+=2;
                     break;
 #endif
+                case 31:
+                    sse_table.value = atoi(optarg);
+                    if(print_flag) sse_table.print(std::cout);
+                    opt_used+=2;
+                    break;
+                case 32:
+                    sse_table_prefix.value = optarg;
+                    if(print_flag) sse_table_prefix.print(std::cout);
+                    opt_used+=2;
+                    break;
                 default:
                     break;
                 }
@@ -1063,6 +1113,8 @@ public:
     const double year_to_day; ///> year to day 
     const char* single_type[16]; ///> name of single type from SSE
     const char* binary_type[14]; ///> name of binary type return from BSE evolv2, notice if it is -1, it indicate the end of record
+    SSETable sse_table; ///> interpolation tables of single star tracks
+    bool sse_table_flag; ///> if true, use sse_table in evolveStar when possible
 
     BSEManager(): z(0.0), zpars{0}, 
 #ifdef BSEEMP
@@ -1084,7 +1136,8 @@ public:
                               "Blue_straggler",      //11
                               "No_remain",           //12
                               "Disrupt"              //13
-                              } {}
+                              },
+                  sse_table(), sse_table_flag(false) {}
     
 
     bool checkParams() {
@@ -1311,6 +1364,73 @@ public:
 #endif
         }
 
+        if (_input.sse_table.value>0) initialSSETable(_input.sse_table_prefix.value, _print_flag);
+    }
+
+    //! get the key of SSE tables from SSE/BSE parameters
+    unsigned long long int getSSETableKey() const {
+        unsigned long long int key = sse_table.getKey();
+        SSETable::hashKey(key, &z, sizeof(double));
+        SSETable::hashKey(key, zpars, sizeof(double)*20);
+#ifdef BSEEMP
+        SSETable::hashKey(key, &trackmode, sizeof(int));
+#endif
+        SSETable::hashKey(key, &value1_, sizeof(value1_));
+        SSETable::hashKey(key, &value2_, sizeof(value2_));
+        SSETable::hashKey(key, &value4_, sizeof(value4_));
+        SSETable::hashKey(key, &value5_, sizeof(value5_));
+        SSETable::hashKey(key, &flags_, sizeof(flags_));
+#if (defined BSEBBF) || (defined BSEEMP)
+        SSETable::hashKey(key, &flags2_, sizeof(flags2_));
+#endif
+        SSETable::hashKey(key, &points_, sizeof(points_));
+        return key;
+    }
+
+    //! initial SSE tables: read from the cached file, or build and save them
+    /*! The cached file name is [_prefix].[key], where the key is generated from SSE/BSE parameters.
+      Building tables calls evolv1, the random number generator used by kicks is restored after building.
+      @param[in] _prefix: filename prefix of the cached tables
+     */
+    void initialSSETable(const std::string& _prefix, const bool _print_flag=false) {
+        const unsigned long long int key = getSSETableKey();
+        char key_str[32];
+        snprintf(key_str, 32, "%016llx", key);
+        std::string fname = _prefix + "." + key_str;
+
+        auto build = [&]() {
+            if(_print_flag) std::cout<<"Build SSE tables, number of tracks: "<<sse_table.n_mass<<std::endl;
+            // backup random number generator
+            auto value3_bk = value3_;
+            auto rand3_bk = rand3_;
+            sse_table.build<StarParameter, StarParameterOut>(
+                [&](StarParameter& _star, StarParameterOut& _out, const double _dt) { return evolveStarSSE(_star, _out, _dt + _star.tphys); },
+                [&](StarParameter& _star) { return getTimeStepStar(_star)*tscale; });
+            value3_ = value3_bk;
+            rand3_ = rand3_bk;
+        };
+
+#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
+        // rank 0 prepares the file, the others read it
+        if (PS::Comm::getRank()==0) {
+            if (!sse_table.readBinary(fname.c_str(), key)) {
+                build();
+                sse_table.writeBinary(fname.c_str(), key);
+            }
+        }
+        PS::Comm::barrier();
+        if (PS::Comm::getRank()!=0) {
+            if (!sse_table.readBinary(fname.c_str(), key)) build();
+        }
+#else
+        if (!sse_table.readBinary(fname.c_str(), key)) {
+            build();
+            sse_table.writeBinary(fname.c_str(), key);
+        }
+        else if (_print_flag) std::cout<<"Read SSE tables from "<<fname<<std::endl;
+#endif
+        if(_print_flag) std::cout<<"SSE tables: "<<fname<<" number of entries: "<<sse_table.getEntryN()<<std::endl;
+        sse_table_flag = true;
     }
 
     //! get current mass in NB unit
@@ -1395,6 +1515,22 @@ public:
         _bin_event.printColumn(_fout, k, _width);
     }
 
+    //! add one binary event to an event record, same columns as printBinaryEventColumnOne
+    /*! @param[out] _record: event record with setLabel() and add()
+      @param[in] _bin_event: binary event
+      @param[in] k: event index
+     */
+    template <class Trecord>
+    void recordBinaryEventColumnOne(Trecord& _record, const BinaryEvent& _bin_event, const int k) {
+        int type = _bin_event.getType(k);
+        assert(type>=0&&type<14);
+        _record.setLabel(binary_type[type], 16);
+        _record.add(type);
+        if (k==0) _bin_event.recordColumn(_record, _bin_event.getEventIndexInit());
+        else _bin_event.recordColumn(_record, k-1);
+        _bin_event.recordColumn(_record, k);
+    }
+
     //! get velocity change in NB unit
     /*!
       @param[in] _dv: 3-D array to record velocity change
@@ -1416,7 +1552,22 @@ public:
     int evolveStar(StarParameter& _star, StarParameterOut& _out, const double _dt, bool _unit_in_myr=false) {
         double tphysf = _dt*tscale + _star.tphys;
         if (_unit_in_myr) tphysf = _dt + _star.tphys;
+        // non-interacting single star on the table tracks
+        if (sse_table_flag && sse_table.evolve(_star, _out, tphysf)) return 0;
+        return evolveStarSSE(_star, _out, tphysf);
+    }
+
+    //! call SSE evolv1 for single star without using tables
+    /*!
+      @param[in,out] _star: star parameter
+      @param[out] _out: output parameter from evolv1
+      @param[in] _tphysf: finishing physical time [Myr]
+      \return event flag: -1: error, 0: normal, 1: type change, 2: velocity kick
+     */
+    int evolveStarSSE(StarParameter& _star, StarParameterOut& _out, double _tphysf) {
+        double tphysf = _tphysf;
         double dtp=tphysf*100.0+1000.0;
+        _out.dt_next = 0.0;
         _out.dm = _star.mt;
         _out.kw0 = _star.kw;
         int kw = _star.kw;
@@ -1711,6 +1862,17 @@ public:
         return std::min(dtr, dtm)/tscale;
     }
 
+    //! next time step for a single star, use the estimation from the last evolveStar if available
+    /*!
+      @param[in] _star: star parameter 
+      @param[in] _out: output parameter from the last evolveStar
+      \return next time step
+    */
+    double getTimeStepStar(StarParameter& _star, StarParameterOut& _out) {
+        if (_out.dt_next>0.0) return _out.dt_next/tscale;
+        else return getTimeStepStar(_star);
+    }
+
     //! call BSE evolv2 for a binary
     /*!
       @param[in] _star1: star parameter of first
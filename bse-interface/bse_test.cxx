@@ -4,6 +4,7 @@
 #include <cmath>
 #include <vector>
 #include <string>
+#include <chrono>
 #include "bse_interface.h"
 #include "../src/io.hpp"
 
@@ -47,6 +48,7 @@ int main(int argc, char** argv){
     std::string fhyb_name;
     bool read_mass_flag = false;
     bool always_output_flag = false;
+    bool sse_table_check_flag = false;
     std::string bse_prefix = BSEManager::getBSEOutputFilenameSuffix();
     std::string sse_prefix = BSEManager::getSSEOutputFilenameSuffix();
 
@@ -70,6 +72,7 @@ int main(int argc, char** argv){
                  <<"    -t [D]: finish time ("<<time<<") [IN]\n"
                  <<"        --mmin [D]: mimimum mass ("<<m_min<<") [M*]\n"
                  <<"        --mmax [D]: maximum mass ("<<m_max<<") [M*]\n"
+                 <<"        --sse-table-check: evolve single stars by SSE and compare the results of every step with SSE tables (--bse-sse-table)\n"
                  <<"    -d [D]: minimum time step to call SSE/BSE evolution functions ("<<dtmin<<")[IN]\n"
                  <<"    -s [S]: a file of single table: First line: number of single (unit:IN); After: mass, type, time per line\n"
                  <<"    -b [S]: a file of binary table: First line: number of binary (unit:IN); After: m1, m2, type1, type2, period, ecc, time per line\n"
@@ -91,6 +94,7 @@ int main(int argc, char** argv){
     static struct option long_options[] = {
         {"mmin", required_argument, &long_flag, 0},
         {"mmax", required_argument, &long_flag, 1},
+        {"sse-table-check", no_argument, &long_flag, 2},
         {0,0,0,0}
     };
 
@@ -112,6 +116,11 @@ int main(int argc, char** argv){
                 std::cout<<"max mass: "<<m_max<<std::endl;
                 opt_used+=2;
                 break;
+            case 2:
+                sse_table_check_flag = true;
+                std::cout<<"Check SSE tables"<<std::endl;
+                opt_used++;
+                break;
             default:
                 break;
             }
@@ -189,6 +198,12 @@ int main(int argc, char** argv){
     bse_manager.initial(bse_io,true);
     assert(bse_manager.checkParams());
 
+    if (sse_table_check_flag) {
+        if (!bse_manager.sse_table_flag) bse_manager.initialSSETable(bse_io.sse_table_prefix.value, true);
+        // evolve stars by SSE, tables are only used for comparison
+        bse_manager.sse_table_flag = false;
+    }
+
     // argc is 1 no input is given
     opt_used++;
     if (opt_used<argc) {
@@ -534,6 +549,14 @@ int main(int argc, char** argv){
 
         StarParameterOut output[star.size()];
 
+        // comparison with SSE tables: number of calls, number of calls using tables, maximum relative errors of mass, radius, luminosity and core mass, time of SSE and tables
+        const int n_check = 9;
+        std::vector<std::vector<double>> table_check(star.size(), std::vector<double>(n_check, 0.0));
+        auto relativeError = [](const double _a, const double _b) {
+            double abs_max = std::max(std::abs(_a), std::abs(_b));
+            return abs_max>0.0? std::abs(_a-_b)/abs_max: 0.0;
+        };
+
 #pragma omp parallel for schedule(dynamic)
         for (size_t i=0; i<star.size(); i++) {
             //int error_flag = bse_manager.evolveStar(star[i],output[i],time);
@@ -543,8 +566,29 @@ int main(int argc, char** argv){
                 double dt = std::max(bse_manager.getTimeStepStar(star[i]),dtmin);
                 dt = std::min(tend-bse_manager.getTime(star[i]), dt);
                 StarParameter star_bk = star[i];
+                auto t0 = std::chrono::steady_clock::now();
                 int event_flag=bse_manager.evolveStar(star[i],output[i],dt);
 
+                if (sse_table_check_flag) {
+                    auto t1 = std::chrono::steady_clock::now();
+                    StarParameter star_table = star_bk;
+                    StarParameterOut output_table;
+                    bool table_flag = bse_manager.sse_table.evolve(star_table, output_table, star_bk.tphys + dt*bse_manager.tscale);
+                    auto t2 = std::chrono::steady_clock::now();
+                    auto& check = table_check[i];
+                    check[0] += 1;
+                    if (table_flag) {
+                        check[1] += 1;
+                        check[2] = std::max(check[2], relativeError(star_table.mt, star[i].mt));
+                        check[3] = std::max(check[3], relativeError(star_table.r, star[i].r));
+                        check[4] = std::max(check[4], relativeError(star_table.lum, star[i].lum));
+                        check[5] = std::max(check[5], std::abs(star_table.mc - star[i].mc)/star[i].mt);
+                        if (star_table.kw!=star[i].kw) check[6] += 1;
+                        check[7] += std::chrono::duration<double>(t1-t0).count();
+                        check[8] += std::chrono::duration<double>(t2-t1).count();
+                    }
+                }
+
                 // error 
                 if (event_flag<0) {
                     std::cerr<<"SSE Error: ID= "<<i+1<<" mass0[IN]="<<mass0[i]<<" ";
@@ -597,6 +641,27 @@ int main(int argc, char** argv){
             printSingleColumn(std::cout, mass0[i], star[i], output[i]);
         }
 
+        if (sse_table_check_flag) {
+            std::vector<double> check_sum(n_check, 0.0);
+            for (size_t i=0; i<star.size(); i++) {
+                for (int k=0; k<n_check; k++) {
+                    if (k>=2&&k<=5) check_sum[k] = std::max(check_sum[k], table_check[i][k]);
+                    else check_sum[k] += table_check[i][k];
+                }
+            }
+            std::cout<<"SSE table check: calls: "<<check_sum[0]
+                     <<" table calls: "<<check_sum[1]
+                     <<" fraction: "<<(check_sum[0]>0? check_sum[1]/check_sum[0]: 0.0)
+                     <<"\n  maximum relative error: mass: "<<check_sum[2]
+                     <<" radius: "<<check_sum[3]
+                     <<" luminosity: "<<check_sum[4]
+                     <<" core mass/mass: "<<check_sum[5]
+                     <<"\n  type mismatch: "<<check_sum[6]
+                     <<" time of SSE[s]: "<<check_sum[7]
+                     <<" time of table[s]: "<<check_sum[8]
+                     <<std::endl;
+        }
+
         if (output_flag) {
             fout_sse_type.close();
             fout_sse_sn.close();
@@ -0,0 +1,340 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+/*!
+  Interpolation tables of single star evolution tracks.
+
+  The tables store the evolution tracks of single stars starting from zero-age main sequence (ZAMS) with a given metallicity,
+  sampled on a logarithmic grid of ZAMS mass. Each track is sampled by calling the SSE function (evolv1) with time steps
+  smaller than the ones estimated by SSE (trdot), until the star becomes a neutron star, black hole or massless remnant,
+  or the maximum time is reached. Thus the events with random kicks are not included in tables.
+
+  A star is evolved by the tables (SSETable::evolve) when:
+      1) the stellar type does not change between the current time and the finishing time;
+      2) the current state of the star is consistent with the tracks interpolated at the current time within a tolerance.
+  The condition 2) excludes the stars changed by binary evolution (mass transfer, mergers),
+  as well as stars that are not born at ZAMS at the beginning. For these stars, the SSE function should be called.
+  Once a star is evolved by the tables, its state is on the interpolated track and the following calls can continue to use the tables.
+ */
+
+//! one sample of a single star track
+struct SSETableEntry{
+    double tphys; ///> physical time [Myr]
+    double m0;    ///> Initial stellar mass in solar units
+    double mt;    ///> Current mass in solar units
+    double log_r; ///> logarithm of stellar radius in solar units
+    double mc;    ///> core mass in solar units
+    double rc;    ///> core radius in solar units
+    double ospin; ///> spin of star
+    double epoch; ///> starting time of one evolution phase
+    double log_lum; ///> logarithm of luminosity in solar units
+    double menv;  ///> mass of convective envelope
+    double renv;  ///> radius of convective envelope
+    double tm;    ///> Main sequence lifetime
+    double log_dt_next; ///> logarithm of next time step estimated by SSE (trdot) [Myr]
+    long long int kw; ///> stellar type
+
+    //! save star parameters
+    template <class Tstar, class Tout>
+    void set(const Tstar& _star, const Tout& _out, const double _dt_next) {
+        tphys = _star.tphys;
+        m0 = _star.m0;
+        mt = _star.mt;
+        log_r = std::log(_star.r);
+        mc = _star.mc;
+        rc = _star.rc;
+        ospin = _star.ospin;
+        epoch = _star.epoch;
+        log_lum = std::log(_star.lum);
+        menv = _out.menv;
+        renv = _out.renv;
+        tm = _out.tm;
+        log_dt_next = std::log(_dt_next);
+        kw = _star.kw;
+    }
+};
+
+//! SSE interpolation tables
+class SSETable{
+private:
+    std::vector<double> mass_zams_;    // ZAMS mass of tracks [Msun]
+    std::vector<int> track_offset_;   // offset of the first entry of each track, the last one is the total entry number
+    std::vector<SSETableEntry> entry_; // samples of all tracks
+
+    // linear interpolation
+    static double interp(const double _a, const double _b, const double _f) {
+        return _a + (_b - _a)*_f;
+    }
+
+    // interpolate all members except tphys and kw
+    static void interpEntry(SSETableEntry& _e, const SSETableEntry& _a, const SSETableEntry& _b, const double _f) {
+        _e.m0 = interp(_a.m0, _b.m0, _f);
+        _e.mt = interp(_a.mt, _b.mt, _f);
+        _e.log_r = interp(_a.log_r, _b.log_r, _f);
+        _e.mc = interp(_a.mc, _b.mc, _f);
+        _e.rc = interp(_a.rc, _b.rc, _f);
+        _e.ospin = interp(_a.ospin, _b.ospin, _f);
+        _e.epoch = interp(_a.epoch, _b.epoch, _f);
+        _e.log_lum = interp(_a.log_lum, _b.log_lum, _f);
+        _e.menv = interp(_a.menv, _b.menv, _f);
+        _e.renv = interp(_a.renv, _b.renv, _f);
+        _e.tm = interp(_a.tm, _b.tm, _f);
+        _e.log_dt_next = interp(_a.log_dt_next, _b.log_dt_next, _f);
+    }
+
+    //! get the state of one track at a given time
+    /*! @param[out] _e: interpolated state
+        @param[in] _i: track index
+        @param[in] _t: physical time [Myr]
+        \return true: the time is inside the track and the stellar type does not change in the sample interval
+     */
+    bool getTrackState(SSETableEntry& _e, const int _i, const double _t) const {
+        const SSETableEntry* first = &entry_[track_offset_[_i]];
+        const SSETableEntry* last = &entry_[track_offset_[_i+1]];
+        if (last-first<2) return false;
+        if (_t<first->tphys || _t>(last-1)->tphys) return false;
+        // first sample with tphys > _t
+        const SSETableEntry* upper = std::upper_bound(first, last, _t, [](const double _tt, const SSETableEntry& _ee) { return _tt<_ee.tphys; });
+        if (upper==last) upper--;
+        const SSETableEntry* lower = upper-1;
+        if (lower->kw!=upper->kw) return false;
+        const double f = (_t - lower->tphys)/(upper->tphys - lower->tphys);
+        interpEntry(_e, *lower, *upper, f);
+        _e.tphys = _t;
+        _e.kw = lower->kw;
+        return true;
+    }
+
+    // key for searching tracks: stellar type first, then mass; tracks ended before _t have the largest key
+    bool isKeyLess(const int _i, const double _t, const long long int _kw, const double _mt) const {
+        const SSETableEntry& last = entry_[track_offset_[_i+1]-1];
+        const SSETableEntry* first = &entry_[track_offset_[_i]];
+        if (_t>last.tphys || _t<first->tphys) return false;
+        const SSETableEntry* end = &entry_[track_offset_[_i+1]];
+        const SSETableEntry* upper = std::upper_bound(first, end, _t, [](const double _tt, const SSETableEntry& _ee) { return _tt<_ee.tphys; });
+        const SSETableEntry* lower = upper-1;
+        if (lower->kw!=_kw) return lower->kw<_kw;
+        if (upper==end) return lower->mt<=_mt;
+        const double f = (_t - lower->tphys)/(upper->tphys - lower->tphys);
+        return interp(lower->mt, upper->mt, f)<=_mt;
+    }
+
+    //! check whether two values are consistent within a relative tolerance
+    static bool isClose(const double _a, const double _b, const double _tol, const double _floor=0.0) {
+        return std::abs(_a - _b) <= _tol*std::max(std::abs(_a), std::abs(_b)) + _floor;
+    }
+
+    //! check whether two neighbor tracks are close enough for interpolation
+    bool isNeighborClose(const SSETableEntry& _e1, const SSETableEntry& _e2) const {
+        return (std::abs(_e1.log_r - _e2.log_r) <= diff_max && std::abs(_e1.log_lum - _e2.log_lum) <= diff_max);
+    }
+
+public:
+    double m_min;     ///> minimum ZAMS mass [Msun]
+    double m_max;     ///> maximum ZAMS mass [Msun]
+    int n_mass;       ///> number of tracks
+    double t_max;     ///> maximum physical time [Myr]
+    double dt_factor; ///> sample time step / time step estimated by SSE
+    double dt_min;    ///> minimum sample time step [Myr], SSE time step approaches zero at the end of one evolution phase
+    double tolerance; ///> relative tolerance to accept a star as on the tracks
+    double diff_max;  ///> maximum difference of logarithmic radius and luminosity between neighbor tracks for interpolation
+
+    SSETable(): mass_zams_(), track_offset_(), entry_(), m_min(0.08), m_max(150.0), n_mass(512), t_max(14000.0), dt_factor(0.25), dt_min(1e-4), tolerance(5e-3), diff_max(0.05) {}
+
+    //! build tables by evolving single stars
+    /*! The evolution function may use random numbers when supernovae occur, the caller should save and restore the random number generator.
+      @param[in] _evolve: function to evolve one star: int (Tstar& _star, Tout& _out, double _dt_myr), return event flag of BSEManager::evolveStar
+      @param[in] _step: function to estimate the next time step: double (Tstar& _star), return the time step in Myr
+     */
+    template <class Tstar, class Tout, class Tevolve, class Tstep>
+    void build(Tevolve _evolve, Tstep _step) {
+        assert(n_mass>1);
+        assert(m_max>m_min);
+        mass_zams_.resize(n_mass);
+        std::vector<std::vector<SSETableEntry>> track(n_mass);
+        const double dlogm = std::log(m_max/m_min)/(n_mass-1);
+        for (int i=0; i<n_mass; i++) mass_zams_[i] = m_min*std::exp(dlogm*i);
+
+#pragma omp parallel for schedule(dynamic)
+        for (int i=0; i<n_mass; i++) {
+            Tstar star;
+            Tout out;
+            star.initial(mass_zams_[i]);
+            // obtain ZAMS parameters
+            _evolve(star, out, 0.0);
+            track[i].emplace_back();
+            double dt_next = _step(star);
+            track[i].back().set(star, out, dt_next);
+            while (star.tphys<t_max) {
+                double dt = std::min(std::max(dt_factor*dt_next, dt_min), t_max - star.tphys);
+                if (dt<=0.0) break;
+                int event_flag = _evolve(star, out, dt);
+                // stop before remnants with kicks or errors
+                if (event_flag<0 || event_flag==2 || star.kw>=13 || out.dtmiss!=0.0) break;
+                dt_next = _step(star);
+                track[i].emplace_back();
+                track[i].back().set(star, out, dt_next);
+            }
+        }
+
+        track_offset_.resize(n_mass+1);
+        track_offset_[0] = 0;
+        for (int i=0; i<n_mass; i++) track_offset_[i+1] = track_offset_[i] + track[i].size();
+        entry_.resize(track_offset_[n_mass]);
+        for (int i=0; i<n_mass; i++) std::copy(track[i].begin(), track[i].end(), entry_.begin()+track_offset_[i]);
+    }
+
+    //! evolve one star by the tables
+    /*! @param[in,out] _star: star parameter
+        @param[out] _out: output parameter, same as the one from evolv1
+        @param[in] _tphysf: finishing physical time [Myr]
+        \return true: the star is evolved; false: the star cannot be evolved by the tables (not changed)
+     */
+    template <class Tstar, class Tout>
+    bool evolve(Tstar& _star, Tout& _out, const double _tphysf) const {
+        if (entry_.size()==0) return false;
+        if (_star.kw<0 || _star.kw>=13) return false;
+        const double t = _star.tphys;
+        if (t<0.0 || _tphysf>t_max || _tphysf<t) return false;
+
+        // find the pair of neighbor tracks by stellar type and mass at time t
+        int i_lo = 0, i_hi = n_mass;
+        while (i_lo<i_hi) {
+            int i_mid = (i_lo+i_hi)/2;
+            if (isKeyLess(i_mid, t, _star.kw, _star.mt)) i_lo = i_mid+1;
+            else i_hi = i_mid;
+        }
+        const int i2 = i_lo;
+        const int i1 = i2-1;
+        if (i1<0 || i2>=n_mass) return false;
+
+        // check current state
+        SSETableEntry e1, e2;
+        if (!getTrackState(e1, i1, t) || !getTrackState(e2, i2, t)) return false;
+        if (e1.kw!=_star.kw || e2.kw!=_star.kw) return false;
+        if (!(e1.mt<=_star.mt && _star.mt<=e2.mt && e1.mt<e2.mt)) return false;
+        if (!isNeighborClose(e1, e2)) return false;
+        const double w = (_star.mt - e1.mt)/(e2.mt - e1.mt);
+        SSETableEntry e;
+        interpEntry(e, e1, e2, w);
+        const double age = t - _star.epoch;
+        if (!isClose(e.m0, _star.m0, tolerance) ||
+            !isClose(std::exp(e.log_r), _star.r, tolerance) ||
+            !isClose(std::exp(e.log_lum), _star.lum, tolerance) ||
+            !isClose(e.mc, _star.mc, tolerance, tolerance*_star.mt) ||
+            !isClose(e.ospin, _star.ospin, tolerance) ||
+            !isClose(t-e.epoch, age, tolerance, 1e-10)) return false;
+
+        // get the final state
+        if (!getTrackState(e1, i1, _tphysf) || !getTrackState(e2, i2, _tphysf)) return false;
+        if (e1.kw!=_star.kw || e2.kw!=_star.kw) return false;
+        if (!isNeighborClose(e1, e2)) return false;
+        interpEntry(e, e1, e2, w);
+
+        _out.kw0 = _star.kw;
+        _out.dtmiss = 0.0;
+        _out.menv = e.menv;
+        _out.renv = e.renv;
+        _out.tm = e.tm;
+        for (int k=0; k<4; k++) _out.vkick[k] = 0.0;
+        _out.dm = e.mt - _star.mt;
+        _out.dt_next = std::exp(e.log_dt_next);
+
+        _star.m0 = e.m0;
+        _star.mt = e.mt;
+        _star.r = std::exp(e.log_r);
+        _star.mc = e.mc;
+        _star.rc = e.rc;
+        _star.ospin = e.ospin;
+        _star.epoch = e.epoch;
+        _star.lum = std::exp(e.log_lum);
+        _star.tphys = _tphysf;
+
+        return true;
+    }
+
+    //! get number of entries
+    size_t getEntryN() const {
+        return entry_.size();
+    }
+
+    //! write tables to a binary file
+    /*! @param[in] _fname: file name
+        @param[in] _key: key of BSE parameters
+     */
+    void writeBinary(const char* _fname, const unsigned long long int _key) const {
+        FILE* fp;
+        if( (fp = fopen(_fname,"wb")) == NULL) {
+            fprintf(stderr,"Error: Cannot open file %s.\n", _fname);
+            abort();
+        }
+        const char magic[8] = {'S','S','E','T','A','B','L','E'};
+        fwrite(magic, sizeof(char), 8, fp);
+        fwrite(&_key, sizeof(unsigned long long int), 1, fp);
+        fwrite(&n_mass, sizeof(int), 1, fp);
+        fwrite(mass_zams_.data(), sizeof(double), n_mass, fp);
+        fwrite(track_offset_.data(), sizeof(int), n_mass+1, fp);
+        fwrite(entry_.data(), sizeof(SSETableEntry), entry_.size(), fp);
+        fclose(fp);
+    }
+
+    //! read tables from a binary file
+    /*! @param[in] _fname: file name
+        @param[in] _key: key of BSE parameters
+        \return true: success; false: file not found or the key is different
+     */
+    bool readBinary(const char* _fname, const unsigned long long int _key) {
+        FILE* fp;
+        if( (fp = fopen(_fname,"rb")) == NULL) return false;
+        char magic[8];
+        unsigned long long int key;
+        int n;
+        size_t rcount = fread(magic, sizeof(char), 8, fp);
+        rcount += fread(&key, sizeof(unsigned long long int), 1, fp);
+        rcount += fread(&n, sizeof(int), 1, fp);
+        if (rcount<10 || strncmp(magic, "SSETABLE", 8)!=0 || key!=_key || n!=n_mass) {
+            fclose(fp);
+            return false;
+        }
+        mass_zams_.resize(n_mass);
+        track_offset_.resize(n_mass+1);
+        rcount = fread(mass_zams_.data(), sizeof(double), n_mass, fp);
+        rcount += fread(track_offset_.data(), sizeof(int), n_mass+1, fp);
+        entry_.resize(track_offset_[n_mass]);
+        rcount += fread(entry_.data(), sizeof(SSETableEntry), entry_.size(), fp);
+        fclose(fp);
+        if (rcount<size_t(2*n_mass+1)+entry_.size()) {
+            std::cerr<<"Error: SSE table reading fails! file: "<<_fname<<std::endl;
+            abort();
+        }
+        return true;
+    }
+
+    //! hash function (FNV-1a) to generate the key of parameters
+    static void hashKey(unsigned long long int& _key, const void* _data, const size_t _size) {
+        const unsigned char* p = (const unsigned char*)_data;
+        for (size_t i=0; i<_size; i++) {
+            _key ^= p[i];
+            _key *= 1099511628211ULL;
+        }
+    }
+
+    //! generate the key from table parameters, BSE parameters should be added by hashKey
+    unsigned long long int getKey() const {
+        unsigned long long int key = 14695981039346656037ULL;
+        hashKey(key, &m_min, sizeof(double));
+        hashKey(key, &m_max, sizeof(double));
+        hashKey(key, &n_mass, sizeof(int));
+        hashKey(key, &t_max, sizeof(double));
+        hashKey(key, &dt_factor, sizeof(double));
+        hashKey(key, &dt_min, sizeof(double));
+        hashKey(key, &diff_max, sizeof(double));
+        return key;
+    }
+};
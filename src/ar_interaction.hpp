@@ -8,8 +8,12 @@
 #include "Hermite/hermite_particle.h"
 #include "ar_perturber.hpp"
 #include "two_body_tide.hpp"
+#if (defined USE_SIMD) && (defined __AVX2__)
+#include <immintrin.h>
+#endif
 #ifdef BSE_BASE
 #include "bse_interface.h"
+#include "se_event_log.hpp"
 #endif
 
 //! AR interaction clas
@@ -18,6 +22,7 @@ public:
     typedef H4::ParticleH4<PtclHard> H4Ptcl;
     Float eps_sq; ///> softening parameter
     Float gravitational_constant;
+    bool fixed_n_kernel_flag; ///> use unrolled inner force kernels for groups with 3-5 members (runtime switch for benchmark, not saved)
 #ifdef STELLAR_EVOLUTION
     int stellar_evolution_option;
     bool stellar_evolution_write_flag;
@@ -27,18 +32,28 @@ public:
     TwoBodyTide tide;
     std::ofstream fout_sse; ///> log file for SSE event
     std::ofstream fout_bse; ///> log file for BSE event
+    SEEventLog sse_event; ///> per-thread SSE event records
+    SEEventLog bse_event; ///> per-thread BSE event records
 
-    ARInteraction(): eps_sq(Float(-1.0)), gravitational_constant(Float(-1.0)), 
+    ARInteraction(): eps_sq(Float(-1.0)), gravitational_constant(Float(-1.0)), fixed_n_kernel_flag(true), 
                      stellar_evolution_option(1), stellar_evolution_write_flag(true), time_interrupt_max(NUMERIC_FLOAT_MAX), 
-                     bse_manager(), fout_sse(), fout_bse() {}
+                     bse_manager(), fout_sse(), fout_bse(), sse_event(), bse_event() {}
 #else
-    ARInteraction(): eps_sq(Float(-1.0)), gravitational_constant(Float(-1.0)), 
+    ARInteraction(): eps_sq(Float(-1.0)), gravitational_constant(Float(-1.0)), fixed_n_kernel_flag(true), 
                      stellar_evolution_option(0), stellar_evolution_write_flag(true), time_interrupt_max(NUMERIC_FLOAT_MAX){}
 #endif
 #else
-    ARInteraction(): eps_sq(Float(-1.0)), gravitational_constant(Float(-1.0)) {}
+    ARInteraction(): eps_sq(Float(-1.0)), gravitational_constant(Float(-1.0)), fixed_n_kernel_flag(true) {}
 #endif
 
+#if (defined STELLAR_EVOLUTION) && (defined BSE_BASE)
+    //! write buffered SSE/BSE events of all threads to files, call outside parallel regions
+    void flushEventLog() {
+        sse_event.flush(fout_sse);
+        bse_event.flush(fout_bse);
+    }
+
+#endif
     //! (Necessary) check whether publicly initialized parameters are correctly set
     /*! \return true: all parmeters are correct. In this case no parameters, return true;
      */
@@ -51,6 +66,8 @@ public:
         ASSERT(stellar_evolution_option==0 || (stellar_evolution_option==1 && bse_manager.checkParams()) || (stellar_evolution_option==2 && bse_manager.checkParams() && tide.checkParams()));
         ASSERT(!stellar_evolution_write_flag||(stellar_evolution_write_flag&&fout_sse.is_open()));
         ASSERT(!stellar_evolution_write_flag||(stellar_evolution_write_flag&&fout_bse.is_open()));
+        ASSERT(!stellar_evolution_write_flag||(stellar_evolution_write_flag&&sse_event.isOpen()));
+        ASSERT(!stellar_evolution_write_flag||(stellar_evolution_write_flag&&bse_event.isOpen()));
 #endif
 #endif
         return true;
@@ -231,6 +248,196 @@ public:
         return gt_kick_inv;
     }
 
+    //! calculate inner member acceleration, potential and inverse time transformation function gradient and factor for kick (fixed member number)
+    /*! Same as calcInnerAccPotAndGTKickInv, but the member number is a compile-time constant (used for N=3,4,5).
+      Each pair is evaluated once instead of twice. The member data are copied to local arrays and the loops over the N(N-1)/2 pairs have constant trip counts,
+      so that they are fully unrolled by the compiler and the independent square roots and divisions of different pairs overlap in the pipeline.
+      @param[out] _force: force array to store the calculation results (in acc_in[3] for acceleration and gtgrad[3] for gradient, acc/gtgrad are overwritten)
+      @param[out] _epot: total inner potential energy
+      @param[in] _particles: member particle array with N members
+      \return the inverse time transformation factor (gt_kick_inv) for kick step
+    */
+    template <int N>
+    inline Float calcInnerAccPotAndGTKickInvFixedN(AR::Force* _force, Float& _epot, const PtclHard* _particles) {
+        constexpr int n_pair = N*(N-1)/2;
+
+        Float x[N], y[N], z[N], mass[N], gm[N];
+        for (int i=0; i<N; i++) {
+            x[i] = _particles[i].pos.x;
+            y[i] = _particles[i].pos.y;
+            z[i] = _particles[i].pos.z;
+            mass[i] = _particles[i].mass;
+            gm[i] = gravitational_constant*mass[i];
+        }
+
+        // separations and pair factors of all pairs (i<j): G/r^3 for acceleration and G/r for potential
+        Float dx[n_pair], dy[n_pair], dz[n_pair], gor3[n_pair], gor[n_pair];
+        int k = 0;
+        for (int i=0; i<N; i++) {
+            for (int j=i+1; j<N; j++) {
+                dx[k] = x[j] - x[i];
+                dy[k] = y[j] - y[i];
+                dz[k] = z[j] - z[i];
+                Float r2 = dx[k]*dx[k] + dy[k]*dy[k] + dz[k]*dz[k];
+                Float inv_r = 1.0/sqrt(r2);
+#ifdef AR_CHANGEOVER
+                Float r = r2*inv_r;
+                const Float kpot  = ChangeOver::calcPotWTwo(_particles[i].changeover, _particles[j].changeover, r);
+                const Float kacc  = ChangeOver::calcAcc0WTwo(_particles[i].changeover, _particles[j].changeover, r);
+                gor3[k] = inv_r*inv_r*inv_r*kacc;
+                gor[k]  = inv_r*kpot;
+#else
+                gor3[k] = inv_r*inv_r*inv_r;
+                gor[k]  = inv_r;
+#endif
+                k++;
+            }
+        }
+
+        Float acc[N][3];
+#ifdef AR_TTL
+        Float gtgrad[N][3];
+#endif
+        for (int i=0; i<N; i++) {
+            acc[i][0] = acc[i][1] = acc[i][2] = Float(0.0);
+#ifdef AR_TTL
+            gtgrad[i][0] = gtgrad[i][1] = gtgrad[i][2] = Float(0.0);
+#endif
+        }
+
+        Float gt_kick_inv = Float(0.0);
+        k = 0;
+        for (int i=0; i<N; i++) {
+            for (int j=i+1; j<N; j++) {
+                Float gmjor3 = gm[j]*gor3[k];
+                Float gmior3 = gm[i]*gor3[k];
+                acc[i][0] += gmjor3 * dx[k];
+                acc[i][1] += gmjor3 * dy[k];
+                acc[i][2] += gmjor3 * dz[k];
+                acc[j][0] -= gmior3 * dx[k];
+                acc[j][1] -= gmior3 * dy[k];
+                acc[j][2] -= gmior3 * dz[k];
+#ifdef AR_TTL
+                Float gmimjor3 = mass[i]*gmjor3;
+                gtgrad[i][0] += gmimjor3 * dx[k];
+                gtgrad[i][1] += gmimjor3 * dy[k];
+                gtgrad[i][2] += gmimjor3 * dz[k];
+                gtgrad[j][0] -= gmimjor3 * dx[k];
+                gtgrad[j][1] -= gmimjor3 * dy[k];
+                gtgrad[j][2] -= gmimjor3 * dz[k];
+#endif
+                gt_kick_inv += mass[i]*mass[j]*gor[k];
+                k++;
+            }
+        }
+
+        for (int i=0; i<N; i++) {
+            Float* acci = _force[i].acc_in;
+            acci[0] = acc[i][0];
+            acci[1] = acc[i][1];
+            acci[2] = acc[i][2];
+#ifdef AR_TTL
+            Float* gtgradi = _force[i].gtgrad;
+            gtgradi[0] = gtgrad[i][0];
+            gtgradi[1] = gtgrad[i][1];
+            gtgradi[2] = gtgrad[i][2];
+#endif
+        }
+
+        gt_kick_inv *= gravitational_constant;
+        _epot = - gt_kick_inv;
+
+        return gt_kick_inv;
+    }
+
+    //! calculate G m/r^3 with changeover weight of single perturbers for one member
+    /*! The changeover with the larger r_out is selected as in ChangeOver::calcAcc0WTwo.
+      Perturber data are in SoA layout. With USE_SIMD and AVX2, four perturbers are evaluated in one step.
+      @param[out] _gmor3: G m_j/r^3 * W(r) of each perturber
+      @param[in] _xi: member position
+      @param[in] _chi: member changeover
+      @param[in] _xp, _yp, _zp: perturber positions
+      @param[in] _m: perturber masses
+      @param[in] _r_in_p, _r_out_p, _norm_p, _coff_p: changeover parameters of perturbers
+      @param[in] _n_pert: number of single perturbers
+     */
+    void calcGMOR3SinglePert(Float* _gmor3, const Float* _xi, const ChangeOver& _chi,
+                             const Float* _xp, const Float* _yp, const Float* _zp, const Float* _m,
+                             const Float* _r_in_p, const Float* _r_out_p, const Float* _norm_p, const Float* _coff_p, const int _n_pert) const {
+        const Float r_in_i = _chi.getRin();
+        const Float r_out_i = _chi.getRout();
+        const Float norm_i = _chi.getNorm();
+        const Float coff_i = _chi.getCoff();
+        int j_start = 0;
+#if (defined USE_SIMD) && (defined __AVX2__)
+        const __m256d xi = _mm256_set1_pd(_xi[0]);
+        const __m256d yi = _mm256_set1_pd(_xi[1]);
+        const __m256d zi = _mm256_set1_pd(_xi[2]);
+        const __m256d eps2 = _mm256_set1_pd(eps_sq);
+        const __m256d g = _mm256_set1_pd(gravitational_constant);
+        const __m256d rini = _mm256_set1_pd(r_in_i);
+        const __m256d routi = _mm256_set1_pd(r_out_i);
+        const __m256d normi = _mm256_set1_pd(norm_i);
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d one = _mm256_set1_pd(1.0);
+#ifndef INTEGRATED_CUTOFF_FUNCTION
+        const __m256d coffi = _mm256_set1_pd(coff_i);
+#endif
+        for (; j_start+4<=_n_pert; j_start+=4) {
+            const int j = j_start;
+            __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(_xp+j), xi);
+            __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(_yp+j), yi);
+            __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(_zp+j), zi);
+            __m256d r2 = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx,dx), _mm256_mul_pd(dy,dy)), _mm256_mul_pd(dz,dz)), eps2);
+            __m256d r  = _mm256_sqrt_pd(r2);
+
+            // select the changeover with the larger r_out
+            __m256d i_mask = _mm256_cmp_pd(routi, _mm256_loadu_pd(_r_out_p+j), _CMP_GT_OQ);
+            __m256d rin  = _mm256_blendv_pd(_mm256_loadu_pd(_r_in_p+j), rini, i_mask);
+            __m256d norm = _mm256_blendv_pd(_mm256_loadu_pd(_norm_p+j), normi, i_mask);
+            __m256d x = _mm256_mul_pd(_mm256_sub_pd(r, rin), norm);
+            x = _mm256_min_pd(x, one);
+            x = _mm256_max_pd(x, zero);
+            __m256d x2 = _mm256_mul_pd(x, x);
+            __m256d x4 = _mm256_mul_pd(x2, x2);
+#ifdef INTEGRATED_CUTOFF_FUNCTION
+            // k = 1-(((-20.0*x+70.0)*x-84.0)*x+35.0)*x4
+            __m256d p = _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(-20.0), x), _mm256_set1_pd(70.0));
+            p = _mm256_sub_pd(_mm256_mul_pd(p, x), _mm256_set1_pd(84.0));
+            p = _mm256_add_pd(_mm256_mul_pd(p, x), _mm256_set1_pd(35.0));
+            __m256d k = _mm256_sub_pd(one, _mm256_mul_pd(p, x4));
+#else
+            // k = (x-1)^4*(1.0 + 4.0*x + 10.0*x2 + 20.0*x3 + 35.0*coff*x4)
+            __m256d coff = _mm256_blendv_pd(_mm256_loadu_pd(_coff_p+j), coffi, i_mask);
+            __m256d x_1 = _mm256_sub_pd(x, one);
+            __m256d x_2 = _mm256_mul_pd(x_1, x_1);
+            __m256d x_4 = _mm256_mul_pd(x_2, x_2);
+            __m256d x3 = _mm256_mul_pd(x2, x);
+            __m256d p = _mm256_add_pd(one, _mm256_mul_pd(_mm256_set1_pd(4.0), x));
+            p = _mm256_add_pd(p, _mm256_mul_pd(_mm256_set1_pd(10.0), x2));
+            p = _mm256_add_pd(p, _mm256_mul_pd(_mm256_set1_pd(20.0), x3));
+            p = _mm256_add_pd(p, _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(35.0), coff), x4));
+            __m256d k = _mm256_mul_pd(x_4, p);
+#endif
+            __m256d r3 = _mm256_mul_pd(r, r2);
+            __m256d gm = _mm256_mul_pd(g, _mm256_loadu_pd(_m+j));
+            _mm256_storeu_pd(_gmor3+j, _mm256_mul_pd(_mm256_div_pd(gm, r3), k));
+        }
+#endif
+        for (int j=j_start; j<_n_pert; j++) {
+            Float dr[3] = {_xp[j] - _xi[0],
+                           _yp[j] - _xi[1],
+                           _zp[j] - _xi[2]};
+            Float r2 = dr[0]*dr[0] + dr[1]*dr[1] + dr[2]*dr[2] + eps_sq;
+            Float r  = sqrt(r2);
+            bool i_flag = r_out_i > _r_out_p[j];
+            Float k  = ChangeOver::calcAcc0WPar(r, i_flag? r_in_i: _r_in_p[j], i_flag? norm_i: _norm_p[j], i_flag? coff_i: _coff_p[j]);
+            Float r3 = r*r2;
+            Float gm = gravitational_constant*_m[j];
+            _gmor3[j] = gm/r3 * k;
+        }
+    }
+
     //! (Necessary) calculate acceleration from perturber and the perturbation factor for slowdown calculation
     /*!@param[out] _force: force array to store the calculation results (in acc_pert[3], notice acc_pert may need to reset zero to avoid accummulating old values)
       @param[in] _particles: member particle array
@@ -253,8 +460,10 @@ public:
 
             auto* pert_adr = _perturber.neighbor_address.getDataAddress();
 
-            Float xp[n_pert][3], xcm[3], m[n_pert];
-            ChangeOver* changeover[n_pert_single];
+            // predicted perturber data in SoA layout, singles first, then groups
+            Float xp[n_pert], yp[n_pert], zp[n_pert], m[n_pert], xcm[3];
+            // changeover parameters of single perturbers
+            Float r_in_p[n_pert_single], r_out_p[n_pert_single], norm_p[n_pert_single], coff_p[n_pert_single];
             H4::NBAdr<PtclHard>::Group* ptclgroup[n_pert_group];
 
             int n_single_count=0;
@@ -271,16 +480,19 @@ public:
                 else {
                     pertj = (H4::NBAdr<PtclHard>::Single*)pert_adr[j].adr;
                     k = n_single_count;
-                    changeover[n_single_count] = &pertj->changeover;
+                    auto& chj = pertj->changeover;
+                    r_in_p[k]  = chj.getRin();
+                    r_out_p[k] = chj.getRout();
+                    norm_p[k]  = chj.getNorm();
+                    coff_p[k]  = chj.getCoff();
                     n_single_count++;
                 }
 
                 Float dt = time - pertj->time;
                 //ASSERT(dt>=-1e-7);
-                xp[k][0] = pertj->pos[0] + dt*(pertj->vel[0] + 0.5*dt*(pertj->acc0[0] + inv3*dt*pertj->acc1[0]));
-                xp[k][1] = pertj->pos[1] + dt*(pertj->vel[1] + 0.5*dt*(pertj->acc0[1] + inv3*dt*pertj->acc1[1]));
-                xp[k][2] = pertj->pos[2] + dt*(pertj->vel[2] + 0.5*dt*(pertj->acc0[2] + inv3*dt*pertj->acc1[2]));
-
+                xp[k] = pertj->pos[0] + dt*(pertj->vel[0] + 0.5*dt*(pertj->acc0[0] + inv3*dt*pertj->acc1[0]));
+                yp[k] = pertj->pos[1] + dt*(pertj->vel[1] + 0.5*dt*(pertj->acc0[1] + inv3*dt*pertj->acc1[1]));
+                zp[k] = pertj->pos[2] + dt*(pertj->vel[2] + 0.5*dt*(pertj->acc0[2] + inv3*dt*pertj->acc1[2]));
 
                 m[k] = pertj->mass;
             }
@@ -293,6 +505,8 @@ public:
             xcm[1] = _particle_cm.pos[1] + dt*(_particle_cm.vel[1] + 0.5*dt*(_particle_cm.acc0[1] + inv3*dt*_particle_cm.acc1[1]));
             xcm[2] = _particle_cm.pos[2] + dt*(_particle_cm.vel[2] + 0.5*dt*(_particle_cm.acc0[2] + inv3*dt*_particle_cm.acc1[2]));
 
+            // G m/r^3 * changeover weight of each perturber for one member
+            Float gmor3[n_pert];
 
             Float acc_pert_cm[3]={0.0, 0.0, 0.0};
             Float mcm = 0.0;
@@ -312,27 +526,12 @@ public:
                 xi[2] = pi.pos[2] + xcm[2];
 
                 // single perturber
-                for (int j=0; j<n_pert_single; j++) {
-                    Float dr[3] = {xp[j][0] - xi[0],
-                                   xp[j][1] - xi[1],
-                                   xp[j][2] - xi[2]};
-                    Float r2 = dr[0]*dr[0] + dr[1]*dr[1] + dr[2]*dr[2] + eps_sq;
-                    Float r  = sqrt(r2);
-                    Float k  = ChangeOver::calcAcc0WTwo(chi, *changeover[j], r);
-                    Float r3 = r*r2;
-                    Float gm = gravitational_constant*m[j];
-                    Float gmor3 = gm/r3 * k;
-
-                    acc_pert[0] += gmor3 * dr[0];
-                    acc_pert[1] += gmor3 * dr[1];
-                    acc_pert[2] += gmor3 * dr[2];
-
-                }
+                calcGMOR3SinglePert(gmor3, xi, chi, xp, yp, zp, m, r_in_p, r_out_p, norm_p, coff_p, n_pert_single);
                 // group perturber
                 for (int j=n_pert_single; j<n_pert; j++) {
-                    Float dr[3] = {xp[j][0] - xi[0],
-                                   xp[j][1] - xi[1],
-                                   xp[j][2] - xi[2]};
+                    Float dr[3] = {xp[j] - xi[0],
+                                   yp[j] - xi[1],
+                                   zp[j] - xi[2]};
                     Float r2 = dr[0]*dr[0] + dr[1]*dr[1] + dr[2]*dr[2] + eps_sq;
                     Float r  = sqrt(r2);
                     const int jk = j-n_pert_single;
@@ -342,12 +541,14 @@ public:
                         mk += ptcl_mem[k].mass * ChangeOver::calcAcc0WTwo(chi, ptcl_mem[k].changeover, r);
                     }
                     Float r3 = r*r2;
-                    Float gmor3 = gravitational_constant*mk/r3;
-
-                    acc_pert[0] += gmor3 * dr[0];
-                    acc_pert[1] += gmor3 * dr[1];
-                    acc_pert[2] += gmor3 * dr[2];
+                    gmor3[j] = gravitational_constant*mk/r3;
+                }
 
+                // sum in the original perturber order
+                for (int j=0; j<n_pert; j++) {
+                    acc_pert[0] += gmor3[j] * (xp[j] - xi[0]);
+                    acc_pert[1] += gmor3[j] * (yp[j] - xi[1]);
+                    acc_pert[2] += gmor3[j] * (zp[j] - xi[2]);
                 }
 
                 acc_pert_cm[0] += pi.mass *acc_pert[0];
@@ -423,6 +624,21 @@ public:
         // inner force
         Float gt_kick_inv;
         if (_n_particle==2) gt_kick_inv = calcInnerAccPotAndGTKickInvTwo(_force[0], _force[1], _epot, _particles[0], _particles[1]);
+        else if (fixed_n_kernel_flag) {
+            switch (_n_particle) {
+            case 3:
+                gt_kick_inv = calcInnerAccPotAndGTKickInvFixedN<3>(_force, _epot, _particles);
+                break;
+            case 4:
+                gt_kick_inv = calcInnerAccPotAndGTKickInvFixedN<4>(_force, _epot, _particles);
+                break;
+            case 5:
+                gt_kick_inv = calcInnerAccPotAndGTKickInvFixedN<5>(_force, _epot, _particles);
+                break;
+            default:
+                gt_kick_inv = calcInnerAccPotAndGTKickInv(_force, _epot, _particles, _n_particle);
+            }
+        }
         else gt_kick_inv = calcInnerAccPotAndGTKickInv(_force, _epot, _particles, _n_particle);
 
         calcAccPert(_force, _particles, _n_particle, _particle_cm, _perturber, _time);
@@ -663,7 +879,7 @@ public:
             _p.time_record += dt-dt_miss;
 
             // estimate next time to check 
-            _p.time_interrupt = std::min(_p.time_record + bse_manager.getTimeStepStar(_p.star), time_interrupt_max);
+            _p.time_interrupt = std::min(_p.time_record + bse_manager.getTimeStepStar(_p.star, output), time_interrupt_max);
 
             // record mass change (if loss, negative)
             double dm = bse_manager.getMassLoss(output);
@@ -678,16 +894,11 @@ public:
 
             // type change
             if (stellar_evolution_write_flag&&event_flag>=1) {
-#pragma omp critical
-                {
-                    fout_sse<<"Type_change ";
-                    //bse_manager.printTypeChange(fout_sse, _p.star, output);
-                    fout_sse<<std::setw(WRITE_WIDTH)<<_p.id;
-                    star_bk.printColumn(fout_sse, WRITE_WIDTH);
-                    _p.star.printColumn(fout_sse, WRITE_WIDTH);
-                    //output.printColumn(fout_sse, WRITE_WIDTH);
-                    fout_sse<<std::endl;
-                }
+                auto& record = sse_event.createRecord();
+                record.setLabel("Type_change ");
+                record.add(_p.id);
+                star_bk.recordColumn(record);
+                _p.star.recordColumn(record);
             }
 
             // add velocity change if exist
@@ -698,14 +909,11 @@ public:
                 for (int k=0; k<3; k++) _p.vel[k] += dv[k];
                 modify_flag = 2;
                 if (stellar_evolution_write_flag) {
-#pragma omp critical
-                    {
-                        fout_sse<<"SN_kick "
-                                <<std::setw(WRITE_WIDTH)<<_p.id
-                                <<std::setw(WRITE_WIDTH)<<dvabs*bse_manager.vscale;
-                        _p.star.printColumn(fout_sse, WRITE_WIDTH);
-                        fout_sse<<std::endl;
-                    }
+                    auto& record = sse_event.createRecord();
+                    record.setLabel("SN_kick ");
+                    record.add(_p.id);
+                    record.add(dvabs*bse_manager.vscale);
+                    _p.star.recordColumn(record);
                 }
             }
             // if mass become zero, set to unused for removing
@@ -860,15 +1068,14 @@ public:
                         dv[3] = bse_manager.getVelocityChange(dv,out[k]);
                         if (dv[3]>0) {
                             kick_flag=true;
-#pragma omp critical 
-                            {
-                                fout_bse<<"SN_kick "
-                                        <<std::setw(WRITE_WIDTH)<<p1->id
-                                        <<std::setw(WRITE_WIDTH)<<p2->id
-                                        <<std::setw(WRITE_WIDTH)<<k+1
-                                        <<std::setw(WRITE_WIDTH)<<dv[3]*bse_manager.vscale;
-                                pk->star.printColumn(fout_bse, WRITE_WIDTH);
-                                fout_bse<<std::endl;
+                            if (stellar_evolution_write_flag) {
+                                auto& record = bse_event.createRecord();
+                                record.setLabel("SN_kick ");
+                                record.add(p1->id);
+                                record.add(p2->id);
+                                record.add(k+1);
+                                record.add(dv[3]*bse_manager.vscale);
+                                pk->star.recordColumn(record);
                             }
                             for (int k=0; k<3; k++) pk->vel[k] += dv[k];
                         }
@@ -1025,15 +1232,12 @@ public:
                             if (stellar_evolution_write_flag) {
                                 if ((first_event&&binary_type_init!=binary_type)||!first_event) {
                                     //if (!(binary_type_init==11&&(binary_type==3||binary_type==11))) {// avoid repeating printing Start Roche and BSS
-#pragma omp critical
-                                    {
-                                        bse_manager.printBinaryEventColumnOne(fout_bse, bin_event, i, WRITE_WIDTH);
-                                        fout_bse<<std::setw(WRITE_WIDTH)<<p1->id
-                                                <<std::setw(WRITE_WIDTH)<<p2->id
-                                                <<std::setw(WRITE_WIDTH)<<drdv*bse_manager.rscale*bse_manager.vscale
-                                                <<std::setw(WRITE_WIDTH)<<_bin.r*bse_manager.rscale;
-                                        fout_bse<<std::endl;
-                                    }
+                                    auto& record = bse_event.createRecord();
+                                    bse_manager.recordBinaryEventColumnOne(record, bin_event, i);
+                                    record.add(p1->id);
+                                    record.add(p2->id);
+                                    record.add(drdv*bse_manager.rscale*bse_manager.vscale);
+                                    record.add(_bin.r*bse_manager.rscale);
                                 }
                             }
                             //if (binary_type==10) {
@@ -1108,29 +1312,28 @@ public:
 
                         postProcess(out, pos_cm, vel_cm, semi, ecc, 0);
                         if (stellar_evolution_write_flag&&(p1->mass==0.0||p2->mass==0.0)) {
-#pragma omp critical
-                            {
-                                fout_bse<<"Dynamic_merge: "
-                                        <<std::setw(WRITE_WIDTH)<<p1->id
-                                        <<std::setw(WRITE_WIDTH)<<p2->id
-                                        <<std::setw(WRITE_WIDTH)<<_bin.period*bse_manager.tscale*bse_manager.year_to_day
-                                        <<std::setw(WRITE_WIDTH)<<_bin.semi*bse_manager.rscale
-                                        <<std::setw(WRITE_WIDTH)<<_bin.ecc;
+                            auto& record = bse_event.createRecord();
+                            record.setLabel("Dynamic_merge: ");
+                            record.add(p1->id);
+                            record.add(p2->id);
+                            record.add(_bin.period*bse_manager.tscale*bse_manager.year_to_day);
+                            record.add(_bin.semi*bse_manager.rscale);
+                            record.add(_bin.ecc);
 #ifndef DYNAMIC_MERGER_LESS_OUTPUT
-                                fout_bse<<std::setw(WRITE_WIDTH)<<dr*bse_manager.rscale
-                                        <<std::setw(WRITE_WIDTH)<<t_peri*bse_manager.tscale*bse_manager.year_to_day
-                                        <<std::setw(WRITE_WIDTH)<<sd_factor;
+                            record.add(dr*bse_manager.rscale);
+                            record.add(t_peri*bse_manager.tscale*bse_manager.year_to_day);
+                            record.add(sd_factor);
 #endif
-                                // before
-                                p1_star_bk.printColumn(fout_bse, WRITE_WIDTH);
-                                p2_star_bk.printColumn(fout_bse, WRITE_WIDTH);
-                                // after
-                                p1->star.printColumn(fout_bse, WRITE_WIDTH);
-                                p2->star.printColumn(fout_bse, WRITE_WIDTH);
-                                fout_bse<<std::endl;
+                            // before
+                            p1_star_bk.recordColumn(record);
+                            p2_star_bk.recordColumn(record);
+                            // after
+                            p1->star.recordColumn(record);
+                            p2->star.recordColumn(record);
 
+#pragma omp critical
+                            {
                                 DATADUMP("dump_merger");
-                                
                             }
                         }
                     }
@@ -1325,8 +1528,9 @@ public:
                             
                                 modify_return = 2;
 
-#pragma omp critical
-                                {
+                                // the slowdown binary columns are defined in SDAR, thus use text in the buffer of the thread
+                                if (stellar_evolution_write_flag) {
+                                    std::ostream& fout_bse = bse_event.getTextBuffer();
                                     fout_bse<<"Tide "
                                             <<std::setw(WRITE_WIDTH)<<_bin_interrupt.time_now
                                             <<std::setw(WRITE_WIDTH)<<p1->id
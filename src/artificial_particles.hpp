@@ -272,12 +272,14 @@ public:
       @param[in]     _bin: binary tree root
       @param[in]     _data_to_store: array of data to be stored in the status of artificial particles
       @param[in]     _n_data: number of data
+      @param[in]     _orbit_sample_flag: if false, orbital sample particles are not generated and should be set by the caller (e.g. from a group record)
     */
     template <class Tptcl>
     void createArtificialParticles(Tptcl* _ptcl_artificial,
                                    COMM::BinaryTree<Tptcl,COMM::Binary> &_bin, 
                                    const PS::F64* _data_to_store,
-                                   const PS::S32 _n_data) {
+                                   const PS::S32 _n_data,
+                                   const bool _orbit_sample_flag=true) {
         ASSERT(checkParams());
         // set id and status.d except cm particle
         PS::S32 n_artificial = getArtificialParticleN();
@@ -299,7 +301,7 @@ public:
         TidalTensor::createTidalTensorMeasureParticles(_ptcl_artificial, *((Tptcl*)&_bin), r_tidal_tensor);
 
         // remaining is for orbital sample particles
-        orbit_manager.createSampleParticles(&(_ptcl_artificial[getIndexOffsetOrb()]), _bin);
+        if (_orbit_sample_flag) orbit_manager.createSampleParticles(&(_ptcl_artificial[getIndexOffsetOrb()]), _bin);
         
         // store the component member number 
         for (int j=0; j<2; j++) {
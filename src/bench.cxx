@@ -0,0 +1,322 @@
+#include <sys/resource.h>
+#include "petar.hpp"
+
+//! options of the benchmark, other options are passed to PeTar
+struct BenchParams{
+    PS::S64 n_step;     // number of tree steps to measure
+    PS::S64 n_warmup;   // number of tree steps before measurement
+    PS::F64 fbin;       // fraction of stars in binaries
+    PS::F64 semi_min;   // minimum semi-major axis of binaries
+    PS::F64 semi_max;   // maximum semi-major axis of binaries
+    PS::S32 seed;       // random seed of initial condition
+    std::string fname_json; // output JSON file
+
+    BenchParams(): n_step(64), n_warmup(4), fbin(0.0), semi_min(1e-5), semi_max(1e-3), seed(0), fname_json() {}
+
+    void printHelp(std::ostream& fout) const {
+        fout<<"petar.bench: reproducible benchmark of PeTar\n"
+            <<"The initial condition is a Plummer model (Henon unit) generated with a fixed random seed,\n"
+            <<"the system is integrated for a fixed number of tree steps and the timing report is written in JSON format.\n"
+            <<"Usage: petar.bench [benchmark options] [PeTar options]\n"
+            <<"Benchmark options:\n"
+            <<"  --bench-step     [int]:    number of tree steps to measure ("<<n_step<<")\n"
+            <<"  --bench-warmup   [int]:    number of tree steps before measurement ("<<n_warmup<<")\n"
+            <<"  --bench-fbin     [double]: fraction of stars in primordial binaries ("<<fbin<<")\n"
+            <<"  --bench-semi-min [double]: minimum semi-major axis of binaries, log-uniform distribution ("<<semi_min<<")\n"
+            <<"  --bench-semi-max [double]: maximum semi-major axis of binaries ("<<semi_max<<")\n"
+            <<"  --bench-seed     [int]:    random seed ("<<seed<<")\n"
+            <<"  --bench-output   [string]: JSON output file (default: [data filename prefix].bench.json)\n"
+            <<"  --bench-help:              print this help\n"
+            <<"PeTar options (e.g. -n, -t, -s, -o, -r, galpy options; see petar -h) are used as usual, except that the input data file is ignored.\n";
+    }
+
+    //! read benchmark options (--bench-*) and remove them from the argument list
+    /*! getopt is not used because it reorders the arguments which are later read by PeTar
+      \return -1 if help is used, 1 if an error is found, 0 otherwise
+     */
+    int read(int& argc, char** argv) {
+        int n_arg = 1;
+        for (int i=1; i<argc; i++) {
+            std::string arg(argv[i]);
+            if (arg.compare(0,8,"--bench-")!=0) {
+                argv[n_arg++] = argv[i];
+                continue;
+            }
+            std::string key = arg.substr(8);
+            std::string value;
+            std::size_t ieq = key.find('=');
+            if (key=="help") return -1;
+            if (ieq!=std::string::npos) {
+                value = key.substr(ieq+1);
+                key = key.substr(0,ieq);
+            }
+            else if (i+1<argc) value = argv[++i];
+            else {
+                std::cerr<<"Error: no value for option "<<arg<<std::endl;
+                return 1;
+            }
+            if      (key=="step")     n_step   = atol(value.c_str());
+            else if (key=="warmup")   n_warmup = atol(value.c_str());
+            else if (key=="fbin")     fbin     = atof(value.c_str());
+            else if (key=="semi-min") semi_min = atof(value.c_str());
+            else if (key=="semi-max") semi_max = atof(value.c_str());
+            else if (key=="seed")     seed     = atoi(value.c_str());
+            else if (key=="output")   fname_json = value;
+            else {
+                std::cerr<<"Error: unknown option "<<arg<<std::endl;
+                return 1;
+            }
+        }
+        argc = n_arg;
+        argv[argc] = NULL;
+        if (n_step<=0||n_warmup<0||fbin<0.0||fbin>1.0||semi_min<=0.0||semi_max<semi_min) {
+            std::cerr<<"Error: invalid benchmark options, check --bench-help\n";
+            return 1;
+        }
+        return 0;
+    }
+};
+
+//! integrate for a given number of tree steps
+void integrateSteps(PeTar& _petar, const PS::S64 _n_step) {
+    auto& inp = _petar.input_parameters;
+    PS::F64 time_break = _petar.stat.time + _n_step*inp.dt_soft.value;
+    inp.time_end.value = time_break;
+    // avoid snapshot output during the benchmark
+    PS::F64 dt_snap = inp.dt_soft.value;
+    while (dt_snap<=time_break) dt_snap *= 2.0;
+    inp.dt_snap.value = dt_snap;
+
+    int n_interupt = 1;
+    while(n_interupt>0) n_interupt = _petar.integrateToTime(time_break);
+}
+
+//! get name of a profile item without padding spaces
+std::string trimName(const char* _name) {
+    std::string name(_name);
+    name.erase(name.find_last_not_of(' ')+1);
+    return name;
+}
+
+//! write a key of JSON object
+void writeKey(std::ostream& _fout, const std::string& _key, const int _indent) {
+    _fout<<std::string(_indent,' ')<<"\""<<_key<<"\": ";
+}
+
+//! write JSON report
+/*! Times are the average per tree step of rank 0 (time) and the maximum of all ranks without barrier waiting time (time_max).
+ */
+void writeReport(std::ostream& _fout, PeTar& _petar, const SysProfile& _profile_max, const BenchParams& _bench, const PS::F64 _wtime, const PS::F64 _mem_max, const PS::F64 _mem_sum) {
+    auto& inp = _petar.input_parameters;
+    const PS::S64 n_loop = std::max(PS::S32(1), _petar.dn_loop);
+    const PS::S64 n_hard_step = _petar.n_count_sum.ARC_substep_sum.n + _petar.n_count_sum.H4_step_sum.n;
+
+    _fout<<std::setprecision(8);
+    _fout<<"{\n";
+    writeKey(_fout, "version", 2);
+    _fout<<"\""<<GetVersion()<<"\",\n";
+
+    writeKey(_fout, "build", 2);
+    _fout<<"{\n";
+    // enabled compile flags
+    std::vector<std::string> flags;
+#ifdef USE_SIMD
+    flags.push_back("USE_SIMD");
+#endif
+#ifdef USE_QUAD
+    flags.push_back("USE_QUAD");
+#endif
+#ifdef USE_GPU
+    flags.push_back("USE_GPU");
+#endif
+#ifdef P3T_64BIT
+    flags.push_back("P3T_64BIT");
+#endif
+#ifdef SOFT_MIXED_PRECISION
+    flags.push_back("SOFT_MIXED_PRECISION");
+#endif
+#ifdef SOFT_PERT
+    flags.push_back("SOFT_PERT");
+#endif
+#ifdef TIDAL_TENSOR_3RD
+    flags.push_back("TIDAL_TENSOR_3RD");
+#endif
+#ifdef ORBIT_SAMPLING
+    flags.push_back("ORBIT_SAMPLING");
+#endif
+#ifdef AR_TTL
+    flags.push_back("AR_TTL");
+#endif
+#ifdef AR_SLOWDOWN_TREE
+    flags.push_back("AR_SLOWDOWN_TREE");
+#endif
+#ifdef AR_SLOWDOWN_TIMESCALE
+    flags.push_back("AR_SLOWDOWN_TIMESCALE");
+#endif
+#ifdef CLUSTER_VELOCITY
+    flags.push_back("CLUSTER_VELOCITY");
+#endif
+#ifdef KDKDK_2ND
+    flags.push_back("KDKDK_2ND");
+#endif
+#ifdef KDKDK_4TH
+    flags.push_back("KDKDK_4TH");
+#endif
+#ifdef STELLAR_EVOLUTION
+    flags.push_back("STELLAR_EVOLUTION");
+#endif
+#ifdef BSE_BASE
+    flags.push_back("BSE_BASE");
+#endif
+#ifdef GALPY
+    flags.push_back("GALPY");
+#endif
+#ifdef HARD_GROUP_RECORD
+    flags.push_back("HARD_GROUP_RECORD");
+#endif
+    writeKey(_fout, "flags", 4);
+    _fout<<"[";
+    for (std::size_t i=0; i<flags.size(); i++) _fout<<(i>0?", ":"")<<"\""<<flags[i]<<"\"";
+    _fout<<"],\n";
+    writeKey(_fout, "mpi_processes", 4);
+    _fout<<_petar.n_proc<<",\n";
+    writeKey(_fout, "omp_threads", 4);
+    _fout<<PS::Comm::getNumberOfThread()<<"\n";
+    _fout<<"  },\n";
+
+    writeKey(_fout, "setup", 2);
+    _fout<<"{\n";
+    writeKey(_fout, "n", 4);        _fout<<inp.n_glb.value<<",\n";
+    writeKey(_fout, "n_bin", 4);    _fout<<inp.n_bin.value<<",\n";
+    writeKey(_fout, "fbin", 4);     _fout<<_bench.fbin<<",\n";
+    writeKey(_fout, "seed", 4);     _fout<<_bench.seed<<",\n";
+    writeKey(_fout, "n_warmup", 4); _fout<<_bench.n_warmup<<",\n";
+    writeKey(_fout, "dt_soft", 4);  _fout<<inp.dt_soft.value<<",\n";
+    writeKey(_fout, "r_out", 4);    _fout<<inp.r_out.value<<",\n";
+    writeKey(_fout, "theta", 4);    _fout<<inp.theta.value<<"\n";
+    _fout<<"  },\n";
+
+    writeKey(_fout, "tree_steps", 2);            _fout<<_petar.dn_loop<<",\n";
+    writeKey(_fout, "wall_time", 2);             _fout<<_wtime<<",\n";
+    writeKey(_fout, "particles_per_second", 2);  _fout<<PS::F64(inp.n_glb.value)*_petar.dn_loop/_wtime<<",\n";
+    writeKey(_fout, "hard_steps_per_second", 2); _fout<<PS::F64(n_hard_step)/_wtime<<",\n";
+    writeKey(_fout, "peak_memory_mb", 2);
+    _fout<<"{\"max\": "<<_mem_max<<", \"sum\": "<<_mem_sum<<"},\n";
+
+    // cumulative energy error from the initial step, e.g. to compare the soft force precision modes
+    auto& energy = _petar.stat.energy;
+    writeKey(_fout, "energy", 2);
+    _fout<<"{\"total\": "<<energy.ekin+energy.epot
+         <<", \"error\": "<<energy.getEnergyError()
+         <<", \"relative_error\": "<<energy.getEnergyError()/(energy.ekin+energy.epot);
+#ifdef HARD_CHECK_ENERGY
+    _fout<<", \"hard_error\": "<<energy.error_hard_cum;
+#endif
+    _fout<<"},\n";
+
+    // SysProfile phases of integrateToTime
+    writeKey(_fout, "phases", 2);
+    _fout<<"{\n";
+    for (PS::S32 i=0; i<_petar.profile.n_profile; i++) {
+        Tprofile* iptr = (Tprofile*)&_petar.profile+i;
+        const Tprofile* imax = (const Tprofile*)&_profile_max+i;
+        writeKey(_fout, trimName(iptr->name), 4);
+        _fout<<"{\"time\": "<<iptr->time/n_loop
+             <<", \"barrier\": "<<iptr->tbar/n_loop
+             <<", \"time_max\": "<<imax->time/n_loop<<"}"
+             <<(i<_petar.profile.n_profile-1?",":"")<<"\n";
+    }
+    _fout<<"  },\n";
+
+    // FDPS soft force tree
+    auto& tp = _petar.tree_soft_profile;
+    writeKey(_fout, "tree_soft", 2);
+    _fout<<"{\"calc_force\": "<<tp.calc_force/n_loop
+         <<", \"make_local_tree\": "<<tp.make_local_tree/n_loop
+         <<", \"make_global_tree\": "<<tp.make_global_tree/n_loop
+         <<", \"calc_moment_local_tree\": "<<tp.calc_moment_local_tree/n_loop
+         <<", \"calc_moment_global_tree\": "<<tp.calc_moment_global_tree/n_loop
+         <<", \"make_LET_1st\": "<<tp.make_LET_1st/n_loop
+         <<", \"exchange_LET_1st\": "<<tp.exchange_LET_1st/n_loop
+         <<"},\n";
+
+    // global counts per step
+    writeKey(_fout, "counts", 2);
+    _fout<<"{\n";
+    auto& counts = _petar.n_count_sum;
+    for (PS::S32 i=0; i<counts.n_counter; i++) {
+        NumCounter* iptr = (NumCounter*)&counts+i;
+        writeKey(_fout, trimName(iptr->name), 4);
+        _fout<<PS::F64(iptr->n)/n_loop<<(i<counts.n_counter-1?",":"")<<"\n";
+    }
+    _fout<<"  }\n";
+    _fout<<"}\n";
+}
+
+int main(int argc, char *argv[]){
+
+    BenchParams bench;
+    int iread_bench = bench.read(argc, argv);
+    if (iread_bench!=0) {
+        bench.printHelp(std::cout);
+        return iread_bench==-1? 0: 1;
+    }
+
+    PeTar::initialFDPS(argc,argv);
+
+    PeTar petar;
+
+    PS::S32 iread = petar.readParameters(argc,argv);
+    if (iread<0) {
+        if (petar.my_rank==0) bench.printHelp(std::cout);
+        PeTar::finalizeFDPS();
+        return 0;
+    }
+
+    auto& inp = petar.input_parameters;
+
+    petar.generatePlummer(bench.fbin, bench.semi_min, bench.semi_max, bench.seed);
+
+    petar.initialParameters();
+
+    petar.initialStep();
+
+    if (bench.n_warmup>0) integrateSteps(petar, bench.n_warmup);
+
+    petar.clearProfile();
+    PS::Comm::barrier();
+    PS::F64 wtime = -PS::GetWtime();
+
+    integrateSteps(petar, bench.n_step);
+
+    PS::Comm::barrier();
+    wtime += PS::GetWtime();
+    petar.finishProfileReduction();
+
+    // peak resident memory, ru_maxrss is in kB on Linux
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    PS::F64 mem_loc = usage.ru_maxrss/1024.0;
+    PS::F64 mem_max = PS::Comm::getMaxValue(mem_loc);
+    PS::F64 mem_sum = PS::Comm::getSum(mem_loc);
+
+    // maximum time of profile items among all ranks
+    SysProfile profile_max = petar.profile.getMax();
+
+    // energy error at the end, the status time is not counted in the report
+    Tprofile status_save = petar.profile.status;
+    petar.updateStatus(false);
+    petar.profile.status = status_save;
+
+    if (petar.my_rank==0) {
+        std::string fname = bench.fname_json.empty()? inp.fname_snp.value+".bench.json": bench.fname_json;
+        std::ofstream fout(fname.c_str(), std::ofstream::out);
+        writeReport(fout, petar, profile_max, bench, wtime, mem_max, mem_sum);
+        fout.close();
+        std::cout<<"Benchmark: "<<petar.dn_loop<<" tree steps, wall time [s]: "<<wtime<<", report: "<<fname<<std::endl;
+    }
+
+    PeTar::finalizeFDPS();
+
+    return 0;
+}
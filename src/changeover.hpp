@@ -95,6 +95,16 @@ public:
         return r_out_;
     }
 
+    //! get 1/(r_out-r_in)
+    const Float &getNorm() const {
+        return norm_;
+    }
+
+    //! get (r_out-r_in)/(r_out+r_in)
+    const Float &getCoff() const {
+        return coff_;
+    }
+
     void print(std::ostream & _fout) const{
         _fout<<" r_in="<<r_in_
              <<" r_out="<<r_out_;
@@ -240,7 +250,18 @@ public:
         assert(r_in_>0.0);
         assert(r_out_>r_in_);
 #endif
-        Float x = (_dr - r_in_)*norm_;
+        return calcAcc0WPar(_dr, r_in_, norm_, coff_);
+    }
+
+    //! changeover function for force with given parameters (branch-free, for vectorized loops)
+    /*! @param[in] _dr: particle separation
+      @param[in] _r_in: r_in
+      @param[in] _norm: 1/(r_out-r_in)
+      @param[in] _coff: (r_out-r_in)/(r_out+r_in), not used
+      \return \f$ W_0(x) \f$
+     */
+    static inline Float calcAcc0WPar(const Float _dr, const Float _r_in, const Float _norm, const Float _coff) {
+        Float x = (_dr - _r_in)*_norm;
         x = (x < 1.0) ? x : 1.0;
         x = (x > 0.0) ? x : 0.0;
         Float x2 = x*x;
@@ -320,7 +341,18 @@ public:
         assert(r_in_>0.0);
         assert(r_out_>r_in_);
 #endif
-        Float x = (_dr - r_in_)*norm_;
+        return calcAcc0WPar(_dr, r_in_, norm_, coff_);
+    }
+
+    //! changeover function for force with given parameters (branch-free, for vectorized loops)
+    /*! @param[in] _dr: particle separation
+      @param[in] _r_in: r_in
+      @param[in] _norm: 1/(r_out-r_in)
+      @param[in] _coff: (r_out-r_in)/(r_out+r_in)
+      \return \f$ W_0(x) \f$
+     */
+    static inline Float calcAcc0WPar(const Float _dr, const Float _r_in, const Float _norm, const Float _coff) {
+        Float x = (_dr - _r_in)*_norm;
         x = (x < 1.0) ? x : 1.0;
         x = (x > 0.0) ? x : 0.0;
         Float x_1 = x - 1;
@@ -329,7 +361,7 @@ public:
         Float x2 = x*x;
         Float x3 = x2*x;
         Float x4 = x2*x2;
-        Float k = x_4*(1.0 + 4.0*x + 10.0*x2 + 20.0*x3 + 35.0*coff_*x4);
+        Float k = x_4*(1.0 + 4.0*x + 10.0*x2 + 20.0*x3 + 35.0*_coff*x4);
         return k;
     }
 
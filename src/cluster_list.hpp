@@ -2,6 +2,7 @@
 #include<particle_simulator.hpp>
 #include<unordered_map>
 #include<map>
+#include<limits>
 #include"ptcl.hpp"
 #include"Common/binary_tree.h"
 
@@ -11,42 +12,6 @@
 #define ARRAY_ALLOW_LIMIT 1000000000
 #endif
 
-#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
-template <class Ttree>
-void SetRankComm(const PS::F64ort pos_domain[], Ttree &tree,
-                 PS::ReallocatableArray<PS::S32> & rank_neighbor,
-                 const PS::F64 eps_sq = 0.0){
-    rank_neighbor.clearSize();
-//    static const PS::F64 SAFTY_FACTOR_FOR_SEARCH_SQ = 1.01;
-    const PS::S32 my_rank = PS::Comm::getRank();
-    const PS::S32 n_proc = PS::Comm::getNumberOfProc();
-//    const PS::F64ort pos_my_domain = pos_domain[my_rank];
-    PS::F64ort pos_my_domain = tree.getOuterBoundaryOfLocalTree();
-    PS::F64ort pos_my_domain_in = tree.getInnerBoundaryOfLocalTree();
-    PS::F64ort * pos_domain_out = new PS::F64ort[n_proc];
-    PS::Comm::allGather(&pos_my_domain, 1, pos_domain_out);
-    //MPI_Allgather(&pos_my_domain, 1, PS::GetDataType<PS::F64ort>(),
-    //              pos_domain_out, 1, PS::GetDataType<PS::F64ort>(), MPI_COMM_WORLD);
-    PS::F64ort * pos_domain_in = new PS::F64ort[n_proc];
-    PS::Comm::allGather(&pos_my_domain_in, 1, pos_domain_in);
-    //MPI_Allgather(&pos_my_domain_in, 1, PS::GetDataType<PS::F64ort>(),
-    //              pos_domain_in,  1, PS::GetDataType<PS::F64ort>(), MPI_COMM_WORLD);
-//    const PS::F64 r_crit_sq = (EPJSoft::r_search * EPJSoft::r_search + eps_sq)*SAFTY_FACTOR_FOR_SEARCH_SQ*1.01;
-//    pos_domain[my_rank].getOuterBoundaryOfLocalTree
-    rank_neighbor.clearSize();
-    for(int i=0; i<n_proc; i++){
-        if(i==my_rank) continue;
-        //else if( r_crit_sq >= pos_my_domain.getDistanceMinSQ(pos_domain[i]) ){
-        else if( pos_my_domain.contained(pos_domain_in[i]) || pos_my_domain_in.contained(pos_domain_out[i])){
-            rank_neighbor.push_back(i);
-        }
-//        rank_neighbor.push_back(i);
-    }
-    delete [] pos_domain_in;
-    delete [] pos_domain_out;
-}
-#endif
-
 struct Cluster{
     PS::S32 id_;
     PS::S32 n_ptcl_; // include outer particle
@@ -143,6 +108,14 @@ public:
     }
 };
 
+//! label of a connected cluster for global ID determination
+struct ClusterLabel{
+    PS::S32 id_;   // minimum particle ID in the cluster
+    PS::S32 rank_; // rank of the particle with the minimum ID
+    ClusterLabel(): id_(-1), rank_(-1) {}
+    ClusterLabel(const PS::S32 _id, const PS::S32 _rank): id_(_id), rank_(_rank) {}
+};
+
 class PtclComm: public Ptcl{
 public:
     PS::S32 id_cluster;
@@ -187,8 +160,13 @@ private:
     PS::ReallocatableArray< std::pair<PS::S32, PS::S32> > adr_ngb_multi_cluster_;
     PS::ReallocatableArray<PS::S32> * adr_sys_one_cluster_;
     PS::ReallocatableArray<PtclCluster> * ptcl_cluster_;
-    PS::ReallocatableArray<PS::S32> id_cluster_send_;
-    PS::ReallocatableArray<PS::S32> id_cluster_recv_;
+    PS::ReallocatableArray<PS::S32> adr_comp_pcluster_; // local connected component index of ptcl_cluster_, -1: isolated
+    PS::ReallocatableArray<ClusterLabel> comp_label_; // labels of local connected components
+    PS::ReallocatableArray<ClusterLabel> label_send_;
+    PS::ReallocatableArray<ClusterLabel> label_send_back_;
+    PS::ReallocatableArray<ClusterLabel> label_recv_;
+    PS::ReallocatableArray<ClusterLabel> label_recv_back_;
+    PS::S32 n_loop_id_cluster_;
     PS::ReallocatableArray<PS::S32> adr_pcluster_send_;
     PS::ReallocatableArray<PS::S32> adr_pcluster_recv_;
     PS::ReallocatableArray<PS::S32> n_cluster_send_;
@@ -206,6 +184,25 @@ private:
     PS::ReallocatableArray<PS::S32> rank_recv_ptcl_;
     PS::ReallocatableArray<PS::S32> n_ptcl_recv_;
     PS::ReallocatableArray<PS::S32> n_ptcl_disp_recv_;
+#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
+    //! MPI tags of the point-to-point exchanges of connected clusters
+    enum CommTag {
+        TAG_NGB_COUNT  = 1837, // number of remote neighbor IDs (sparse count exchange)
+        TAG_NGB_ID     = 1871, // remote neighbor IDs
+        TAG_LABEL      = 1947, // cluster labels, owner to referrer (1948: referrer to owner)
+        TAG_DEST_COUNT = 2021, // number of destination votes (sparse count exchange)
+        TAG_DEST_VOTE  = 2022, // local particle number of clusters sent to the label owner
+        TAG_DEST_RANK  = 2023, // chosen destination rank sent back to the voters
+        TAG_PTCL_COUNT = 2135, // number of cluster particles (sparse count exchange)
+        TAG_PTCL       = 2136, // cluster particles
+        TAG_PTCL_SEND  = 2239, // local single particles sent to the ranks integrating their clusters
+        TAG_PTCL_BACK  = 2303  // integrated particles sent back to the original ranks
+    };
+    // communicator of the cluster exchanges, a duplicate of the communicator of the particle system,
+    // thus the wildcard probe of the sparse count exchange cannot match other traffic
+    MPI_Comm comm_cluster_;
+#endif
+    PS::S32 my_rank_; // rank in the communicator of the particle system
     template<class T>
     void packDataToThread0(T * data){
         const PS::S32 n_thread = PS::Comm::getNumberOfThread();
@@ -329,8 +326,54 @@ private:
         }
     };
 
+    //! release the duplicated communicator and the thread-local arrays
+    void release() {
+#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
+        if (comm_cluster_!=MPI_COMM_NULL) {
+            // the destructor can run after MPI_Finalize
+            int finalized_flag = 0;
+            MPI_Finalized(&finalized_flag);
+            if (!finalized_flag) MPI_Comm_free(&comm_cluster_);
+            comm_cluster_ = MPI_COMM_NULL;
+        }
+#endif
+        if (adr_sys_one_cluster_!=NULL) {
+            delete [] adr_sys_one_cluster_;
+            adr_sys_one_cluster_ = NULL;
+        }
+        if (ptcl_cluster_!=NULL) {
+            delete [] ptcl_cluster_;
+            ptcl_cluster_ = NULL;
+        }
+    }
+
 public:
+    SearchCluster(): adr_sys_one_cluster_(NULL), ptcl_cluster_(NULL),
+#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
+                     comm_cluster_(MPI_COMM_NULL),
+#endif
+                     my_rank_(0) {}
+
+    ~SearchCluster() { release(); }
+
+#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
+    //! initialize, a repeated call releases the previous communicator and arrays
+    /*! @param[in] _comm: communicator of the particle system (PS::CommInfo::getCommunicator() with FDPS_COMM), 
+                          all cluster exchanges use a duplicate of it and the ranks are counted in it
+     */
+    void initialize(const MPI_Comm _comm = MPI_COMM_WORLD){
+#else
+    //! initialize, a repeated call releases the previous arrays
     void initialize(){
+#endif
+        release();
+        n_loop_id_cluster_ = 0;
+#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
+        MPI_Comm_dup(_comm, &comm_cluster_);
+        MPI_Comm_rank(comm_cluster_, &my_rank_);
+#else
+        my_rank_ = 0;
+#endif
         const PS::S32 n_thread = PS::Comm::getNumberOfThread();
         adr_sys_one_cluster_  = new PS::ReallocatableArray<PS::S32>[n_thread];
         ptcl_cluster_ = new PS::ReallocatableArray<PtclCluster>[n_thread];
@@ -432,7 +475,7 @@ public:
         const PS::S32 n_thread = PS::Comm::getNumberOfThread();
         if(ptcl_outer==NULL) ptcl_outer = new PS::ReallocatableArray<PtclOuter>[n_thread];
         if(id_ngb_multi_cluster==NULL) id_ngb_multi_cluster = new PS::ReallocatableArray< std::pair<PS::S32, PS::S32> >[n_thread];
-        const PS::S32 my_rank = PS::Comm::getRank();
+        const PS::S32 my_rank = my_rank_;
         //        const PS::S32 n_proc_tot = PS::Comm::getNumberOfProc();
         const PS::S32 n_loc = sys.getNumberOfParticleLocal();
 #ifdef CLUSTER_VELOCITY
@@ -611,7 +654,7 @@ public:
 
 
     void searchClusterLocal(){
-        const PS::S32 my_rank = PS::Comm::getRank();
+        const PS::S32 my_rank = my_rank_;
         const PS::S32 n_loc = ptcl_cluster_[0].size();
 
         adr_sys_multi_cluster_isolated_.clearSize();
@@ -625,6 +668,9 @@ public:
         n_ptcl_in_multi_cluster_isolated_.clearSize();
         n_ptcl_in_multi_cluster_isolated_offset_.clearSize();
         n_ptcl_in_multi_cluster_isolated_offset_.push_back(0);
+        comp_label_.clearSize();
+        adr_comp_pcluster_.resizeNoInitialize(n_loc);
+        for(PS::S32 i=0; i<n_loc; i++) adr_comp_pcluster_[i] = -1;
 
         for(PS::S32 i=0; i<n_loc; i++){
             bool flag_isolated = true;
@@ -648,14 +694,21 @@ public:
                     n_ptcl_in_multi_cluster_isolated_offset_.push_back(n_ptcl_in_cluster+n_ptcl_in_multi_cluster_isolated_offset_.back());
                 }
                 else{
+                    // record the local connected component for the global ID determination
                     PtclCluster * p_tmp = ptcl_cluster_[0].getPointer(i);
-                    PS::S32 id_cluster = p_tmp->id_;
+                    const PS::S32 adr_comp = comp_label_.size();
+                    ClusterLabel label(p_tmp->id_, p_tmp->rank_org_);
                     while(p_tmp != NULL){
-                        if(p_tmp->id_ < id_cluster) id_cluster = p_tmp->id_;
+                        if(p_tmp->id_ < label.id_) {
+                            label.id_ = p_tmp->id_;
+                            label.rank_ = p_tmp->rank_org_;
+                        }
                         PS::S32 adr_pcluster = p_tmp-ptcl_cluster_[0].getPointer();
-                        mediator_sorted_id_cluster_.push_back(Mediator(p_tmp->id_, p_tmp->adr_sys_, adr_pcluster, -1, PS::Comm::getRank()) ); // temporarily send_rank_ is my_rank
+                        adr_comp_pcluster_[adr_pcluster] = adr_comp;
+                        mediator_sorted_id_cluster_.push_back(Mediator(p_tmp->id_, p_tmp->adr_sys_, adr_pcluster, -1, my_rank) ); // temporarily send_rank_ is my_rank
                         p_tmp = p_tmp->next_;
                     }
+                    comp_label_.push_back(label);
                 }
             }
         }
@@ -681,340 +734,413 @@ public:
     }
 
 #ifdef PARTICLE_SIMULATOR_MPI_PARALLEL    
-    template <class Ttree>
-    void connectNodes(PS::F64ort pos_domain[], Ttree & tree){
-        const PS::S32 n_proc_tot = PS::Comm::getNumberOfProc();
-        const PS::S32 my_rank = PS::Comm::getRank();
-        static PS::ReallocatableArray<PS::S32> rank_neighbor;
-        static PS::ReallocatableArray<PS::S32> n_send_org;
-        static PS::ReallocatableArray<PS::S32> n_send_org_disp;
-        static PS::ReallocatableArray<PS::S32> id_send_org;
+private:
+    //! sparse exchange of data counts with unknown senders
+    /*! Non-blocking consensus (NBX): each rank only knows its destination ranks.
+        The counts are sent with synchronous sends, the receivers are discovered by probing,
+        and a non-blocking barrier detects when all messages are delivered.
+        The cost scales with the number of communication partners instead of the total rank number.
+        @param[out] _rank_recv: ranks sending data to this rank (sorted)
+        @param[out] _n_recv: number of data from each rank in _rank_recv
+        @param[in] _rank_send: destination ranks
+        @param[in] _n_send: number of data to each destination rank
+        @param[in] _tag: MPI tag used for the count messages
+     */
+    void exchangeCountSparse(PS::ReallocatableArray<PS::S32> & _rank_recv,
+                             PS::ReallocatableArray<PS::S32> & _n_recv,
+                             PS::ReallocatableArray<PS::S32> & _rank_send,
+                             PS::ReallocatableArray<PS::S32> & _n_send,
+                             const int _tag) {
+        const PS::S32 n_rank_send = _rank_send.size();
+        static PS::ReallocatableArray<MPI_Request> req_send;
+        req_send.resizeNoInitialize(n_rank_send);
+        for(PS::S32 i=0; i<n_rank_send; i++){
+            MPI_Issend(_n_send.getPointer(i), 1, PS::GetDataType<PS::S32>(),
+                       _rank_send[i], _tag, comm_cluster_, req_send.getPointer(i));
+        }
+
+        static PS::ReallocatableArray< std::pair<PS::S32, PS::S32> > rank_n_recv;
+        rank_n_recv.clearSize();
+        MPI_Request req_barrier;
+        bool flag_barrier = false;
+        while(true){
+            int flag_probe = 0;
+            MPI_Status stat;
+            MPI_Iprobe(MPI_ANY_SOURCE, _tag, comm_cluster_, &flag_probe, &stat);
+            if(flag_probe){
+                PS::S32 n_recv_i;
+                MPI_Recv(&n_recv_i, 1, PS::GetDataType<PS::S32>(), stat.MPI_SOURCE, _tag, comm_cluster_, MPI_STATUS_IGNORE);
+                rank_n_recv.push_back(std::pair<PS::S32, PS::S32>(stat.MPI_SOURCE, n_recv_i));
+            }
+            if(flag_barrier){
+                int flag_done = 0;
+                MPI_Test(&req_barrier, &flag_done, MPI_STATUS_IGNORE);
+                if(flag_done) break;
+            }
+            else{
+                int flag_sent = 0;
+                MPI_Testall(n_rank_send, req_send.getPointer(), &flag_sent, MPI_STATUSES_IGNORE);
+                if(flag_sent){
+                    MPI_Ibarrier(comm_cluster_, &req_barrier);
+                    flag_barrier = true;
+                }
+            }
+        }
+
+        // sort by rank to keep the receiving order deterministic
+        std::sort(rank_n_recv.getPointer(), rank_n_recv.getPointer(rank_n_recv.size()), OPLessFirst());
+        _rank_recv.resizeNoInitialize(rank_n_recv.size());
+        _n_recv.resizeNoInitialize(rank_n_recv.size());
+        for(PS::S32 i=0; i<rank_n_recv.size(); i++){
+            _rank_recv[i] = rank_n_recv[i].first;
+            _n_recv[i] = rank_n_recv[i].second;
+        }
+    }
+
+    //! exchange data with two groups of ranks in both directions
+    /*! Send _send_a to the ranks of group a and receive _recv_b from group b, and vice versa.
+        A rank of group a receives with the layout of group b on the remote side, 
+        thus the two directions use different tags (_tag and _tag+1).
+        Used for the symmetric cluster label exchange between owners and referrers of boundary particles.
+     */
+    template<class T>
+    void exchangeBothDirections(T * _send_a, T * _recv_a, PS::ReallocatableArray<PS::S32> & _rank_a, 
+                                PS::ReallocatableArray<PS::S32> & _n_a, PS::ReallocatableArray<PS::S32> & _n_disp_a,
+                                T * _send_b, T * _recv_b, PS::ReallocatableArray<PS::S32> & _rank_b,
+                                PS::ReallocatableArray<PS::S32> & _n_b, PS::ReallocatableArray<PS::S32> & _n_disp_b,
+                                const int _tag) {
+        const PS::S32 n_req = 2*(_rank_a.size() + _rank_b.size());
+        static PS::ReallocatableArray<MPI_Request> req;
+        req.resizeNoInitialize(n_req);
+        PS::S32 n_cnt = 0;
+        for(PS::S32 i=0; i<_rank_a.size(); i++){
+            MPI_Isend(_send_a+_n_disp_a[i], _n_a[i], PS::GetDataType<T>(), _rank_a[i], _tag, comm_cluster_, req.getPointer(n_cnt++));
+            MPI_Irecv(_recv_a+_n_disp_a[i], _n_a[i], PS::GetDataType<T>(), _rank_a[i], _tag+1, comm_cluster_, req.getPointer(n_cnt++));
+        }
+        for(PS::S32 i=0; i<_rank_b.size(); i++){
+            MPI_Isend(_send_b+_n_disp_b[i], _n_b[i], PS::GetDataType<T>(), _rank_b[i], _tag+1, comm_cluster_, req.getPointer(n_cnt++));
+            MPI_Irecv(_recv_b+_n_disp_b[i], _n_b[i], PS::GetDataType<T>(), _rank_b[i], _tag, comm_cluster_, req.getPointer(n_cnt++));
+        }
+        MPI_Waitall(n_cnt, req.getPointer(), MPI_STATUSES_IGNORE);
+    }
+
+public:
+    //! build the point-to-point communication pattern of boundary particles
+    /*! Each rank sends the IDs of remote neighbors to their original ranks. 
+        Only ranks sharing boundary particles communicate, the receivers are found by exchangeCountSparse.
+     */
+    void connectNodes(){
+        const PS::S32 my_rank = my_rank_;
+        static PS::ReallocatableArray<PS::S32> rank_send;
         static PS::ReallocatableArray<PS::S32> n_send;
-        static PS::ReallocatableArray<PS::S32> n_recv;
         static PS::ReallocatableArray<PS::S32> n_send_disp;
         static PS::ReallocatableArray<PS::S32> n_recv_disp;
         static PS::ReallocatableArray<PS::S32> id_send;
         static PS::ReallocatableArray<PS::S32> id_recv;
-        rank_neighbor.clearSize();
-        n_send_org.resizeNoInitialize(n_proc_tot);
-        n_send_org_disp.resizeNoInitialize(n_proc_tot+1);
-        SetRankComm(pos_domain, tree, rank_neighbor);
-        for(PS::S32 i=0; i<n_proc_tot; i++) n_send_org[i] = 0;
+        static std::unordered_map<PS::S32, PS::S32> rank_to_adr;
 
+        // count remote neighbors per original rank
+        rank_to_adr.clear();
         for(PS::S32 i=n_pcluster_self_node_; i<ptcl_cluster_[0].size(); i++){
-            assert(ptcl_cluster_[0][i].rank_org_ != my_rank);
-            n_send_org[ptcl_cluster_[0][i].rank_org_]++;
+            const PS::S32 rank = ptcl_cluster_[0][i].rank_org_;
+            assert(rank != my_rank);
+            rank_to_adr[rank]++;
         }
-
-        n_send_org_disp[0] = 0;
-        static PS::ReallocatableArray<PS::S32> n_cnt_send;
-        n_cnt_send.resizeNoInitialize(n_proc_tot);
-        for(PS::S32 i=0; i<n_proc_tot; i++) {
-            n_send_org_disp[i+1] = n_send_org_disp[i] + n_send_org[i];
-            n_cnt_send[i] = 0;
+        // sort ranks to keep the order deterministic
+        rank_send.clearSize();
+        for(auto itr=rank_to_adr.begin(); itr!=rank_to_adr.end(); itr++) rank_send.push_back(itr->first);
+        std::sort(rank_send.getPointer(), rank_send.getPointer(rank_send.size()));
+        const PS::S32 n_rank_send = rank_send.size();
+        n_send.resizeNoInitialize(n_rank_send);
+        for(PS::S32 i=0; i<n_rank_send; i++) {
+            n_send[i] = rank_to_adr[rank_send[i]];
+            rank_to_adr[rank_send[i]] = i;
         }
 
-        id_send_org.resizeNoInitialize(n_send_org_disp[n_proc_tot]);
-        for(PS::S32 i=n_pcluster_self_node_; i<ptcl_cluster_[0].size(); i++){
-            PS::S32 rank = ptcl_cluster_[0][i].rank_org_;
-            PS::S32 adr = n_send_org_disp[rank] + n_cnt_send[rank];
-            id_send_org[adr] = ptcl_cluster_[0][i].id_;
-            n_cnt_send[rank]++;
-        }
-        
-        const PS::S32 n_rank_send = rank_neighbor.size();
-        n_send.resizeNoInitialize(n_rank_send);
-        n_recv.resizeNoInitialize(n_rank_send);
         n_send_disp.resizeNoInitialize(n_rank_send+1);
-        n_recv_disp.resizeNoInitialize(n_rank_send+1);
-        id_send.resizeNoInitialize(ptcl_cluster_[0].size());
-
         n_send_disp[0] = 0;
-        for (PS::S32 i=0; i<n_rank_send; i++) {
-            PS::S32 rank = rank_neighbor[i];
-            n_send[i] = n_send_org[rank];
-            if (n_send[i]!=n_cnt_send[rank]) {
-                std::cerr<<"n_send["<<i<<"]="<<n_send[i]<<" != n_cnt_send["<<rank<<"]="<<n_cnt_send[rank]<<std::endl;
-                abort();
-            }
-            n_send_disp[i+1] = n_send_disp[i] + n_send[i];
-            n_recv[i] = 0;
-            
-            for (PS::S32 j=0; j<n_send[i]; j++) {
-                id_send[n_send_disp[i]+j] = id_send_org[n_send_org_disp[rank]+j];
-            }
+        for(PS::S32 i=0; i<n_rank_send; i++) n_send_disp[i+1] = n_send_disp[i] + n_send[i];
+
+        // pack IDs and record the address of remote neighbors in the same order
+        static PS::ReallocatableArray<PS::S32> n_cnt_send;
+        n_cnt_send.resizeNoInitialize(n_rank_send);
+        for(PS::S32 i=0; i<n_rank_send; i++) n_cnt_send[i] = 0;
+        id_send.resizeNoInitialize(n_send_disp[n_rank_send]);
+        adr_pcluster_recv_.resizeNoInitialize(n_send_disp[n_rank_send]);
+        for(PS::S32 i=n_pcluster_self_node_; i<ptcl_cluster_[0].size(); i++){
+            const PS::S32 k = rank_to_adr[ptcl_cluster_[0][i].rank_org_];
+            const PS::S32 adr = n_send_disp[k] + n_cnt_send[k];
+            id_send[adr] = ptcl_cluster_[0][i].id_;
+            adr_pcluster_recv_[adr] = i;
+            n_cnt_send[k]++;
         }
 
-#ifdef FDPS_COMM
-        PS::Comm::sendIrecv(n_send.getPointer(), rank_neighbor.getPointer(), 1, n_rank_send, 
-                            n_recv.getPointer(), rank_neighbor.getPointer(), 1, n_rank_send);
-#else
+        // ranks referring to local particles
+        static PS::ReallocatableArray<PS::S32> rank_recv;
+        static PS::ReallocatableArray<PS::S32> n_recv;
+        exchangeCountSparse(rank_recv, n_recv, rank_send, n_send, TAG_NGB_COUNT);
+        const PS::S32 n_rank_recv = rank_recv.size();
+        n_recv_disp.resizeNoInitialize(n_rank_recv+1);
+        n_recv_disp[0] = 0;
+        for(PS::S32 i=0; i<n_rank_recv; i++) n_recv_disp[i+1] = n_recv_disp[i] + n_recv[i];
+        id_recv.resizeNoInitialize(n_recv_disp[n_rank_recv]);
 
         static PS::ReallocatableArray<MPI_Request> req_send;
         static PS::ReallocatableArray<MPI_Request> req_recv;
-        static PS::ReallocatableArray<MPI_Status> stat_send;
-        static PS::ReallocatableArray<MPI_Status> stat_recv;
-        req_send.resizeNoInitialize(n_proc_tot);
-        req_recv.resizeNoInitialize(n_proc_tot);
-        stat_send.resizeNoInitialize(n_proc_tot);
-        stat_recv.resizeNoInitialize(n_proc_tot);
-
-        for(PS::S32 i=0; i<rank_neighbor.size(); i++){
-            PS::S32 rank = rank_neighbor[i];
-            MPI_Isend(n_send.getPointer(i),  1, PS::GetDataType<PS::S32>(),
-                      rank, 1837, MPI_COMM_WORLD, req_send.getPointer(i));
-            MPI_Irecv(n_recv.getPointer(i),  1, PS::GetDataType<PS::S32>(),
-                      rank, 1837, MPI_COMM_WORLD, req_recv.getPointer(i));
-        }
-        MPI_Waitall(rank_neighbor.size(), req_send.getPointer(), stat_send.getPointer());
-        MPI_Waitall(rank_neighbor.size(), req_recv.getPointer(), stat_recv.getPointer());
-#endif
-
-        n_recv_disp[0] = 0;
+        req_send.resizeNoInitialize(n_rank_send);
+        req_recv.resizeNoInitialize(n_rank_recv);
         for(PS::S32 i=0; i<n_rank_send; i++){
-            n_recv_disp[i+1] = n_recv_disp[i] + n_recv[i];
+            MPI_Isend(id_send.getPointer(n_send_disp[i]), n_send[i], PS::GetDataType<PS::S32>(),
+                      rank_send[i], TAG_NGB_ID, comm_cluster_, req_send.getPointer(i));
         }
-        id_recv.resizeNoInitialize(n_recv_disp[n_rank_send]);
-
-#ifdef FDPS_COMM
-        PS::Comm::sendIrecvV(id_send.getPointer(), rank_neighbor.getPointer(), n_send.getPointer(), n_send_disp.getPointer(), n_rank_send, 
-                             id_recv.getPointer(), rank_neighbor.getPointer(), n_recv.getPointer(), n_recv_disp.getPointer(), n_rank_send);
-#endif
-
-        rank_send_cluster_.resizeNoInitialize(0);
-        rank_recv_cluster_.resizeNoInitialize(0);
-        n_cluster_send_.resizeNoInitialize(0);
-        n_cluster_recv_.resizeNoInitialize(0);
-        PS::S32 n_proc_send = 0;
-        PS::S32 n_proc_recv = 0;
+        for(PS::S32 i=0; i<n_rank_recv; i++){
+            MPI_Irecv(id_recv.getPointer(n_recv_disp[i]), n_recv[i], PS::GetDataType<PS::S32>(),
+                      rank_recv[i], TAG_NGB_ID, comm_cluster_, req_recv.getPointer(i));
+        }
+        MPI_Waitall(n_rank_send, req_send.getPointer(), MPI_STATUSES_IGNORE);
+        MPI_Waitall(n_rank_recv, req_recv.getPointer(), MPI_STATUSES_IGNORE);
+
+        // labels of local particles are sent to the ranks referring to them (NOTE: send <-> recv of IDs)
+        rank_send_cluster_.resizeNoInitialize(n_rank_recv);
+        n_cluster_send_.resizeNoInitialize(n_rank_recv);
+        for(PS::S32 i=0; i<n_rank_recv; i++){
+            rank_send_cluster_[i] = rank_recv[i];
+            n_cluster_send_[i] = n_recv[i];
+        }
+        rank_recv_cluster_.resizeNoInitialize(n_rank_send);
+        n_cluster_recv_.resizeNoInitialize(n_rank_send);
         for(PS::S32 i=0; i<n_rank_send; i++){
-            PS::S32 rank = rank_neighbor[i];
-            if(n_send[i] > 0){
-                rank_recv_cluster_.push_back(rank); // NOTE: recv not send
-                n_cluster_recv_.push_back(n_send[i]); // NOTE: recv not send
-#ifndef FDPS_COMM
-                MPI_Isend(id_send.getPointer(n_send_disp[i]), n_send[i], PS::GetDataType<PS::S32>(),
-                          rank, 1871, MPI_COMM_WORLD, req_send.getPointer(n_proc_recv));
-#endif
-                n_proc_recv++;
-            }
-            if(n_recv[i] > 0){
-                rank_send_cluster_.push_back(rank); // NOTE: send
-                n_cluster_send_.push_back(n_recv[i]); // NOTE: send
-#ifndef FDPS_COMM
-                MPI_Irecv(id_recv.getPointer(n_recv_disp[i]), n_recv[i], PS::GetDataType<PS::S32>(),
-                          rank, 1871, MPI_COMM_WORLD, req_recv.getPointer(n_proc_send));
-#endif
-                n_proc_send++;
-            }
+            rank_recv_cluster_[i] = rank_send[i];
+            n_cluster_recv_[i] = n_send[i];
         }
-#ifndef FDPS_COMM
-        MPI_Waitall(n_proc_recv, req_send.getPointer(), stat_send.getPointer());
-        MPI_Waitall(n_proc_send, req_recv.getPointer(), stat_recv.getPointer());
-#endif
-        adr_pcluster_send_.clearSize();
-        adr_pcluster_recv_.clearSize();
-        for(PS::S32 i=0; i<n_recv_disp.back(); i++){
-#ifdef CLUSTER_DEBUG
+
+        adr_pcluster_send_.resizeNoInitialize(id_recv.size());
+        for(PS::S32 i=0; i<id_recv.size(); i++){
             auto itr = id_to_adr_pcluster_.find(id_recv[i]);
-            assert(itr != id_to_adr_pcluster_.end());
-            assert(id_to_adr_pcluster_[id_recv[i]] < n_pcluster_self_node_);
-#endif
-            adr_pcluster_send_.push_back(id_to_adr_pcluster_[id_recv[i]]);
-        }
-        for(PS::S32 i=0; i<n_send_disp.back(); i++){
 #ifdef CLUSTER_DEBUG
-            auto itr = id_to_adr_pcluster_.find(id_send[i]);
             assert(itr != id_to_adr_pcluster_.end());
-            /*
-              if(id_to_adr_pcluster_[id_send[i]] < n_pcluster_self_node_ && my_rank == 0){
-              std::cout<<"my_rank= "<<my_rank
-              <<" id_send[i]= "<<id_send[i]
-              <<" id_to_adr_pcluster_[id_send[i]]= "<<id_to_adr_pcluster_[id_send[i]]
-              <<" n_pcluster_self_node_= "<<n_pcluster_self_node_
-              <<std::endl;
-              }
-            */
-            assert(id_to_adr_pcluster_[id_send[i]] >= n_pcluster_self_node_);
+            assert(itr->second < n_pcluster_self_node_);
 #endif
-            adr_pcluster_recv_.push_back(id_to_adr_pcluster_[id_send[i]]);
+            adr_pcluster_send_[i] = (itr != id_to_adr_pcluster_.end()) ? itr->second : -1;
         }
-        n_cluster_disp_send_.resizeNoInitialize(n_proc_send+1);
-        n_cluster_disp_recv_.resizeNoInitialize(n_proc_recv+1);
+        n_cluster_disp_send_.resizeNoInitialize(n_rank_recv+1);
+        n_cluster_disp_recv_.resizeNoInitialize(n_rank_send+1);
         n_cluster_disp_send_[0] = n_cluster_disp_recv_[0] = 0;
-        for(PS::S32 i=0; i<n_proc_send; i++) n_cluster_disp_send_[i+1] = n_cluster_disp_send_[i] + n_cluster_send_[i];
-        for(PS::S32 i=0; i<n_proc_recv; i++) n_cluster_disp_recv_[i+1] = n_cluster_disp_recv_[i] + n_cluster_recv_[i];
+        for(PS::S32 i=0; i<n_rank_recv; i++) n_cluster_disp_send_[i+1] = n_cluster_disp_send_[i] + n_cluster_send_[i];
+        for(PS::S32 i=0; i<n_rank_send; i++) n_cluster_disp_recv_[i+1] = n_cluster_disp_recv_[i] + n_cluster_recv_[i];
+    }
+
+    //! get the label of the local connected component containing a boundary particle
+    ClusterLabel getLabelPcluster(const PS::S32 _adr_pcluster) {
+        // not found, return a label never selected as minimum
+        if (_adr_pcluster<0) return ClusterLabel(std::numeric_limits<PS::S32>::max(), -1);
+        const PS::S32 adr_comp = adr_comp_pcluster_[_adr_pcluster];
+        if (adr_comp<0) return ClusterLabel(ptcl_cluster_[0][_adr_pcluster].id_, ptcl_cluster_[0][_adr_pcluster].rank_org_);
+        return comp_label_[adr_comp];
     }
 
-    void setIdClusterGlobalIteration(){
-        //        const PS::S32 my_rank = PS::Comm::getRank();
+    //! merge a received label to the local connected component
+    /*! \return true if the label of the component is changed
+     */
+    bool mergeLabelPcluster(const PS::S32 _adr_pcluster, const ClusterLabel & _label) {
+        if (_adr_pcluster<0) return false;
+        const PS::S32 adr_comp = adr_comp_pcluster_[_adr_pcluster];
+        if (adr_comp<0) return false;
+        if (_label.id_ < comp_label_[adr_comp].id_) {
+            comp_label_[adr_comp] = _label;
+            return true;
+        }
+        return false;
+    }
+
+    //! determine global cluster ID by distributed union-find of local connected components
+    /*! The local connected components found in searchClusterLocal are contracted to one label (minimum ID and its rank).
+        In each round the labels are exchanged in both directions between the owners and the referrers of boundary particles,
+        thus one round merges components on adjacent ranks.
+        A label moves by one local component per round, thus the number of rounds is bounded by the longest chain of local components
+        of one cluster crossing rank boundaries, not by the total rank number.
+        After convergence, the mediator gets the global cluster ID and the owner rank of the minimum ID, which collects the votes of
+        the destination rank in sendAndRecvCluster.
+     */
+    void setIdClusterGlobal(){
 #ifdef HARD_DEBUG
-        //assert(n_cluster_disp_send_.back()<ARRAY_ALLOW_LIMIT);
         if(n_cluster_disp_send_.back()>ARRAY_ALLOW_LIMIT) {
-            std::cerr<<"Error: size overflow: rank: "<<PS::Comm::getRank()<<" n_cluster_disp_send_.back()="<<n_cluster_disp_send_.back()<<" size="<<n_cluster_disp_send_.size()<<std::endl;
+            std::cerr<<"Error: size overflow: rank: "<<my_rank_<<" n_cluster_disp_send_.back()="<<n_cluster_disp_send_.back()<<" size="<<n_cluster_disp_send_.size()<<std::endl;
         }
         if(n_cluster_disp_recv_.back()>ARRAY_ALLOW_LIMIT) {
-            std::cerr<<"Error: size overflow: rank: "<<PS::Comm::getRank()<<" n_cluster_disp_recv_.back()="<<n_cluster_disp_recv_.back()<<" size="<<n_cluster_disp_recv_.size()<<std::endl;
+            std::cerr<<"Error: size overflow: rank: "<<my_rank_<<" n_cluster_disp_recv_.back()="<<n_cluster_disp_recv_.back()<<" size="<<n_cluster_disp_recv_.size()<<std::endl;
         }
 #endif        
-        id_cluster_send_.resizeNoInitialize(n_cluster_disp_send_.back());
-        id_cluster_recv_.resizeNoInitialize(n_cluster_disp_recv_.back());
-
-#ifndef FDPS_COMM
-        const PS::S32 n_proc_tot = PS::Comm::getNumberOfProc();
-        static PS::ReallocatableArray<MPI_Request> req_send;
-        static PS::ReallocatableArray<MPI_Request> req_recv;
-        static PS::ReallocatableArray<MPI_Status> stat_send;
-        static PS::ReallocatableArray<MPI_Status> stat_recv;
-        req_send.resizeNoInitialize(n_proc_tot);
-        req_recv.resizeNoInitialize(n_proc_tot);
-        stat_send.resizeNoInitialize(n_proc_tot);
-        stat_recv.resizeNoInitialize(n_proc_tot);
-#endif
+        const PS::S32 n_send = n_cluster_disp_send_.back();
+        const PS::S32 n_recv = n_cluster_disp_recv_.back();
+        // send: labels of local particles to referrers; recv: labels of remote particles from owners
+        label_send_.resizeNoInitialize(n_send);
+        label_send_back_.resizeNoInitialize(n_send);
+        label_recv_.resizeNoInitialize(n_recv);
+        label_recv_back_.resizeNoInitialize(n_recv);
 
         bool flag_itr_glb = true;
-        PS::S32 n_loop = 0;
+        n_loop_id_cluster_ = 0;
         while(flag_itr_glb){
-            flag_itr_glb = false;
+            for(PS::S32 i=0; i<n_send; i++) label_send_[i] = getLabelPcluster(adr_pcluster_send_[i]);
+            for(PS::S32 i=0; i<n_recv; i++) label_recv_back_[i] = getLabelPcluster(adr_pcluster_recv_[i]);
 
-            for(PS::S32 i=0; i<adr_pcluster_send_.size(); i++){
-                PS::S32 adr = adr_pcluster_send_[i];
-                assert(adr <= ptcl_cluster_[0].size());
-                id_cluster_send_[i] = ptcl_cluster_[0][adr].id_cluster_;
-            }
-#ifdef FDPS_COMM
-            PS::Comm::sendIrecvV(id_cluster_send_.getPointer(), rank_send_cluster_.getPointer(), n_cluster_send_.getPointer(), n_cluster_disp_send_.getPointer(), rank_send_cluster_.size(), 
-                                 id_cluster_recv_.getPointer(), rank_recv_cluster_.getPointer(), n_cluster_recv_.getPointer(), n_cluster_disp_recv_.getPointer(), rank_recv_cluster_.size());
-#else
-            PS::S32 n_proc_send = 0;
-            PS::S32 n_proc_recv = 0;
-            for(PS::S32 i=0; i<rank_send_cluster_.size(); i++){
-                PS::S32 rank = rank_send_cluster_[i];
-                MPI_Isend(id_cluster_send_.getPointer(n_cluster_disp_send_[i]), n_cluster_send_[i], PS::GetDataType<PS::S32>(),
-                          rank, 1947, MPI_COMM_WORLD, req_send.getPointer(n_proc_send));
-                n_proc_send++;
-            }
-            for(PS::S32 i=0; i<rank_recv_cluster_.size(); i++){
-                PS::S32 rank = rank_recv_cluster_[i];
-                MPI_Irecv(id_cluster_recv_.getPointer(n_cluster_disp_recv_[i]), n_cluster_recv_[i], PS::GetDataType<PS::S32>(),
-                          rank, 1947, MPI_COMM_WORLD, req_recv.getPointer(n_proc_recv));
-                n_proc_recv++;
-            }
-            MPI_Waitall(n_proc_send, req_send.getPointer(), stat_send.getPointer());
-            MPI_Waitall(n_proc_recv, req_recv.getPointer(), stat_recv.getPointer());
-#endif
+            exchangeBothDirections(label_send_.getPointer(), label_send_back_.getPointer(), rank_send_cluster_, n_cluster_send_, n_cluster_disp_send_,
+                                   label_recv_back_.getPointer(), label_recv_.getPointer(), rank_recv_cluster_, n_cluster_recv_, n_cluster_disp_recv_, TAG_LABEL);
 
             bool flag_itr_loc = false;
-            for(PS::S32 i=0; i<id_cluster_recv_.size(); i++){
-                PS::S32 adr = adr_pcluster_recv_[i];
-                if(id_cluster_recv_[i] < ptcl_cluster_[0][adr].id_cluster_){
-                    ptcl_cluster_[0][adr].id_cluster_ = id_cluster_recv_[i];
-                    flag_itr_loc |= true;
-                }
-            }
-            for(PS::S32 i=0; i<mediator_sorted_id_cluster_.size(); i++){
-                PS::S32 adr = mediator_sorted_id_cluster_[i].adr_pcluster_;
-                PS::S32 id_clucster_prev = ptcl_cluster_[0][adr].id_cluster_;
-                ptcl_cluster_[0][adr].setIdClusterImpl(ptcl_cluster_[0], adr_ngb_multi_cluster_);
-                if( id_clucster_prev != ptcl_cluster_[0][adr].id_cluster_){
-                    flag_itr_loc |= true;
-                }
-            }
-            flag_itr_glb = PS::Comm::synchronizeConditionalBranchOR(flag_itr_loc);
-            n_loop++;
+            for(PS::S32 i=0; i<n_recv; i++) flag_itr_loc |= mergeLabelPcluster(adr_pcluster_recv_[i], label_recv_[i]);
+            for(PS::S32 i=0; i<n_send; i++) flag_itr_loc |= mergeLabelPcluster(adr_pcluster_send_[i], label_send_back_[i]);
+
+            int flag_itr_loc_int = flag_itr_loc, flag_itr_glb_int = 0;
+            MPI_Allreduce(&flag_itr_loc_int, &flag_itr_glb_int, 1, MPI_INT, MPI_LOR, comm_cluster_);
+            flag_itr_glb = flag_itr_glb_int;
+            n_loop_id_cluster_++;
         }
         for(PS::S32 i=0; i<mediator_sorted_id_cluster_.size(); i++){
             PS::S32 adr = mediator_sorted_id_cluster_[i].adr_pcluster_;
-            mediator_sorted_id_cluster_[i].id_cluster_ = ptcl_cluster_[0][adr].id_cluster_;
+            const ClusterLabel& label = comp_label_[adr_comp_pcluster_[adr]];
+            ptcl_cluster_[0][adr].id_cluster_ = label.id_;
+            mediator_sorted_id_cluster_[i].id_cluster_ = label.id_;
+            mediator_sorted_id_cluster_[i].rank_send_ = label.rank_;
         }
         std::sort(mediator_sorted_id_cluster_.getPointer(0), mediator_sorted_id_cluster_.getPointer(mediator_sorted_id_cluster_.size()), OPLessIDCluster());
     }
 
+    //! get number of rounds used in the last setIdClusterGlobal
+    PS::S32 getNumberOfLoopIdClusterGlobal() const {
+        return n_loop_id_cluster_;
+    }
+
+    //! choose the destination rank of connected clusters
+    /*! As with the former global gather of cluster information, a cluster is integrated on the rank holding most of its particles
+        (the lower rank if equal), so that the fewest particles are sent.
+        Each rank sends its number of stored particles of a cluster to the owner of the minimum ID (known from the label),
+        the owner chooses the rank and sends it back.
+        @param[in,out] _cluster_loc: local clusters, rank_ is the label owner on input and the destination rank on output
+     */
+    void setRankDestination(PS::ReallocatableArray<Cluster> & _cluster_loc) {
+        const PS::S32 my_rank = my_rank_;
+        const PS::S32 n_cluster = _cluster_loc.size();
+
+        // votes to remote owners, ordered by the owner rank
+        static PS::ReallocatableArray< std::pair<PS::S32, PS::S32> > rank_adr_vote;
+        rank_adr_vote.clearSize();
+        for(PS::S32 i=0; i<n_cluster; i++){
+            if(_cluster_loc[i].rank_ != my_rank) rank_adr_vote.push_back(std::pair<PS::S32, PS::S32>(_cluster_loc[i].rank_, i));
+        }
+        std::stable_sort(rank_adr_vote.getPointer(), rank_adr_vote.getPointer(rank_adr_vote.size()), OPLessFirst());
+        const PS::S32 n_vote_send = rank_adr_vote.size();
+        static PS::ReallocatableArray<Cluster> vote_send;
+        static PS::ReallocatableArray<PS::S32> rank_send;
+        static PS::ReallocatableArray<PS::S32> n_send;
+        static PS::ReallocatableArray<PS::S32> n_send_disp;
+        vote_send.resizeNoInitialize(n_vote_send);
+        rank_send.clearSize();
+        n_send.clearSize();
+        for(PS::S32 i=0; i<n_vote_send; i++){
+            const Cluster & ci = _cluster_loc[rank_adr_vote[i].second];
+            vote_send[i] = Cluster(ci.id_, ci.n_ptcl_, ci.n_ptcl_stored_, -1, my_rank);
+            if(rank_send.size()==0 || rank_send.back() != rank_adr_vote[i].first){
+                rank_send.push_back(rank_adr_vote[i].first);
+                n_send.push_back(0);
+            }
+            n_send.back()++;
+        }
+        const PS::S32 n_rank_send = rank_send.size();
+        n_send_disp.resizeNoInitialize(n_rank_send+1);
+        n_send_disp[0] = 0;
+        for(PS::S32 i=0; i<n_rank_send; i++) n_send_disp[i+1] = n_send_disp[i] + n_send[i];
+
+        static PS::ReallocatableArray<PS::S32> rank_recv;
+        static PS::ReallocatableArray<PS::S32> n_recv;
+        static PS::ReallocatableArray<PS::S32> n_recv_disp;
+        exchangeCountSparse(rank_recv, n_recv, rank_send, n_send, TAG_DEST_COUNT);
+        const PS::S32 n_rank_recv = rank_recv.size();
+        n_recv_disp.resizeNoInitialize(n_rank_recv+1);
+        n_recv_disp[0] = 0;
+        for(PS::S32 i=0; i<n_rank_recv; i++) n_recv_disp[i+1] = n_recv_disp[i] + n_recv[i];
+        const PS::S32 n_vote_recv = n_recv_disp[n_rank_recv];
+        static PS::ReallocatableArray<Cluster> vote_recv;
+        vote_recv.resizeNoInitialize(n_vote_recv);
+
+        static PS::ReallocatableArray<MPI_Request> req;
+        req.resizeNoInitialize(n_rank_send + n_rank_recv);
+        PS::S32 n_req = 0;
+        for(PS::S32 i=0; i<n_rank_send; i++)
+            MPI_Isend(vote_send.getPointer(n_send_disp[i]), n_send[i], PS::GetDataType<Cluster>(), rank_send[i], TAG_DEST_VOTE, comm_cluster_, req.getPointer(n_req++));
+        for(PS::S32 i=0; i<n_rank_recv; i++)
+            MPI_Irecv(vote_recv.getPointer(n_recv_disp[i]), n_recv[i], PS::GetDataType<Cluster>(), rank_recv[i], TAG_DEST_VOTE, comm_cluster_, req.getPointer(n_req++));
+        MPI_Waitall(n_req, req.getPointer(), MPI_STATUSES_IGNORE);
+
+        // owned clusters start with the local particle number
+        static std::unordered_map<PS::S32, PS::S32> id_to_adr_owned;
+        id_to_adr_owned.clear();
+        static PS::ReallocatableArray<PS::S32> n_ptcl_max;
+        n_ptcl_max.resizeNoInitialize(n_cluster);
+        for(PS::S32 i=0; i<n_cluster; i++){
+            if(_cluster_loc[i].rank_ != my_rank) continue;
+            id_to_adr_owned[_cluster_loc[i].id_] = i;
+            n_ptcl_max[i] = _cluster_loc[i].n_ptcl_stored_;
+        }
+        for(PS::S32 i=0; i<n_vote_recv; i++){
+            auto itr = id_to_adr_owned.find(vote_recv[i].id_);
+            assert(itr != id_to_adr_owned.end());
+            const PS::S32 k = itr->second;
+            if( (n_ptcl_max[k] < vote_recv[i].n_ptcl_stored_) ||
+                (n_ptcl_max[k] == vote_recv[i].n_ptcl_stored_ && _cluster_loc[k].rank_ > vote_recv[i].rank_) ){
+                _cluster_loc[k].rank_ = vote_recv[i].rank_;
+                n_ptcl_max[k] = vote_recv[i].n_ptcl_stored_;
+            }
+        }
+
+        // send the chosen ranks back in the order of the received votes
+        static PS::ReallocatableArray<PS::S32> rank_dest_send;
+        static PS::ReallocatableArray<PS::S32> rank_dest_recv;
+        rank_dest_send.resizeNoInitialize(n_vote_recv);
+        rank_dest_recv.resizeNoInitialize(n_vote_send);
+        for(PS::S32 i=0; i<n_vote_recv; i++) rank_dest_send[i] = _cluster_loc[id_to_adr_owned[vote_recv[i].id_]].rank_;
+        n_req = 0;
+        for(PS::S32 i=0; i<n_rank_recv; i++)
+            MPI_Isend(rank_dest_send.getPointer(n_recv_disp[i]), n_recv[i], PS::GetDataType<PS::S32>(), rank_recv[i], TAG_DEST_RANK, comm_cluster_, req.getPointer(n_req++));
+        for(PS::S32 i=0; i<n_rank_send; i++)
+            MPI_Irecv(rank_dest_recv.getPointer(n_send_disp[i]), n_send[i], PS::GetDataType<PS::S32>(), rank_send[i], TAG_DEST_RANK, comm_cluster_, req.getPointer(n_req++));
+        MPI_Waitall(n_req, req.getPointer(), MPI_STATUSES_IGNORE);
+        for(PS::S32 i=0; i<n_vote_send; i++) _cluster_loc[rank_adr_vote[i].second].rank_ = rank_dest_recv[i];
+
+        // the mediators of locally integrated clusters are identified by the destination rank
+        for(PS::S32 i=0; i<n_cluster; i++){
+            for(PS::S32 k=0; k<_cluster_loc[i].n_ptcl_; k++)
+                mediator_sorted_id_cluster_[_cluster_loc[i].adr_head_+k].rank_send_ = _cluster_loc[i].rank_;
+        }
+    }
+
+    //! send the particles of connected clusters to the destination ranks
+    /*! The destination rank of each cluster is chosen by setRankDestination.
+        The receivers find their sources by exchangeCountSparse, no global gather of cluster information is needed.
+     */
     template<class Tsys>
     void sendAndRecvCluster(const Tsys & sys){
-        PS::S32 my_rank = PS::Comm::getRank();
-        PS::S32 n_proc = PS::Comm::getNumberOfProc();
+        PS::S32 my_rank = my_rank_;
         static PS::ReallocatableArray<Cluster> cluster_loc;
         cluster_loc.clearSize();
         if(mediator_sorted_id_cluster_.size() > 0){
             PS::S32 id_cluster_ref = mediator_sorted_id_cluster_[0].id_cluster_;
-            cluster_loc.push_back( Cluster(id_cluster_ref, 0, 0, 0, my_rank) );
+            cluster_loc.push_back( Cluster(id_cluster_ref, 0, 0, 0, mediator_sorted_id_cluster_[0].rank_send_) );
             for(PS::S32 i=0; i<mediator_sorted_id_cluster_.size(); i++){
                 if( id_cluster_ref != mediator_sorted_id_cluster_[i].id_cluster_){
                     id_cluster_ref = mediator_sorted_id_cluster_[i].id_cluster_;
-                    cluster_loc.push_back( Cluster(id_cluster_ref, 0, 0, i, my_rank) );
+                    cluster_loc.push_back( Cluster(id_cluster_ref, 0, 0, i, mediator_sorted_id_cluster_[i].rank_send_) );
                 }
+#ifdef CLUSTER_DEBUG
+                assert(cluster_loc.back().rank_ == mediator_sorted_id_cluster_[i].rank_send_);
+#endif
                 if(mediator_sorted_id_cluster_[i].adr_sys_>=0) cluster_loc.back().n_ptcl_stored_++;
                 cluster_loc.back().n_ptcl_++;
             }
         }
-        //std::cerr<<"sendAndRecvCluster 0: "<<my_rank<<std::endl;
-
-        static PS::ReallocatableArray<PS::S32> n_cluster_recv;
-        static PS::ReallocatableArray<PS::S32> n_cluster_recv_disp;
-        n_cluster_recv.resizeNoInitialize(n_proc);
-        n_cluster_recv_disp.resizeNoInitialize(n_proc+1);
-        PS::S32 n_cluster_tot_loc = cluster_loc.size();
-        PS::Comm::allGather(&n_cluster_tot_loc, 1, n_cluster_recv.getPointer());
-        n_cluster_recv_disp[0] = 0;
-        for(PS::S32 i=0; i<n_proc; i++){
-            n_cluster_recv_disp[i+1] = n_cluster_recv[i] + n_cluster_recv_disp[i];
-        }
-
-        static PS::ReallocatableArray<Cluster> cluster_recv;
-        cluster_recv.resizeNoInitialize(n_cluster_recv_disp[n_proc]);
-        if(n_cluster_tot_loc > 0){
-            PS::Comm::allGatherV(cluster_loc.getPointer(), n_cluster_tot_loc,
-                                 cluster_recv.getPointer(),
-                                 n_cluster_recv.getPointer(), n_cluster_recv_disp.getPointer());
-        }
-        else{
-            Cluster tmp;
-            PS::Comm::allGatherV(&tmp, n_cluster_tot_loc,
-                                 cluster_recv.getPointer(),
-                                 n_cluster_recv.getPointer(), n_cluster_recv_disp.getPointer());
-        }
-
-        //std::cerr<<"sendAndRecvCluster 1: "<<my_rank<<std::endl;
-
-        // exchange cluster info
-        //////////////////////////
-
-        for(PS::S32 i0=0; i0<n_cluster_tot_loc; i0++){
-            const PS::S32 id_cluster = cluster_loc[i0].id_;
-            const PS::S32 n_ptcl_in_cluster = cluster_loc[i0].n_ptcl_stored_;
-            PS::S32 rank_send_tmp = my_rank;
-            PS::S32 n_ptcl_max = n_ptcl_in_cluster;
-            for(PS::S32 i1=0; i1<n_proc; i1++){
-                if(i1 == my_rank) continue;
-                /*
-                  if(my_rank == 0){
-                  std::cout<<"i1="<<i1<<std::endl;
-                  std::cout<<"n_cluster_recv_disp[i1]="<<n_cluster_recv_disp[i1]
-                  <<" n_cluster_recv_disp[i1+1]="<<n_cluster_recv_disp[i1+1]<<std::endl;
-                  }
-                */
-                for(PS::S32 i2=n_cluster_recv_disp[i1]; i2<n_cluster_recv_disp[i1+1]; i2++){
-                    if(id_cluster == cluster_recv[i2].id_){
-                        /*
-                          if(my_rank == 0){
-                          std::cout<<"cluster_recv[i2].id_="<<cluster_recv[i2].id_<<std::endl;
-                          std::cout<<"n_ptcl_in_cluster="<<n_ptcl_in_cluster<<std::endl;
-                          std::cout<<"cluster_recv[i2].n_ptcl_stored_="<<cluster_recv[i2].n_ptcl_stored_<<std::endl;
-                          }
-                        */
-                        if( (n_ptcl_max < cluster_recv[i2].n_ptcl_stored_) ||
-                            (n_ptcl_max == cluster_recv[i2].n_ptcl_stored_ && rank_send_tmp > i1) ){
-                            rank_send_tmp = i1;
-                            n_ptcl_max = cluster_recv[i2].n_ptcl_stored_;
-                        }
-                    }
-                }
-            }
-            cluster_loc[i0].rank_ = rank_send_tmp;
-        }
+        setRankDestination(cluster_loc);
         std::sort(cluster_loc.getPointer(), cluster_loc.getPointer(cluster_loc.size()), OPLessRank());
-        //std::cerr<<"sendAndRecvCluster 2: "<<my_rank<<std::endl;
 
         ////////////
         // pack and send particles
@@ -1026,6 +1152,8 @@ public:
             PS::S32 rank_send_ref = -999999;
             for(PS::S32 i=0; i<cluster_loc.size(); i++){
                 if(cluster_loc[i].rank_ == my_rank) continue;
+                // no local particle to send
+                if(cluster_loc[i].n_ptcl_stored_ == 0) continue;
                 if( rank_send_ref != cluster_loc[i].rank_){
                     rank_send_ref = cluster_loc[i].rank_;
                     rank_send_ptcl_.push_back(rank_send_ref);
@@ -1039,7 +1167,6 @@ public:
                     if(adr_sys < 0){
                         continue;
                     }
-                    mediator_sorted_id_cluster_[cluster_loc[i].adr_head_+ii].rank_send_ = rank_send_ref; // 2006.09.06
                     const auto &p = sys[adr_sys];
                     adr_sys_ptcl_send_.push_back(adr_sys);
                     ptcl_send_.push_back(PtclComm(p));
@@ -1053,99 +1180,53 @@ public:
                     n_ptcl_send_.back()++;
                     n_cnt++;
                 }
-                /*
-                  if(cluster_loc[i].n_ptcl_stored_ != n_cnt){
-                  std::cerr<<"cluster_loc[i].n_ptcl_stored_="<<cluster_loc[i].n_ptcl_stored_
-                  <<" n_cnt="<<n_cnt
-                  <<std::endl;
-                  }
-                */
                 assert(cluster_loc[i].n_ptcl_stored_ == n_cnt);
             }
         }
 
-        //std::cerr<<"sendAndRecvCluster 3: "<<my_rank<<std::endl;
-	
-        //static PS::ReallocatableArray<PS::S32> n_ptcl_disp_send;
         n_ptcl_disp_send_.resizeNoInitialize(rank_send_ptcl_.size()+1);
         n_ptcl_disp_send_[0] = 0;
         for(PS::S32 i=0; i<rank_send_ptcl_.size(); i++){
             n_ptcl_disp_send_[i+1] = n_ptcl_disp_send_[i] + n_ptcl_send_[i];
         }
-
-#ifndef FDPS_COMM
-        static PS::ReallocatableArray<MPI_Request> req_send;
-        static PS::ReallocatableArray<MPI_Status> stat_send;
-        req_send.resizeNoInitialize(n_proc);
-        stat_send.resizeNoInitialize(n_proc);
-        for(PS::S32 i=0; i<rank_send_ptcl_.size(); i++){
-            PS::S32 rank = rank_send_ptcl_[i];
-            MPI_Isend(ptcl_send_.getPointer(n_ptcl_disp_send_[i]),  n_ptcl_send_[i], 
-                      PS::GetDataType<PtclComm>(),
-                      rank, 2136, MPI_COMM_WORLD, req_send.getPointer(i));
-        }
-#endif
-
-        //std::cerr<<"sendAndRecvCluster 4: "<<my_rank<<std::endl;
         // pack and send particles
         ////////////
 	
         ////////////
         // make and recv particles
-        rank_recv_ptcl_.clearSize();
-        n_ptcl_recv_.clearSize();
-        for(PS::S32 i0=0; i0<n_proc; i0++){
-            if(i0 == my_rank) continue;
-            bool flag_recv = false;
-            n_ptcl_recv_.push_back(0);
-            rank_recv_ptcl_.push_back(i0);
-            for(PS::S32 i1=n_cluster_recv_disp[i0]; i1<n_cluster_recv_disp[i0+1]; i1++){
-                PS::S32 id_cluster = cluster_recv[i1].id_;
-                for(PS::S32 i2=0; i2<cluster_loc.size(); i2++){
-                    if(id_cluster == cluster_loc[i2].id_ && cluster_loc[i2].rank_ == my_rank){
-                        n_ptcl_recv_.back() += cluster_recv[i1].n_ptcl_stored_;
-                        flag_recv = true;
-                    }
-                }
-            }
-            if(!flag_recv){
-                n_ptcl_recv_.resizeNoInitialize(n_ptcl_recv_.size()-1);
-                rank_recv_ptcl_.resizeNoInitialize(rank_recv_ptcl_.size()-1);
-            }
-        }
+        exchangeCountSparse(rank_recv_ptcl_, n_ptcl_recv_, rank_send_ptcl_, n_ptcl_send_, TAG_PTCL_COUNT);
 
-        //static PS::ReallocatableArray<PS::S32> n_ptcl_disp_recv_;
         n_ptcl_disp_recv_.resizeNoInitialize(n_ptcl_recv_.size()+1);
         n_ptcl_disp_recv_[0] = 0;
         for(PS::S32 i=0; i<n_ptcl_recv_.size(); i++){
             n_ptcl_disp_recv_[i+1] = n_ptcl_disp_recv_[i] + n_ptcl_recv_[i];
         }
-        //std::cerr<<"sendAndRecvCluster 4.5: "<<my_rank<<std::endl;
 	
         ptcl_recv_.resizeNoInitialize(n_ptcl_disp_recv_[n_ptcl_recv_.size()]);
 
-#ifdef FDPS_COMM
-        PS::Comm::sendIrecvV(ptcl_send_.getPointer(), rank_send_ptcl_.getPointer(), n_ptcl_send_.getPointer(), n_ptcl_disp_send_.getPointer(), rank_send_ptcl_.size(),
-                             ptcl_recv_.getPointer(), rank_recv_ptcl_.getPointer(), n_ptcl_recv_.getPointer(), n_ptcl_disp_recv_.getPointer(), rank_recv_ptcl_.size());
-
-#else
+        static PS::ReallocatableArray<MPI_Request> req_send;
+        static PS::ReallocatableArray<MPI_Status> stat_send;
+        req_send.resizeNoInitialize(rank_send_ptcl_.size());
+        stat_send.resizeNoInitialize(rank_send_ptcl_.size());
+        for(PS::S32 i=0; i<rank_send_ptcl_.size(); i++){
+            PS::S32 rank = rank_send_ptcl_[i];
+            MPI_Isend(ptcl_send_.getPointer(n_ptcl_disp_send_[i]),  n_ptcl_send_[i], 
+                      PS::GetDataType<PtclComm>(),
+                      rank, TAG_PTCL, comm_cluster_, req_send.getPointer(i));
+        }
         static PS::ReallocatableArray<MPI_Request> req_recv;
         static PS::ReallocatableArray<MPI_Status> stat_recv;
-        req_recv.resizeNoInitialize(n_proc);
-        stat_recv.resizeNoInitialize(n_proc);
+        req_recv.resizeNoInitialize(rank_recv_ptcl_.size());
+        stat_recv.resizeNoInitialize(rank_recv_ptcl_.size());
         for(PS::S32 i=0; i<rank_recv_ptcl_.size(); i++){
             PS::S32 rank = rank_recv_ptcl_[i];
             MPI_Irecv(ptcl_recv_.getPointer(n_ptcl_disp_recv_[i]), n_ptcl_recv_[i], 
                       PS::GetDataType<PtclComm>(),
-                      rank, 2136, MPI_COMM_WORLD, req_recv.getPointer(i));
+                      rank, TAG_PTCL, comm_cluster_, req_recv.getPointer(i));
         }
-        //std::cerr<<"sendAndRecvCluster 4.7: "<<my_rank<<std::endl;
         MPI_Waitall(rank_send_ptcl_.size(), req_send.getPointer(), stat_send.getPointer());
         MPI_Waitall(rank_recv_ptcl_.size(), req_recv.getPointer(), stat_recv.getPointer());
 
-        //std::cerr<<"sendAndRecvCluster 5: "<<my_rank<<std::endl;
-#endif
-
         // make and recv particles
         ////////////
     }
@@ -1170,11 +1251,6 @@ public:
             }
         }
 
-#ifdef FDPS_COMM
-        PS::Comm::sendIrecvV(ptcl_send_.getPointer(), rank_send_ptcl_.getPointer(), n_ptcl_send_.getPointer(), n_ptcl_disp_send_.getPointer(), rank_send_ptcl_.size(),
-                             ptcl_recv_.getPointer(), rank_recv_ptcl_.getPointer(), n_ptcl_recv_.getPointer(), n_ptcl_disp_recv_.getPointer(), rank_recv_ptcl_.size());
-#else
-        
         static PS::ReallocatableArray<MPI_Request> req_send;
         static PS::ReallocatableArray<MPI_Status> stat_send;
         static PS::ReallocatableArray<MPI_Request> req_recv;
@@ -1188,17 +1264,16 @@ public:
             PS::S32 rank = rank_send_ptcl_[i];
             MPI_Isend(ptcl_send_.getPointer(n_ptcl_disp_send_[i]),  n_ptcl_send_[i],
                       PS::GetDataType<PtclComm>(),
-                      rank, 2239, MPI_COMM_WORLD, req_send.getPointer(i));
+                      rank, TAG_PTCL_SEND, comm_cluster_, req_send.getPointer(i));
         }
         for(PS::S32 i=0; i<rank_recv_ptcl_.size(); i++){
             PS::S32 rank = rank_recv_ptcl_[i];
             MPI_Irecv(ptcl_recv_.getPointer(n_ptcl_disp_recv_[i]), n_ptcl_recv_[i],
                       PS::GetDataType<PtclComm>(),
-                      rank, 2239, MPI_COMM_WORLD, req_recv.getPointer(i));
+                      rank, TAG_PTCL_SEND, comm_cluster_, req_recv.getPointer(i));
         }
         MPI_Waitall(rank_send_ptcl_.size(), req_send.getPointer(), stat_send.getPointer());
         MPI_Waitall(rank_recv_ptcl_.size(), req_recv.getPointer(), stat_recv.getPointer());
-#endif
 
         // Receive remote single particle data
         const PS::S32 n = _ptcl_hard.size();
@@ -1232,11 +1307,6 @@ public:
             ptcl_send_[i].DataCopy(_sys[adr]);
         }
 
-#ifdef FDPS_COMM
-        PS::Comm::sendIrecvV(ptcl_send_.getPointer(), rank_send_ptcl_.getPointer(), n_ptcl_send_.getPointer(), n_ptcl_disp_send_.getPointer(), rank_send_ptcl_.size(),
-                             ptcl_recv_.getPointer(), rank_recv_ptcl_.getPointer(), n_ptcl_recv_.getPointer(), n_ptcl_disp_recv_.getPointer(), rank_recv_ptcl_.size());
-#else
-        
         static PS::ReallocatableArray<MPI_Request> req_send;
         static PS::ReallocatableArray<MPI_Status> stat_send;
         static PS::ReallocatableArray<MPI_Request> req_recv;
@@ -1250,17 +1320,16 @@ public:
             PS::S32 rank = rank_send_ptcl_[i];
             MPI_Isend(ptcl_send_.getPointer(n_ptcl_disp_send_[i]),  n_ptcl_send_[i],
                       PS::GetDataType<PtclComm>(),
-                      rank, 2239, MPI_COMM_WORLD, req_send.getPointer(i));
+                      rank, TAG_PTCL_SEND, comm_cluster_, req_send.getPointer(i));
         }
         for(PS::S32 i=0; i<rank_recv_ptcl_.size(); i++){
             PS::S32 rank = rank_recv_ptcl_[i];
             MPI_Irecv(ptcl_recv_.getPointer(n_ptcl_disp_recv_[i]), n_ptcl_recv_[i],
                       PS::GetDataType<PtclComm>(),
-                      rank, 2239, MPI_COMM_WORLD, req_recv.getPointer(i));
+                      rank, TAG_PTCL_SEND, comm_cluster_, req_recv.getPointer(i));
         }
         MPI_Waitall(rank_send_ptcl_.size(), req_send.getPointer(), stat_send.getPointer());
         MPI_Waitall(rank_recv_ptcl_.size(), req_recv.getPointer(), stat_recv.getPointer());
-#endif
 
         // Receive remote single particle data
         const PS::S32 n = _ptcl_hard.size();
@@ -1277,7 +1346,9 @@ public:
     }
     
     //! send and receive particles on remote
-    /* @param[in,out] _sys: particle system
+    /*! Local particles are written back in parallel. The static schedule assigns contiguous index ranges to threads in the order of thread index,
+        thus merging the thread-local mass modification lists in this order gives the same list as the serial loop.
+       @param[in,out] _sys: particle system
        @param[in] _ptcl_hard: local partical in system_hard_connected
        @param[out] _mass_modify_list: address on _sys of particles where mass is modified
      */
@@ -1288,36 +1359,46 @@ public:
         //  const PS::S32 my_rank = PS::Comm::getRank();
         //  const PS::S32 n_proc  = PS::Comm::getNumberOfProc();
         const PS::S32 n = _ptcl_hard.size();
-        for(PS::S32 i=0; i<n; i++){
-            const PS::S32 adr = _ptcl_hard[i].adr_org;
-            if( adr >= 0){
+        const PS::S32 num_thread = PS::Comm::getNumberOfThread();
+        PS::ReallocatableArray<PS::S32> mass_modify_list_thx[num_thread];
+        for (int i=0; i<num_thread; i++) mass_modify_list_thx[i].resizeNoInitialize(0);
+
+#pragma omp parallel
+        {
+#ifdef STELLAR_EVOLUTION
+            const PS::S32 ith = PS::Comm::getThreadNum();
+#endif
+#pragma omp for schedule(static)
+            for(PS::S32 i=0; i<n; i++){
+                const PS::S32 adr = _ptcl_hard[i].adr_org;
+                if( adr >= 0){
 #ifdef HARD_DEBUG
-                assert( _sys[adr].id == _ptcl_hard[i].id);
+                    assert( _sys[adr].id == _ptcl_hard[i].id);
 #endif
 #ifdef STELLAR_EVOLUTION
-                PS::F64 mass_bk = _sys[adr].group_data.artificial.isMember()? _sys[adr].group_data.artificial.getMassBackup(): _sys[adr].mass;
-                assert(mass_bk!=0.0);
+                    PS::F64 mass_bk = _sys[adr].group_data.artificial.isMember()? _sys[adr].group_data.artificial.getMassBackup(): _sys[adr].mass;
+                    assert(mass_bk!=0.0);
 #endif
-                _sys[adr].DataCopy(_ptcl_hard[i]);
+                    _sys[adr].DataCopy(_ptcl_hard[i]);
 #ifdef STELLAR_EVOLUTION
-                _sys[adr].dm = _sys[adr].mass - mass_bk;
-                if (_sys[adr].dm!=0.0) _mass_modify_list.push_back(adr);
+                    _sys[adr].dm = _sys[adr].mass - mass_bk;
+                    if (_sys[adr].dm!=0.0) mass_modify_list_thx[ith].push_back(adr);
 #endif
-                assert(!std::isinf(_sys[adr].pos[0]));
-                assert(!std::isnan(_sys[adr].pos[0]));
-                assert(!std::isinf(_sys[adr].vel[0]));
-                assert(!std::isnan(_sys[adr].vel[0]));
-            }
-            else{
-                //assert( ptcl_recv_[-(adr+1)].id == _ptcl_hard[i].id );
-                ptcl_recv_[-(adr+1)].DataCopy(_ptcl_hard[i]);
+                    assert(!std::isinf(_sys[adr].pos[0]));
+                    assert(!std::isnan(_sys[adr].pos[0]));
+                    assert(!std::isinf(_sys[adr].vel[0]));
+                    assert(!std::isnan(_sys[adr].vel[0]));
+                }
+                else{
+                    //assert( ptcl_recv_[-(adr+1)].id == _ptcl_hard[i].id );
+                    ptcl_recv_[-(adr+1)].DataCopy(_ptcl_hard[i]);
+                }
             }
         }
-
-#ifdef FDPS_COMM
-        PS::Comm::sendIrecvV(ptcl_recv_.getPointer(), rank_recv_ptcl_.getPointer(), n_ptcl_recv_.getPointer(), n_ptcl_disp_recv_.getPointer(), rank_recv_ptcl_.size(),
-                             ptcl_send_.getPointer(), rank_send_ptcl_.getPointer(), n_ptcl_send_.getPointer(), n_ptcl_disp_send_.getPointer(), rank_send_ptcl_.size());
-#else
+        for (int i=0; i<num_thread; i++) {
+            for (int k=0; k<mass_modify_list_thx[i].size(); k++) _mass_modify_list.push_back(mass_modify_list_thx[i][k]);
+            mass_modify_list_thx[i].resizeNoInitialize(0);
+        }
 
         static PS::ReallocatableArray<MPI_Request> req_recv;
         static PS::ReallocatableArray<MPI_Status> stat_recv;
@@ -1332,35 +1413,45 @@ public:
             PS::S32 rank = rank_recv_ptcl_[i];
             MPI_Isend(ptcl_recv_.getPointer(n_ptcl_disp_recv_[i]), n_ptcl_recv_[i],
                       PS::GetDataType<PtclComm>(),
-                      rank, 2303, MPI_COMM_WORLD, req_recv.getPointer(i));
+                      rank, TAG_PTCL_BACK, comm_cluster_, req_recv.getPointer(i));
         }
         for(PS::S32 i=0; i<rank_send_ptcl_.size(); i++){
             PS::S32 rank = rank_send_ptcl_[i];
             MPI_Irecv(ptcl_send_.getPointer(n_ptcl_disp_send_[i]),  n_ptcl_send_[i],
                       PS::GetDataType<PtclComm>(),
-                      rank, 2303, MPI_COMM_WORLD, req_send.getPointer(i));
+                      rank, TAG_PTCL_BACK, comm_cluster_, req_send.getPointer(i));
         }
         MPI_Waitall(rank_send_ptcl_.size(), req_send.getPointer(), stat_send.getPointer());
         MPI_Waitall(rank_recv_ptcl_.size(), req_recv.getPointer(), stat_recv.getPointer());
-#endif
 
-        for(PS::S32 i=0; i<ptcl_send_.size(); i++){
-            PS::S32 adr = adr_sys_ptcl_send_[i];
+        const PS::S32 n_send = ptcl_send_.size();
+#pragma omp parallel
+        {
+#ifdef STELLAR_EVOLUTION
+            const PS::S32 ith = PS::Comm::getThreadNum();
+#endif
+#pragma omp for schedule(static)
+            for(PS::S32 i=0; i<n_send; i++){
+                PS::S32 adr = adr_sys_ptcl_send_[i];
 #ifdef HARD_DEBUG
-            assert(_sys[adr].id == ptcl_send_[i].id);
+                assert(_sys[adr].id == ptcl_send_[i].id);
 #endif
 #ifdef STELLAR_EVOLUTION
-            PS::F64 mass_bk = _sys[adr].group_data.artificial.isMember()? _sys[adr].group_data.artificial.getMassBackup(): _sys[adr].mass;
+                PS::F64 mass_bk = _sys[adr].group_data.artificial.isMember()? _sys[adr].group_data.artificial.getMassBackup(): _sys[adr].mass;
 #endif
-            _sys[adr].DataCopy(ptcl_send_[i]);
+                _sys[adr].DataCopy(ptcl_send_[i]);
 #ifdef STELLAR_EVOLUTION
-            _sys[adr].dm = _sys[adr].mass - mass_bk;
-            if (_sys[adr].dm!=0.0) _mass_modify_list.push_back(adr);
+                _sys[adr].dm = _sys[adr].mass - mass_bk;
+                if (_sys[adr].dm!=0.0) mass_modify_list_thx[ith].push_back(adr);
 #endif
-            assert(!std::isinf(_sys[adr].pos[0]));
-            assert(!std::isnan(_sys[adr].pos[0]));
-            assert(!std::isinf(_sys[adr].vel[0]));
-            assert(!std::isnan(_sys[adr].vel[0]));
+                assert(!std::isinf(_sys[adr].pos[0]));
+                assert(!std::isnan(_sys[adr].pos[0]));
+                assert(!std::isinf(_sys[adr].vel[0]));
+                assert(!std::isnan(_sys[adr].vel[0]));
+            }
+        }
+        for (int i=0; i<num_thread; i++) {
+            for (int k=0; k<mass_modify_list_thx[i].size(); k++) _mass_modify_list.push_back(mass_modify_list_thx[i][k]);
         }
     }
 
@@ -1,4 +1,5 @@
 #pragma once
+#include "global_reduction.hpp"
 
 //! class for collecting and calculating the energy and angular momentum of the system
 class EnergyAndMomentum{
@@ -279,14 +280,28 @@ public:
         }
     }
 
-    //! get summation of kinetic, potential energy and angular momentum of all MPI processes
+    //! add local kinetic, potential energy and angular momentum to a fused global reduction
     /*!
+      @param[in] _reduction: global reduction collector
+      \return index of the first value in _reduction
+     */
+    PS::S32 addToReduction(GlobalReduction& _reduction) const {
+        const PS::S32 index = _reduction.add(ekin);
+        _reduction.add(epot);
+        _reduction.add(L);
+        return index;
+    }
+
+    //! set kinetic, potential energy and angular momentum from a finished global reduction
+    /*!
+      @param[in] _reduction: global reduction collector
+      @param[in] _index: index returned by addToReduction
       @param[in] _init_flag: if true, set etot, etot_sd and L reference
      */
-    void getSumMultiNodes(const bool _init_flag=false) {
-        ekin = PS::Comm::getSum(ekin);
-        epot = PS::Comm::getSum(epot);
-        L   = PS::Comm::getSum(L);
+    void setSumFromReduction(GlobalReduction& _reduction, const PS::S32 _index, const bool _init_flag=false) {
+        ekin = _reduction.getSum(_index);
+        epot = _reduction.getSum(_index+1);
+        L   = _reduction.getSumVec(_index+2);
         Lt  = std::sqrt(L*L);
         if (_init_flag) {
             etot_ref = ekin + epot;
@@ -297,6 +312,17 @@ public:
         }
     }
 
+    //! get summation of kinetic, potential energy and angular momentum of all MPI processes
+    /*!
+      @param[in] _init_flag: if true, set etot, etot_sd and L reference
+     */
+    void getSumMultiNodes(const bool _init_flag=false) {
+        GlobalReduction reduction;
+        const PS::S32 index = addToReduction(reduction);
+        reduction.reduce();
+        setSumFromReduction(reduction, index, _init_flag);
+    }
+
     //! save current energy error
     void saveEnergyError() {
         error_cum_pre = getEnergyError();
@@ -1769,7 +1769,8 @@ struct SearchNeighborEpEpFugaku{
     void initialize(){
     }
     int kernel_id = 0;
-    void operator()(const EPISoft* __restrict__ epi,const int ni,const EPJSoft* __restrict__ epj,const int nj,ForceSoft* __restrict__ force,const int kernel_select = 1){
+    template <class Tepj>
+    void operator()(const EPISoft* __restrict__ epi,const int ni,const Tepj* __restrict__ epj,const int nj,ForceSoft* __restrict__ force,const int kernel_select = 1){
         static_assert(sizeof(EPI32) == 16,"check consistency of EPI member variable definition between PIKG source and original source");
         if(kernel_select>=0) kernel_id = kernel_select;
         if(kernel_id == 0){
@@ -1807,7 +1808,8 @@ struct SearchNeighborEpEpFugaku{
         if(kernel_id == 2) Kernel_I1_J16(epi,ni,epj,nj,force);
     } // operator() definition 
 
-    void Kernel_I16_J1(const EPISoft* __restrict__ epi,const PIKG::S32 ni,const EPJSoft* __restrict__ epj,const PIKG::S32 nj, ForceSoft* __restrict__ force){
+    template <class Tepj>
+    void Kernel_I16_J1(const EPISoft* __restrict__ epi,const PIKG::S32 ni,const Tepj* __restrict__ epj,const PIKG::S32 nj, ForceSoft* __restrict__ force){
         PIKG::S32 i;
         PIKG::S32 j;
 
@@ -1907,7 +1909,8 @@ struct SearchNeighborEpEpFugaku{
         }
         
     } // Kernel_I16_J1 definition 
-    void Kernel_I1_J16(const EPISoft* __restrict__ epi,const PIKG::S32 ni,const EPJSoft* __restrict__ epj,const PIKG::S32 nj, ForceSoft* __restrict__ force){
+    template <class Tepj>
+    void Kernel_I1_J16(const EPISoft* __restrict__ epi,const PIKG::S32 ni,const Tepj* __restrict__ epj,const PIKG::S32 nj, ForceSoft* __restrict__ force){
         PIKG::S32 i;
         PIKG::S32 j;
 
@@ -0,0 +1,125 @@
+#pragma once
+#include <particle_simulator.hpp>
+#include "ptcl.hpp"
+
+//! fused leap-frog kick of all particle categories
+/*! The kick of one tree step updates the velocities of single particles in system_soft (one-particle clusters),
+    of particles in the hard systems of isolated and connected clusters (members are kicked with the force of their c.m.),
+    of artificial c.m. particles in system_soft and of single particles in the sending list of connected clusters.
+    kickAll() processes all categories in one OpenMP parallel region (one fork-join, loops without barriers between categories).
+    The arithmetic is the same as the separate kick functions, so results are identical.
+    Each particle is still read and written once as in the separate kicks, thus the memory traffic is unchanged;
+    only the fork-joins and barriers of the separate parallel loops are saved.
+ */
+template <class Tsoft>
+class FusedKick{
+private:
+    //! kick of single particles and cluster particles
+    template <class Tptcl>
+    static void kickCluster(Tptcl& _p, const Tsoft& _f, const PS::F64 _dt) {
+#ifdef KDKDK_4TH
+        _p.vel += _dt*(_f.acc + 9.0/192.0*_dt*_dt*_f.acorr);
+#else
+        _p.vel += _f.acc * _dt;
+#endif
+    }
+
+    //! kick of artificial c.m. particles and sending list particles
+    template <class Tptcl>
+    static void kickCM(Tptcl& _p, const Tsoft& _f, const PS::F64 _dt) {
+        _p.vel += _f.acc * _dt;
+#ifdef KDKDK_4TH
+        _p.vel += _dt*_dt* _f.acorr /48;
+#endif
+    }
+
+    //! kick particles in the hard system of clusters and recover the mass of members
+    template <class Tsys, class Tptcl>
+    static void kickHardCluster(Tsys& _sys, PS::ReallocatableArray<Tptcl>& _ptcl, const PS::F64 _dt) {
+        const PS::S64 n = _ptcl.size();
+#pragma omp for nowait
+        for (PS::S64 i=0; i<n; i++) {
+            auto& pi_artificial = _ptcl[i].group_data.artificial;
+            // if is group member, recover mass and kick due to c.m. force
+            if (pi_artificial.isMember()) {
+                const PS::S64 cm_adr = _ptcl[i].getParticleCMAddress();
+                if (cm_adr>0) {
+#ifdef HARD_DEBUG
+                    assert(pi_artificial.getMassBackup()>0);
+#endif
+                    _ptcl[i].mass = pi_artificial.getMassBackup();
+                    kickCluster(_ptcl[i], _sys[cm_adr], _dt);
+                    continue;
+                }
+            }
+            // non-member particle, remote particles are not kicked
+            const PS::S64 i_adr =_ptcl[i].adr_org;
+            if (i_adr>=0) kickCluster(_ptcl[i], _sys[i_adr], _dt);
+        }
+    }
+
+public:
+    //! kick all particle categories in one parallel region
+    /*! Single particles are reset to the single type and group members in hard systems recover their masses,
+        same as the separate kicks of PeTar (kickClusterAndRecoverGroupMemberMass and kickSend are still used for the mass recovery in the initial step).
+      @param[in,out] _sys: particle system
+      @param[in] _adr_single: addresses of single particles (one-particle clusters) in _sys
+      @param[in,out] _ptcl_iso: particles of isolated clusters
+      @param[in,out] _ptcl_con: particles of connected clusters (NULL: no MPI)
+      @param[in] _adr_send: addresses of particles in the sending list in _sys (NULL: no MPI)
+      @param[in] _adr_artificial_start: starting address of artificial particles in _sys
+      @param[in] _ap_manager: artificial particle manager
+      @param[in] _dt: tree step
+     */
+    template <class Tsys, class Tptcl>
+    static void kickAll(Tsys& _sys,
+                        const PS::ReallocatableArray<PS::S32>& _adr_single,
+                        PS::ReallocatableArray<Tptcl>& _ptcl_iso,
+                        PS::ReallocatableArray<Tptcl>* _ptcl_con,
+                        const PS::ReallocatableArray<PS::S32>* _adr_send,
+                        const PS::S32 _adr_artificial_start,
+                        ArtificialParticleManager& _ap_manager,
+                        const PS::F64 _dt) {
+        const PS::S64 n_single = _adr_single.size();
+        const PS::S64 n_tot = _sys.getNumberOfParticleLocal();
+        const PS::S32 n_artificial_per_group = _ap_manager.getArtificialParticleN();
+        const PS::S64 n_cm = n_tot>_adr_artificial_start? (n_tot - _adr_artificial_start)/n_artificial_per_group: 0;
+        const PS::S64 n_send = _adr_send==NULL? 0: _adr_send->size();
+
+        // loops of different categories write disjoint data, so no barrier is needed between them
+#pragma omp parallel
+        {
+            // single and reset particle type to single (due to binary disruption)
+#pragma omp for nowait
+            for (PS::S64 i=0; i<n_single; i++) {
+                const PS::S32 k = _adr_single[i];
+                kickCluster(_sys[k], _sys[k], _dt);
+                _sys[k].group_data.artificial.setParticleTypeToSingle();
+            }
+
+            // isolated and connected clusters
+            kickHardCluster(_sys, _ptcl_iso, _dt);
+            if (_ptcl_con!=NULL) kickHardCluster(_sys, *_ptcl_con, _dt);
+
+            // c.m. artificial
+#pragma omp for nowait
+            for (PS::S64 i=0; i<n_cm; i++) {
+                auto* pcm = _ap_manager.getCMParticles(&(_sys[_adr_artificial_start + i*n_artificial_per_group]));
+#ifdef HARD_DEBUG
+                assert(pcm->group_data.artificial.isCM());
+#endif
+                kickCM(*pcm, *pcm, _dt);
+            }
+
+            // sending list of connected clusters
+            // if it is group member with artificial particles, should not do kick since the required c.m. forces is on remote nodes;
+            // if it is group member without artificial particles, also kick
+#pragma omp for nowait
+            for (PS::S64 i=0; i<n_send; i++) {
+                const PS::S64 adr = (*_adr_send)[i];
+                if (_sys[adr].group_data.artificial.isSingle() || (_sys[adr].group_data.artificial.isMember() && _sys[adr].getParticleCMAddress()<0)) 
+                    kickCM(_sys[adr], _sys[adr], _dt);
+            }
+        }
+    }
+};
@@ -0,0 +1,160 @@
+#pragma once
+#include<particle_simulator.hpp>
+#include<cassert>
+#include<cmath>
+#include"trace.hpp"
+
+//! Collect small global summations of one synchronization point into one collective
+/*! Local values are appended by add(), which returns the index to get the global summation after reduction.
+    reduce() does one blocking allreduce for all values;
+    startReduce() issues a non-blocking allreduce and waitReduce() finishes it, so that the communication can overlap with local work.
+    Boolean OR can be obtained by adding 0/1 and checking the summation >0.
+    Integer values are stored as double, which is exact up to 2^53.
+
+    The number of issued collectives is recorded by a counter shared by all instances,
+    in order to report the collective number per step in the profile.
+    Other collectives (e.g. barrier) can be registered by countCollective().
+ */
+class GlobalReduction{
+private:
+    PS::ReallocatableArray<PS::F64> data_loc_;
+    PS::ReallocatableArray<PS::F64> data_glb_;
+    bool pending_flag_; // true: non-blocking reduction is issued but not finished
+    bool reduced_flag_; // true: global values are available
+#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
+    MPI_Request req_;
+#endif
+
+    static PS::S64& collectiveCounter() {
+        static PS::S64 n_collective = 0;
+        return n_collective;
+    }
+
+public:
+    GlobalReduction(): data_loc_(), data_glb_(), pending_flag_(false), reduced_flag_(false) {}
+
+    //! count collectives issued outside GlobalReduction
+    static void countCollective(const PS::S64 _n=1) {
+#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
+        collectiveCounter() += _n;
+#endif
+    }
+
+    //! get number of collectives recorded since last reset
+    static PS::S64 getCollectiveCount() {
+        return collectiveCounter();
+    }
+
+    //! reset the collective counter
+    static void resetCollectiveCount() {
+        collectiveCounter() = 0;
+    }
+
+    //! clear local values for a new reduction
+    void clear() {
+        if (pending_flag_) waitReduce();
+        data_loc_.resizeNoInitialize(0);
+        reduced_flag_ = false;
+    }
+
+    //! add a local value
+    /*! \return index of the value
+     */
+    PS::S32 add(const PS::F64 _value) {
+        assert(!pending_flag_);
+        data_loc_.push_back(_value);
+        return data_loc_.size()-1;
+    }
+
+    //! add a local vector
+    /*! \return index of the x component, y and z follow
+     */
+    PS::S32 add(const PS::F64vec & _vec) {
+        PS::S32 index = add(_vec.x);
+        add(_vec.y);
+        add(_vec.z);
+        return index;
+    }
+
+    //! issue non-blocking reduction of all added values
+    void startReduce() {
+        assert(!pending_flag_);
+        const PS::S32 n = data_loc_.size();
+        data_glb_.resizeNoInitialize(n);
+#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
+        if (n>0) {
+            MPI_Iallreduce(data_loc_.getPointer(), data_glb_.getPointer(), n, PS::GetDataType<PS::F64>(), MPI_SUM, MPI_COMM_WORLD, &req_);
+            pending_flag_ = true;
+            countCollective();
+        }
+#else
+        for (PS::S32 i=0; i<n; i++) data_glb_[i] = data_loc_[i];
+#endif
+        reduced_flag_ = true;
+    }
+
+    //! finish non-blocking reduction
+    /*! The waiting time is recorded in the timeline trace if it is switched on
+     */
+    void waitReduce() {
+#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
+        if (pending_flag_) {
+            if (trace_log.isActive()) {
+                PS::F64 t_start = PS::GetWtime();
+                MPI_Wait(&req_, MPI_STATUS_IGNORE);
+                trace_log.add("Allreduce_wait", t_start, PS::GetWtime(), "n_value", data_loc_.size());
+            }
+            else MPI_Wait(&req_, MPI_STATUS_IGNORE);
+        }
+#endif
+        pending_flag_ = false;
+    }
+
+    //! blocking reduction of all added values
+    void reduce() {
+        startReduce();
+        waitReduce();
+    }
+
+    //! check whether a non-blocking reduction is not yet finished
+    bool isPending() const {
+        return pending_flag_;
+    }
+
+    //! check whether global values are available (reduction is issued)
+    bool isReduced() const {
+        return reduced_flag_;
+    }
+
+    //! get global summation of value at index, wait if reduction is not finished
+    PS::F64 getSum(const PS::S32 _index) {
+        assert(reduced_flag_);
+        if (pending_flag_) waitReduce();
+        assert(_index<data_glb_.size());
+        return data_glb_[_index];
+    }
+
+    //! get global summation of integer value
+    PS::S64 getSumInt(const PS::S32 _index) {
+        return PS::S64(std::round(getSum(_index)));
+    }
+
+    //! get global summation of vector at index
+    PS::F64vec getSumVec(const PS::S32 _index) {
+        return PS::F64vec(getSum(_index), getSum(_index+1), getSum(_index+2));
+    }
+
+    //! get global OR of flag at index
+    bool getOr(const PS::S32 _index) {
+        return getSum(_index)>0.0;
+    }
+
+    ~GlobalReduction() {
+#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
+        // the instance may be destroyed after MPI is finalized
+        int finalized_flag = 0;
+        MPI_Finalized(&finalized_flag);
+        if (!finalized_flag) waitReduce();
+#endif
+    }
+};
@@ -0,0 +1,221 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <utility>
+#include "Common/binary_tree.h"
+
+//! orbital sample (pseudo) particle relative to the c.m. of a group
+struct OrbitalSampleRecord{
+    PS::F64vec pos;
+    PS::F64vec vel;
+    PS::F64 mass;
+};
+
+//! one binary tree node of a group record
+struct GroupNodeRecord{
+    PS::S64 id;         // binary id (minimum member id)
+    PS::S32 n_members;  // number of members in the branch
+    PS::F64 semi, ecc, incline, rot_horizon, rot_self;
+    PS::F64 m1, m2;
+
+    //! save orbital parameters of a binary tree node
+    template <class Tbin>
+    void set(const Tbin& _bin) {
+        id = _bin.id;
+        n_members = _bin.getMemberN();
+        semi = _bin.semi;
+        ecc  = _bin.ecc;
+        incline = _bin.incline;
+        rot_horizon = _bin.rot_horizon;
+        rot_self = _bin.rot_self;
+        m1 = _bin.m1;
+        m2 = _bin.m2;
+    }
+
+    //! check whether a binary tree node has the same branch and similar orbit
+    template <class Tbin>
+    bool isConsistent(const Tbin& _bin, const PS::F64 _tol) const {
+        if (id!=_bin.id || n_members!=_bin.getMemberN()) return false;
+        if (std::abs(semi - _bin.semi) > _tol*std::abs(semi)) return false;
+        if (std::abs(ecc - _bin.ecc) > _tol) return false;
+        if (std::abs(incline - _bin.incline) > _tol) return false;
+        if (std::abs(rot_horizon - _bin.rot_horizon) > _tol) return false;
+        if (std::abs(rot_self - _bin.rot_self) > _tol) return false;
+        if (std::abs(m1 - _bin.m1) > _tol*m1) return false;
+        if (std::abs(m2 - _bin.m2) > _tol*m2) return false;
+        return true;
+    }
+};
+
+//! persistent record of one group candidate
+/*! Save the verdicts of the stability check and the artificial particle layout of a group candidate from the last tree step.
+    The record is valid when the member IDs, the binary tree structure and the orbital parameters of all nodes do not change (within tolerance),
+    and the tree step, the period criterion and the changeover radius are the same.
+ */
+struct GroupRecord{
+    PS::S32 n_ptcl_cluster;        // number of particles in the cluster (isolated binary case depends on it)
+    PS::F64 dt_tree;               // tree time step
+    PS::F64 t_crit;                // period criterion of stability check
+    PS::F64 r_in;                  // changeover inner radius of the root
+    std::vector<PS::S64> member_id;  // sorted member id
+    std::vector<GroupNodeRecord> node; // binary tree nodes in the order of processTreeIter
+    std::vector<PS::S32> stable_node;  // node index of stable sub-trees, in the order of Stability::stable_binary_tree
+    bool isolated_binary_flag;     // true: isolated binary without artificial particles
+    std::vector<OrbitalSampleRecord> orbit_sample; // orbital sample particles relative to c.m. for each stable sub-tree
+
+    GroupRecord(): n_ptcl_cluster(0), dt_tree(0.0), t_crit(0.0), r_in(0.0), member_id(), node(), stable_node(), isolated_binary_flag(false), orbit_sample() {}
+
+    //! check whether the record can be reused for a new binary tree
+    /*! @param[in] _node: binary tree nodes in the order of processTreeIter
+        @param[in] _n_node: number of nodes
+     */
+    template <class Tbin>
+    bool isConsistent(Tbin** _node, const PS::S32 _n_node, const PS::S32 _n_ptcl_cluster, const PS::F64 _dt_tree, const PS::F64 _t_crit, const PS::F64 _r_in, const PS::F64 _tol) const {
+        if (n_ptcl_cluster!=_n_ptcl_cluster || dt_tree!=_dt_tree || t_crit!=_t_crit || r_in!=_r_in) return false;
+        if (PS::S32(node.size())!=_n_node) return false;
+        for (PS::S32 i=0; i<_n_node; i++)
+            if (!node[i].isConsistent(*_node[i], _tol)) return false;
+        return true;
+    }
+};
+
+//! cache of group records between tree steps
+/*! The records are kept in a pool and searched by the sorted member IDs.
+    During the parallel group search, threads only collect the pool indices of reused records and move newly built records
+    to thread-local buffers, thus no record is copied. In update(), the pool slots of records that are not used in this step are freed
+    and the new records are moved to free slots.
+    The orbital parameters of a record are compared with the relative tolerance. With zero tolerance, a record is only reused for
+    identical orbits and the groups and artificial particles are the same as without records.
+ */
+class GroupRecordCache{
+private:
+    std::vector<GroupRecord> pool_;              // records
+    std::vector<PS::S32> pool_free_;             // free slots of pool_
+    std::unordered_map<PS::S64, PS::S32> index_; // key to pool index
+    std::vector<std::vector<std::pair<PS::S64,PS::S32>>> index_next_;  // reused records of each thread
+    std::vector<std::vector<std::pair<PS::S64,GroupRecord>>> record_new_; // new records of each thread
+    std::vector<char> pool_used_;
+    PS::S64 n_hit_sum_;  // accumulated number of reused records
+    PS::S64 n_miss_sum_; // accumulated number of rebuilt records
+
+public:
+    PS::F64 tolerance; // relative tolerance of orbital parameters to reuse a record
+
+    GroupRecordCache(): pool_(), pool_free_(), index_(), index_next_(), record_new_(), pool_used_(), n_hit_sum_(0), n_miss_sum_(0), tolerance(0.0) {}
+
+    //! calculate the hash key from sorted member IDs
+    static PS::S64 calcKey(const PS::S64* _id, const PS::S32 _n) {
+        PS::U64 key = 1469598103934665603ULL;
+        for (PS::S32 i=0; i<_n; i++) {
+            key ^= PS::U64(_id[i]);
+            key *= 1099511628211ULL;
+        }
+        return PS::S64(key>>1);
+    }
+
+    //! binary tree iteration function to collect node addresses
+    template <class Tbin>
+    static PS::S32 collectNodeIter(std::vector<Tbin*>& _node, const PS::S32& _r1, const PS::S32& _r2, Tbin& _bin) {
+        _node.push_back(&_bin);
+        return 0;
+    }
+
+    //! prepare thread-local buffers before the parallel group search
+    void prepare(const PS::S32 _n_thread) {
+        index_next_.resize(_n_thread);
+        record_new_.resize(_n_thread);
+        for (PS::S32 i=0; i<_n_thread; i++) {
+            index_next_[i].clear();
+            record_new_[i].clear();
+        }
+    }
+
+    //! find a record, thread safe during the parallel group search
+    /*! @param[in] _key: hash key
+        @param[in] _id: sorted member IDs
+        @param[in] _n: number of members
+        \return the pool index of the record, -1 if not found
+     */
+    PS::S32 find(const PS::S64 _key, const PS::S64* _id, const PS::S32 _n) const {
+        auto item = index_.find(_key);
+        if (item==index_.end()) return -1;
+        const GroupRecord& record = pool_[item->second];
+        if (PS::S32(record.member_id.size())!=_n) return -1;
+        for (PS::S32 i=0; i<_n; i++) if (record.member_id[i]!=_id[i]) return -1;
+        return item->second;
+    }
+
+    //! get a record by the pool index from find()
+    const GroupRecord& getRecord(const PS::S32 _index) const {
+        return pool_[_index];
+    }
+
+    //! keep a reused record for the next step
+    void keep(const PS::S32 _ith, const PS::S64 _key, const PS::S32 _index) {
+        index_next_[_ith].push_back(std::make_pair(_key, _index));
+    }
+
+    //! add a new record for the next step, the record is moved
+    void add(const PS::S32 _ith, const PS::S64 _key, GroupRecord& _record) {
+        record_new_[_ith].push_back(std::make_pair(_key, std::move(_record)));
+    }
+
+    //! replace the cache by the records kept or added in this step
+    void update() {
+        pool_used_.assign(pool_.size(), 0);
+        index_.clear();
+        for (auto& buffer: index_next_) {
+            n_hit_sum_ += buffer.size();
+            for (auto& item: buffer) {
+                pool_used_[item.second] = 1;
+                index_[item.first] = item.second;
+            }
+            buffer.clear();
+        }
+        pool_free_.clear();
+        for (PS::S32 i=0; i<PS::S32(pool_.size()); i++) if (!pool_used_[i]) pool_free_.push_back(i);
+        for (auto& buffer: record_new_) {
+            n_miss_sum_ += buffer.size();
+            for (auto& item: buffer) {
+                PS::S32 k;
+                if (pool_free_.size()>0) {
+                    k = pool_free_.back();
+                    pool_free_.pop_back();
+                    pool_[k] = std::move(item.second);
+                }
+                else {
+                    k = pool_.size();
+                    pool_.push_back(std::move(item.second));
+                }
+                index_[item.first] = k;
+            }
+            buffer.clear();
+        }
+    }
+
+    //! get the accumulated number of reused records
+    PS::S64 getHitN() const {
+        return n_hit_sum_;
+    }
+
+    //! get the accumulated number of rebuilt records
+    PS::S64 getMissN() const {
+        return n_miss_sum_;
+    }
+
+    //! reset counters
+    void clearProfile() {
+        n_hit_sum_ = 0;
+        n_miss_sum_ = 0;
+    }
+
+    //! clear all records
+    void clear() {
+        pool_.clear();
+        pool_free_.clear();
+        index_.clear();
+        for (auto& buffer: index_next_) buffer.clear();
+        for (auto& buffer: record_new_) buffer.clear();
+    }
+};
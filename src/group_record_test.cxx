@@ -0,0 +1,296 @@
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <string>
+#include <unordered_map>
+#include <particle_simulator.hpp>
+
+#include <getopt.h>
+#include "io.hpp"
+#include "hard_assert.hpp"
+#include "cluster_list.hpp"
+#include "hard.hpp"
+#include "soft_ptcl.hpp"
+#include "static_variables.hpp"
+
+#ifndef HARD_GROUP_RECORD
+#error "group record test requires HARD_GROUP_RECORD"
+#endif
+
+class IOParamsGroupRecordTest{
+public:
+    // IO parameters
+    IOParamsContainer input_par_store;
+    IOParams<PS::F64> rin;
+    IOParams<PS::F64> rout;
+    IOParams<PS::F64> rbin;
+    IOParams<PS::F64> dt_limit;
+    IOParams<PS::S64> n;
+    IOParams<PS::S64> n_split;
+    IOParams<std::string> fname_inp;
+
+    bool print_flag;
+
+    IOParamsGroupRecordTest(): input_par_store(),
+                               rin  (input_par_store, 0.0, "r-in", "changeover inner boundary"),
+                               rout (input_par_store, 0.0, "r-out","changeover outer boundary"),
+                               rbin (input_par_store, 0.0, "r-bin","group radius"),
+                               dt_limit(input_par_store, 0.0, "s", "tree time step"),
+                               n    (input_par_store, 0, "n", "number of particles"),
+                               n_split (input_par_store, 4,  "n-split", "Number of binary sample points for tree perturbation force"),
+                               fname_inp(input_par_store, "__NONE__", "snap-filename", "Input data file", NULL, false),
+                               print_flag(false) {}
+
+    int read(int argc, char *argv[], const int opt_used_pre=0) {
+        static int flag=-1;
+        static struct option long_options[] = {
+            {rin.key,     required_argument, &flag, 1},
+            {rout.key,    required_argument, &flag, 2},
+            {rbin.key,    required_argument, &flag, 3},
+            {n_split.key, required_argument, &flag, 4},
+            {"help",      no_argument, 0, 'h'},
+            {0,0,0,0}
+        };
+
+        int opt_used = opt_used_pre;
+        int copt;
+        int option_index;
+        optind = 0; // reset getopt
+        while ((copt = getopt_long(argc, argv, "-s:n:h", long_options, &option_index)) != -1)
+            switch (copt) {
+            case 0:
+                switch (flag) {
+                case 1:
+                    rin.value = atof(optarg);
+                    if(print_flag) rin.print(std::cout);
+                    opt_used += 2;
+                    break;
+                case 2:
+                    rout.value = atof(optarg);
+                    if(print_flag) rout.print(std::cout);
+                    opt_used += 2;
+                    break;
+                case 3:
+                    rbin.value = atof(optarg);
+                    if(print_flag) rbin.print(std::cout);
+                    opt_used += 2;
+                    break;
+                case 4:
+                    n_split.value = atoi(optarg);
+                    if(print_flag) n_split.print(std::cout);
+                    opt_used += 2;
+                    break;
+                default:
+                    break;
+                }
+                break;
+            case 's':
+                dt_limit.value = atof(optarg);
+                if(print_flag) dt_limit.print(std::cout);
+                opt_used += 2;
+                break;
+            case 'n':
+                n.value = atoi(optarg);
+                if(print_flag) n.print(std::cout);
+                opt_used += 2;
+                break;
+            case 'h':
+                if(print_flag) {
+                    std::cout<<"The tool to test that reused group records give the same groups and artificial particles as new ones\n"
+                             <<"Usage: petar.group.record.test [options] [data filename]\n"
+                             <<"       Data file content per line:\n";
+                    ParticleBase::printTitleWithMeaning(std::cout,0,13);
+                    std::cout<<"Options:\n";
+                    input_par_store.printHelp(std::cout, 2, 10, 23);
+                }
+                return -1;
+            case '?':
+                opt_used +=2;
+                break;
+            default:
+                break;
+            }
+        opt_used ++;
+        if (opt_used<argc) {
+            fname_inp.value =argv[argc-1];
+            if(print_flag) std::cout<<"Reading data file name: "<<fname_inp.value<<std::endl;
+        }
+
+        if(print_flag) std::cout<<"----- Finish reading input options -----\n";
+
+        return opt_used-1;
+    }
+
+    //! check paramters
+    bool checkParams() {
+        assert(rin.value>0.0);
+        assert(rout.value>rin.value);
+        assert(rbin.value>0.0&&rbin.value<rin.value);
+        assert(dt_limit.value>0.0);
+        assert(n.value>0);
+        assert(n_split.value>=0);
+        return true;
+    }
+};
+
+//! compare two particles bitwise
+template <class Tptcl>
+bool isSameParticle(const Tptcl& _p1, const Tptcl& _p2) {
+    return (std::memcmp(&_p1.pos, &_p2.pos, sizeof(_p1.pos))==0
+            && std::memcmp(&_p1.vel, &_p2.vel, sizeof(_p1.vel))==0
+            && std::memcmp(&_p1.mass, &_p2.mass, sizeof(_p1.mass))==0
+            && _p1.group_data.artificial.getStatus()==_p2.group_data.artificial.getStatus()
+            && _p1.group_data.artificial.getMassBackup()==_p2.group_data.artificial.getMassBackup());
+}
+
+int main(int argc, char** argv)
+{
+    IOParamsGroupRecordTest io;
+    io.print_flag = true;
+    int opt_used = io.read(argc,argv);
+    if (opt_used==-1) return 0;
+    io.checkParams();
+
+    // open data file
+    FILE* fin;
+    if ( (fin = fopen(io.fname_inp.value.c_str(),"r")) == NULL) {
+        fprintf(stderr,"Error: Cannot open input file %s.\n",io.fname_inp.value.c_str());
+        abort();
+    }
+
+    PS::F64 &rin = io.rin.value;
+    PS::F64 &rout = io.rout.value;
+    PS::F64 &rbin = io.rbin.value;
+    PS::F64 &dt_limit = io.dt_limit.value;
+    PS::S64 &N = io.n.value;
+
+    ParticleBase pin;
+    PS::ReallocatableArray<PS::S32> p_list;
+    PS::ReallocatableArray<PS::S32> n_cluster;
+    p_list.resizeNoInitialize(N);
+    n_cluster.resizeNoInitialize(1);
+    n_cluster[0] = N;
+
+    PS::ParticleSystem<FPSoft> sys;
+
+    PS::F64 m_average =0;
+    for (int i=0; i<N; i++) {
+        pin.readAscii(fin);
+        ChangeOver co;
+        GroupDataDeliver gdata;
+        sys.addOneParticle(FPSoft(Ptcl(pin, rout, i+1, gdata, co), 0, i));
+        p_list[i]=i;
+        m_average += pin.mass;
+    }
+    fclose(fin);
+    m_average /= N;
+    Ptcl::r_search_min = rout;
+    Ptcl::search_factor = 3;
+    Ptcl::r_group_crit_ratio = rbin/rin;
+    Ptcl::mean_mass_inv = 1.0/m_average;
+
+    for (int i=0; i<N; i++) {
+        sys[i].changeover.setR(sys[i].mass*Ptcl::mean_mass_inv, rin, rout);
+        sys[i].calcRSearch(dt_limit);
+    }
+
+    HardManager hard_manager;
+    hard_manager.setDtRange(dt_limit, 40);
+    hard_manager.setEpsSq(0.0);
+    hard_manager.setGravitationalConstant(1.0);
+    hard_manager.r_in_base = rin;
+    hard_manager.r_out_base = rout;
+    hard_manager.energy_error_max = NUMERIC_FLOAT_MAX;
+    hard_manager.n_step_per_orbit = 8;
+    hard_manager.ap_manager.r_tidal_tensor = rbin;
+    hard_manager.ap_manager.id_offset = N;
+#ifdef ORBIT_SAMPLING
+    hard_manager.ap_manager.orbit_manager.setParticleSplitN(io.n_split.value);
+#endif
+    hard_manager.h4_manager.step.eta_4th = 0.1;
+    hard_manager.h4_manager.step.eta_2nd = 0.001;
+    hard_manager.h4_manager.step.calcAcc0OffsetSq(m_average, rout, 1.0);
+    hard_manager.ar_manager.energy_error_relative_max = 1e-8;
+    hard_manager.ar_manager.step_count_max = 1e6;
+    hard_manager.ar_manager.step.initialSymplecticCofficients(-6);
+    hard_manager.ar_manager.slowdown_pert_ratio_ref = 1e-4;
+    hard_manager.ar_manager.slowdown_timescale_max = dt_limit;
+    hard_manager.ar_manager.interrupt_detection_option = 0;
+    hard_manager.checkParams();
+
+    SystemHard sys_hard;
+    sys_hard.manager = &hard_manager;
+    sys_hard.allocateHardIntegrator(1);
+    sys_hard.getGroupRecord().tolerance = 0.0;
+    sys_hard.setTimeOrigin(0.0);
+
+    const PS::S32 n_sys = sys.getNumberOfParticleLocal();
+    PS::ReallocatableArray<FPSoft> ptcl_init;
+    ptcl_init.resizeNoInitialize(n_sys);
+    for (int i=0; i<n_sys; i++) ptcl_init[i] = sys[i];
+
+    // the first search builds the records, the second search of the same particles reuses all of them
+    PS::ReallocatableArray<FPSoft> ptcl_result[2];
+    PS::ReallocatableArray<PtclH4> ptcl_hard_result[2];
+    PS::S32 n_group[2];
+    for (int k=0; k<2; k++) {
+        sys.setNumberOfParticleLocal(n_sys);
+        for (int i=0; i<n_sys; i++) sys[i] = ptcl_init[i];
+        sys_hard.setPtclForIsolatedMultiClusterOMP(sys, p_list, n_cluster);
+        sys_hard.findGroupsAndCreateArtificialParticlesOMP<PS::ParticleSystem<FPSoft>, FPSoft>(sys, dt_limit);
+
+        const PS::S32 n_all = sys.getNumberOfParticleLocal();
+        ptcl_result[k].resizeNoInitialize(n_all);
+        for (int i=0; i<n_all; i++) ptcl_result[k][i] = sys[i];
+        auto& hard_ptcl = sys_hard.getPtcl();
+        ptcl_hard_result[k].resizeNoInitialize(hard_ptcl.size());
+        for (int i=0; i<hard_ptcl.size(); i++) ptcl_hard_result[k][i] = hard_ptcl[i];
+        n_group[k] = sys_hard.getGroupNumberOfMemberList()[0];
+
+        std::cout<<"Search "<<k<<": groups = "<<n_group[k]
+                 <<" artificial particles = "<<n_all - n_sys
+                 <<" reused records (accumulated) = "<<sys_hard.getGroupRecord().getHitN()
+                 <<" rebuilt records (accumulated) = "<<sys_hard.getGroupRecord().getMissN()<<std::endl;
+    }
+
+    PS::S32 n_fail = 0;
+    const GroupRecordCache& group_record = sys_hard.getGroupRecord();
+    if (group_record.getMissN()==0) {
+        std::cerr<<"Error: no group record is built, the test data has no group\n";
+        n_fail++;
+    }
+    if (group_record.getHitN()!=group_record.getMissN()) {
+        std::cerr<<"Error: reused records "<<group_record.getHitN()<<" != records of the first search "<<group_record.getMissN()<<std::endl;
+        n_fail++;
+    }
+    if (n_group[0]!=n_group[1]) {
+        std::cerr<<"Error: group number differs "<<n_group[0]<<" "<<n_group[1]<<std::endl;
+        n_fail++;
+    }
+    if (ptcl_result[0].size()!=ptcl_result[1].size()) {
+        std::cerr<<"Error: particle number differs "<<ptcl_result[0].size()<<" "<<ptcl_result[1].size()<<std::endl;
+        n_fail++;
+    }
+    else {
+        for (int i=0; i<ptcl_result[0].size(); i++) {
+            if (!isSameParticle(ptcl_result[0][i], ptcl_result[1][i])) {
+                std::cerr<<"Error: particle "<<i<<" in the system differs\n";
+                n_fail++;
+            }
+        }
+    }
+    for (int i=0; i<ptcl_hard_result[0].size(); i++) {
+        if (!isSameParticle(ptcl_hard_result[0][i], ptcl_hard_result[1][i])) {
+            std::cerr<<"Error: hard particle "<<i<<" differs\n";
+            n_fail++;
+        }
+    }
+
+    if (n_fail>0) {
+        std::cerr<<"Group record test failed: "<<n_fail<<" errors\n";
+        return 1;
+    }
+    std::cout<<"Group record test passed\n";
+    return 0;
+}
@@ -13,6 +13,11 @@
 #include"soft_ptcl.hpp"
 #include"hermite_interaction.hpp"
 #include"hermite_information.hpp"
+#include"global_reduction.hpp"
+#include"trace.hpp"
+#ifdef HARD_GROUP_RECORD
+#include"group_record.hpp"
+#endif
 #include"hermite_perturber.hpp"
 #include"ar_interaction.hpp"
 #include"ar_perturber.hpp"
@@ -153,6 +158,39 @@ struct HardEnergy{
         return *this;
     }
 
+    //! add all values to a fused global reduction
+    /*! \return index of the first value in _reduction
+     */
+    PS::S32 addToReduction(GlobalReduction& _reduction) const {
+        const PS::S32 index = _reduction.add(de);
+        _reduction.add(de_change_cum);
+        _reduction.add(de_change_binary_interrupt);
+        _reduction.add(de_change_modify_single);
+        _reduction.add(de_sd);
+        _reduction.add(de_sd_change_cum);
+        _reduction.add(de_sd_change_binary_interrupt);
+        _reduction.add(de_sd_change_modify_single);
+        _reduction.add(ekin_sd_correction);
+        _reduction.add(epot_sd_correction);
+        return index;
+    }
+
+    //! set all values from a finished global reduction
+    /*! @param[in] _index: index returned by addToReduction
+     */
+    void setSumFromReduction(GlobalReduction& _reduction, const PS::S32 _index) {
+        de                            = _reduction.getSum(_index);
+        de_change_cum                 = _reduction.getSum(_index+1);
+        de_change_binary_interrupt    = _reduction.getSum(_index+2);
+        de_change_modify_single       = _reduction.getSum(_index+3);
+        de_sd                         = _reduction.getSum(_index+4);
+        de_sd_change_cum              = _reduction.getSum(_index+5);
+        de_sd_change_binary_interrupt = _reduction.getSum(_index+6);
+        de_sd_change_modify_single    = _reduction.getSum(_index+7);
+        ekin_sd_correction            = _reduction.getSum(_index+8);
+        epot_sd_correction            = _reduction.getSum(_index+9);
+    }
+
 };
 
 //! hard integrator 
@@ -1230,11 +1268,16 @@ private:
     PS::ReallocatableArray<PS::S32> adr_first_ptcl_arti_in_cluster_;  // address of the first artificial particle in each groups
     PS::ReallocatableArray<PS::S32> i_cluster_changeover_update_;     // cluster index that has member need changeover update
     PS::S32 n_group_member_remote_; // number of members in groups but in remote nodes
+#ifdef HARD_GROUP_RECORD
+    GroupRecordCache group_record_; // group records of the last tree step for reusing stability check and artificial particle layout
+#endif
 
     HardIntegrator* hard_int_; ///> hard integrator array
     PS::S32 n_hard_int_max_; ///> array size of hard_int
     PS::S32 n_hard_int_use_; ///> number of used hard integrator
     PS::ReallocatableArray<HardIntegrator*> interrupt_list_; ///> interrupt integrator list
+    PS::ReallocatableArray<HardIntegrator*> hard_int_thread_; ///> hard integrator used by each thread in drive
+    HardIntegrator* hard_int_front_ptr_; ///> first unused hard integrator for threads whose cluster is interrupted
     PS::F64 interrupt_dt_; ///> time end record for interrupt clusters;
 
     struct OPLessIDCluster{
@@ -1374,8 +1417,16 @@ private:
 #if  ((! defined P3T_64BIT) && (defined USE_SIMD)) || (defined USE_GPU)
         const PS::F32 r_out_32 = EPISoft::r_out;
         const PS::F32 r_out2 = r_out_32 * r_out_32;
+#ifdef SOFT_MIXED_PRECISION
+        // same as the SIMD soft force kernels, positions relative to the common reference are rounded
+        const PS::F64vec ri_64 = _pi.pos - EPISoft::pos_ref;
+        const PS::F64vec rj_64 = _pj.pos - EPISoft::pos_ref;
+        PS::F32vec ri_32 = PS::F32vec(ri_64.x, ri_64.y, ri_64.z);
+        PS::F32vec rj_32 = PS::F32vec(rj_64.x, rj_64.y, rj_64.z);
+#else
         PS::F32vec ri_32 = PS::F32vec(_pi.pos.x, _pi.pos.y, _pi.pos.z);
         PS::F32vec rj_32 = PS::F32vec(_pj.pos.x, _pj.pos.y, _pj.pos.z);
+#endif
         PS::F32vec dr_32 = ri_32 - rj_32;
         PS::F32 dr2_eps_32 = dr_32*dr_32 + (PS::F32)eps_sq;
         const PS::F32 dr2_max = (dr2_eps_32 > r_out2) ? dr2_eps_32 : r_out2;
@@ -1454,8 +1505,16 @@ private:
 #if  ((! defined P3T_64BIT) && (defined USE_SIMD)) || (defined USE_GPU)
         const PS::F32 r_out_32 = EPISoft::r_out;
         const PS::F32 r_out2 = r_out_32 * r_out_32;
+#ifdef SOFT_MIXED_PRECISION
+        // same as the SIMD soft force kernels, positions relative to the common reference are rounded
+        const PS::F64vec ri_64 = _pi.pos - EPISoft::pos_ref;
+        const PS::F64vec rj_64 = _pj.pos - EPISoft::pos_ref;
+        PS::F32vec ri_32 = PS::F32vec(ri_64.x, ri_64.y, ri_64.z);
+        PS::F32vec rj_32 = PS::F32vec(rj_64.x, rj_64.y, rj_64.z);
+#else
         PS::F32vec ri_32 = PS::F32vec(_pi.pos.x, _pi.pos.y, _pi.pos.z);
         PS::F32vec rj_32 = PS::F32vec(_pj.pos.x, _pj.pos.y, _pj.pos.z);
+#endif
         PS::F32vec dr_32 = ri_32 - rj_32;
         PS::F32 dr2_eps_32 = dr_32*dr_32 + (PS::F32)eps_sq;
         const PS::F32 dr2_max = (dr2_eps_32 > r_out2) ? dr2_eps_32 : r_out2;
@@ -1601,8 +1660,16 @@ private:
 #if  ((! defined P3T_64BIT) && (defined USE_SIMD)) || (defined USE_GPU)
         const PS::F32 r_out_32 = EPISoft::r_out;
         const PS::F32 r_out2 = r_out_32 * r_out_32;
+#ifdef SOFT_MIXED_PRECISION
+        // same as the SIMD soft force kernels, positions relative to the common reference are rounded
+        const PS::F64vec ri_64 = _pi.pos - EPISoft::pos_ref;
+        const PS::F64vec rj_64 = _pj.pos - EPISoft::pos_ref;
+        PS::F32vec ri_32 = PS::F32vec(ri_64.x, ri_64.y, ri_64.z);
+        PS::F32vec rj_32 = PS::F32vec(rj_64.x, rj_64.y, rj_64.z);
+#else
         PS::F32vec ri_32 = PS::F32vec(_pi.pos.x, _pi.pos.y, _pi.pos.z);
         PS::F32vec rj_32 = PS::F32vec(_pj.pos.x, _pj.pos.y, _pj.pos.z);
+#endif
         PS::F32vec ai_32 = PS::F32vec(_pi.acc.x, _pi.acc.y, _pi.acc.z);
         PS::F32vec aj_32 = PS::F32vec(_pj.acc.x, _pj.acc.y, _pj.acc.z);
         PS::F32vec dr_32 = ri_32 - rj_32;
@@ -1840,6 +1907,7 @@ public:
         hard_int_ = NULL;
         n_hard_int_max_ = 0;
         n_hard_int_use_ = 0;
+        hard_int_front_ptr_ = NULL;
 
 #ifdef PROFILE
         ARC_substep_sum = 0;
@@ -1990,6 +2058,18 @@ public:
         return i_cluster_changeover_update_.size();
     }
 
+#ifdef HARD_GROUP_RECORD
+    //! get group record cache
+    const GroupRecordCache& getGroupRecord() const {
+        return group_record_;
+    }
+
+    //! get group record cache for setting the tolerance and clearing counters
+    GroupRecordCache& getGroupRecord() {
+        return group_record_;
+    }
+#endif
+
     void setTimeOrigin(const PS::F64 _time_origin){
         time_origin_ = _time_origin;
     }
@@ -2073,8 +2153,12 @@ public:
      */
     void driveForOneClusterOMP(const PS::F64 _dt) {
         const PS::S32 n = ptcl_hard_.size();
-
+#ifdef STELLAR_EVOLUTION
+        Float de_kin_sum = 0.0;
+#pragma omp parallel for reduction(+:de_kin_sum)
+#else
 #pragma omp parallel for
+#endif
         for(PS::S32 i=0; i<n; i++){
             auto& pi = ptcl_hard_[i];
             PS::F64vec dr = pi.vel * _dt;
@@ -2090,10 +2174,7 @@ public:
             if (modify_flag) {
                 auto& v = pi.vel;
                 Float de_kin = 0.5*(pi.mass*(v[0]*v[0]+v[1]*v[1]+v[2]*v[2]) - mbk*(vbk[0]*vbk[0]+vbk[1]*vbk[1]+vbk[2]*vbk[2]));
-                energy.de_sd_change_cum += de_kin;
-                energy.de_sd_change_modify_single += de_kin;
-                energy.de_change_cum += de_kin;
-                energy.de_change_modify_single += de_kin;
+                de_kin_sum += de_kin;
             }
             // shift time interrupt in order to get consistent time for stellar evolution in the next drift
             //pi.time_record    -= _dt;
@@ -2124,6 +2205,13 @@ public:
             */
         }
 
+#ifdef STELLAR_EVOLUTION
+        energy.de_sd_change_cum += de_kin_sum;
+        energy.de_sd_change_modify_single += de_kin_sum;
+        energy.de_change_cum += de_kin_sum;
+        energy.de_change_modify_single += de_kin_sum;
+#endif
+
         time_origin_ += _dt;
     }
 
@@ -2163,7 +2251,8 @@ public:
     }
 
     //! write back hard particles to global system and update time of write back OMP version
-    /*! 
+    /*! The static schedule assigns contiguous index ranges to threads in the order of thread index,
+        thus merging the thread-local mass modification lists in this order gives the same list as the serial version.
       @param[in,out] _sys: particle system
       @param[out] _mass_modify_list: address on _sys of particles where mass is modified
      */
@@ -2180,7 +2269,7 @@ public:
 #ifdef STELLAR_EVOLUTION
             const PS::S32 ith = PS::Comm::getThreadNum();
 #endif
-#pragma omp for 
+#pragma omp for schedule(static)
             for(PS::S32 i=0; i<n; i++){
                 PS::S32 adr = ptcl_hard_[i].adr_org;
                 //PS::S32 adr = adr_array[i];
@@ -2212,14 +2301,14 @@ public:
     }
 
     //! write back hard particles to global system, check mass modification and update time of write back 
-    /*! 
+    /*! Clusters with many particles are written back in parallel, the mass modification list is the same as the serial version
       @param[in,out] _sys: particle system
       @param[out] _mass_modify_list: address on _sys of particles where mass is modified
      */
     template<class Tsys>
     void writeBackPtclForMultiCluster(Tsys & _sys, 
                                       PS::ReallocatableArray<PS::S32> & _mass_modify_list) {
-        writeBackPtclForOneCluster(_sys, _mass_modify_list);
+        writeBackPtclForOneClusterOMP(_sys, _mass_modify_list);
     }
 
     //! write back hard particles to global system and update time of write back OMP version
@@ -2234,19 +2323,6 @@ public:
         writeBackPtclForOneClusterOMP(_sys, _mass_modify_list);
     }
 
-//    template<class Tsys>
-//    void writeBackPtclLocalOnlyOMP(Tsys & sys) {
-//        const PS::S32 n = ptcl_hard_.size();
-//#pragma omp parallel for schedule(dynamic)
-//        for(PS::S32 i=0; i<n; i++){
-//            PS::S32 adr = ptcl_hard_[i].adr_org;
-//            //PS::S32 adr = adr_array[i];
-//#ifdef HARD_DEBUG
-//            if(adr>=0) assert(sys[adr].id == ptcl_hard_[i].id);
-//#endif
-//            if(adr>=0) sys[adr].DataCopy(ptcl_hard_[i]);
-//        }
-//    }
 // for one cluster
 //////////////////
 
@@ -2288,146 +2364,132 @@ public:
     }
 
 
-    //! Hard integration for clusters
-    /*! Integrate (drift) all clusters with OpenMP
-      If interrupt integration exist, record in the interrupt_list_;
-       @param[in] _dt: integration ending time (initial time is fixed to 0)
-       @param[in] _ptcl_soft: global particle array which contains the artificial particles for constructing tidal tensors.
-       \return interrupt cluster number
+    //! prepare hard integrators of threads before integrating clusters
+    /*! Each thread starts with its own hard integrator, interrupted clusters keep their integrators and 
+        threads take new ones from the front of the remaining array.
      */
-    template<class Tpsoft>
-    int driveForMultiClusterOMP(const PS::F64 dt, Tpsoft* _ptcl_soft){
+    void initialDriveForMultiCluster() {
         assert(n_hard_int_use_==0);
-
-        const PS::S32 n_cluster = n_ptcl_in_cluster_.size();
-        //PS::ReallocatableArray<PtclH4> extra_ptcl[num_thread];
-        //// For test
-        //PS::ReallocatableArray<std::pair<PS::S32,PS::S32>> n_sort_list;
-        //n_sort_list.resizeNoInitialize(n_cluster);
-        //for(PS::S32 i=0; i<n_cluster; i++) {
-        //    n_sort_list[i].first = n_ptcl_in_cluster_[i];
-        //    n_sort_list[i].second= i;
-        //}
-        //std::sort(n_sort_list.getPointer(),n_sort_list.getPointer()+n_cluster,[](const std::pair<PS::S32,PS::S32> &a, const std::pair<PS::S32,PS::S32> &b){return a.first<b.first;});
         const PS::S32 num_thread = PS::Comm::getNumberOfThread();
         assert(n_hard_int_max_>num_thread);
-
-#ifndef ONLY_SOFT
-        HardIntegrator* hard_int_thread[num_thread];
-        // set new hard_int front pointer 
-        HardIntegrator* hard_int_front_ptr = &hard_int_[num_thread];
+        hard_int_thread_.resizeNoInitialize(num_thread);
         for (PS::S32 i=0; i<num_thread; i++) {
-            hard_int_thread[i] = &hard_int_[i];
+            hard_int_thread_[i] = &hard_int_[i];
         }
-#endif
-
-#ifdef OMP_PROFILE        
-        PS::F64 time_thread[num_thread];
-        PS::S64 num_cluster[num_thread];
-        for (PS::S32 i=0; i<num_thread; i++) {
-          time_thread[i] = 0;
-          num_cluster[i] = 0;
-        }
-#endif
+        // set new hard_int front pointer 
+        hard_int_front_ptr_ = &hard_int_[num_thread];
+    }
 
-#pragma omp parallel for schedule(dynamic)
-        for(PS::S32 i=0; i<n_cluster; i++){
-            const PS::S32 ith = PS::Comm::getThreadNum();
-#ifdef OMP_PROFILE
-            time_thread[ith] -= PS::GetWtime();
-#endif
-            //const PS::S32 i   = n_sort_list[k].second;
-            const PS::S32 adr_head = n_ptcl_in_cluster_disp_[i];
-            const PS::S32 n_ptcl = n_ptcl_in_cluster_[i];
+    //! integrate one cluster, call in OpenMP parallel region after initialDriveForMultiCluster
+    /*! 
+       @param[in] _i: cluster index
+       @param[in] _dt: integration ending time (initial time is fixed to 0)
+       @param[in] _ptcl_soft: global particle array which contains the artificial particles for constructing tidal tensors.
+     */
+    template<class Tpsoft>
+    void driveOneClusterOMP(const PS::S32 _i, const PS::F64 _dt, Tpsoft* _ptcl_soft) {
+        const PS::S32 ith = PS::Comm::getThreadNum();
+        const PS::S32 adr_head = n_ptcl_in_cluster_disp_[_i];
+        const PS::S32 n_ptcl = n_ptcl_in_cluster_[_i];
 
 #ifndef ONLY_SOFT
-            // Hermite + AR integration
-            const PS::S32 n_group = n_group_in_cluster_[i];
-            Tpsoft* ptcl_artificial_ptr=NULL;
-            PS::S32* n_member_in_group_ptr=NULL;
-            if(n_group>0) {
-                PS::S32 ptcl_arti_first_index = adr_first_ptcl_arti_in_cluster_[n_group_in_cluster_offset_[i]];
-                if (ptcl_arti_first_index>=0) ptcl_artificial_ptr = &(_ptcl_soft[ptcl_arti_first_index]);
+        // Hermite + AR integration
+        const PS::S32 n_group = n_group_in_cluster_[_i];
+        Tpsoft* ptcl_artificial_ptr=NULL;
+        PS::S32* n_member_in_group_ptr=NULL;
+        if(n_group>0) {
+            PS::S32 ptcl_arti_first_index = adr_first_ptcl_arti_in_cluster_[n_group_in_cluster_offset_[_i]];
+            if (ptcl_arti_first_index>=0) ptcl_artificial_ptr = &(_ptcl_soft[ptcl_arti_first_index]);
 #ifdef PROFILE
-                else ARC_n_groups_iso += 1;
-#endif
-                n_member_in_group_ptr = &(n_member_in_group_[n_group_in_cluster_offset_[i]]);
-            }
-#ifdef OMP_PROFILE
-            num_cluster[ith] += n_ptcl;
+            else ARC_n_groups_iso += 1;
 #endif
+            n_member_in_group_ptr = &(n_member_in_group_[n_group_in_cluster_offset_[_i]]);
+        }
 #ifdef PROFILE
-            ARC_n_groups  += n_group;
+        ARC_n_groups  += n_group;
 #endif
 
 #ifdef HARD_DUMP
-            assert(ith<hard_dump.size);
-            hard_dump[ith].backup(ptcl_hard_.getPointer(adr_head), n_ptcl, ptcl_artificial_ptr, n_group, n_member_in_group_ptr, time_origin_, dt, manager->ap_manager.getArtificialParticleN());
+        assert(ith<hard_dump.size);
+        hard_dump[ith].backup(ptcl_hard_.getPointer(adr_head), n_ptcl, ptcl_artificial_ptr, n_group, n_member_in_group_ptr, time_origin_, _dt, manager->ap_manager.getArtificialParticleN());
 #endif
 
 #ifdef HARD_DEBUG_PROFILE
-            PS::F64 tstart = PS::GetWtime();
+        PS::F64 tstart = PS::GetWtime();
 #endif
+        // backup initial data for slow cluster capture
+        if (hard_dump_slow.isActive())
+            hard_dump_slow.getBackup().backup(ptcl_hard_.getPointer(adr_head), n_ptcl, ptcl_artificial_ptr, n_group, n_member_in_group_ptr, time_origin_, _dt, manager->ap_manager.getArtificialParticleN());
+        // wall time of the cluster for slow cluster capture and timeline trace
+        const bool wtime_cluster_flag = hard_dump_slow.isActive() || trace_log.isActive();
+        PS::F64 wtime_cluster_start = wtime_cluster_flag? PS::GetWtime(): 0.0;
 
-            // if interrupt exist, escape initial
-            hard_int_thread[ith]->initial(ptcl_hard_.getPointer(adr_head), n_ptcl, ptcl_artificial_ptr, n_group, n_member_in_group_ptr, manager, time_origin_);
+        // if interrupt exist, escape initial
+        hard_int_thread_[ith]->initial(ptcl_hard_.getPointer(adr_head), n_ptcl, ptcl_artificial_ptr, n_group, n_member_in_group_ptr, manager, time_origin_);
 
-            auto& interrupt_binary = hard_int_thread[ith]->integrateToTime(dt);
+        auto& interrupt_binary = hard_int_thread_[ith]->integrateToTime(_dt);
 
-            if (interrupt_binary.status!=AR::InterruptStatus::none) {
-                #pragma omp atomic capture
-                hard_int_thread[ith] = hard_int_front_ptr++;
+        if (wtime_cluster_flag) {
+            PS::F64 wtime_cluster_end = PS::GetWtime();
+            if (hard_dump_slow.isActive()) hard_dump_slow.record(wtime_cluster_end - wtime_cluster_start, time_origin_);
+            if (trace_log.isActive()) trace_log.add("Hard_cluster", wtime_cluster_start, wtime_cluster_end, "n_ptcl", n_ptcl, "n_group", n_group);
+        }
 
-                assert(hard_int_thread[ith]!=&hard_int_[n_hard_int_max_]);
-            }
-            else {
-                hard_int_thread[ith]->driftClusterCMRecordGroupCMDataAndWriteBack(dt);
+        if (interrupt_binary.status!=AR::InterruptStatus::none) {
+            #pragma omp atomic capture
+            hard_int_thread_[ith] = hard_int_front_ptr_++;
+
+            assert(hard_int_thread_[ith]!=&hard_int_[n_hard_int_max_]);
+        }
+        else {
+            hard_int_thread_[ith]->driftClusterCMRecordGroupCMDataAndWriteBack(_dt);
 
 #ifdef PROFILE
-                ARC_substep_sum    += hard_int_thread[ith]->ARC_substep_sum;
-                ARC_tsyn_step_sum  += hard_int_thread[ith]->ARC_tsyn_step_sum;
-                H4_step_sum        += hard_int_thread[ith]->H4_step_sum;
+            ARC_substep_sum    += hard_int_thread_[ith]->ARC_substep_sum;
+            ARC_tsyn_step_sum  += hard_int_thread_[ith]->ARC_tsyn_step_sum;
+            H4_step_sum        += hard_int_thread_[ith]->H4_step_sum;
 #endif
 #ifdef HARD_COUNT_NO_NEIGHBOR
-                n_neighbor_zero    += hard_int_thread[ith]->n_neighbor_zero;
+            n_neighbor_zero    += hard_int_thread_[ith]->n_neighbor_zero;
 #endif
 #ifdef HARD_CHECK_ENERGY
-                energy += hard_int_thread[ith]->energy;
-#endif
-                
-                hard_int_thread[ith]->clear();
-            }
-
-#ifdef OMP_PROFILE
-            time_thread[ith] += PS::GetWtime();
+            energy += hard_int_thread_[ith]->energy;
 #endif
+            
+            hard_int_thread_[ith]->clear();
+        }
 
 #ifdef HARD_DEBUG_PROFILE
-            PS::F64 tend = PS::GetWtime();
-            std::cerr<<"HT: "<<i<<" "<<ith<<" "<<n_cluster<<" "<<n_ptcl<<" "<<tend-tstart<<std::endl;
+        PS::F64 tend = PS::GetWtime();
+        std::cerr<<"HT: "<<_i<<" "<<ith<<" "<<n_ptcl_in_cluster_.size()<<" "<<n_ptcl<<" "<<tend-tstart<<std::endl;
 #endif
 
 #else
-            // Only soft drift
-            auto* pi = ptcl_hard_.getPointer(adr_head);
-            for (PS::S32 j=0; j<n_ptcl; j++) {
-                PS::F64vec dr = pi[j].vel * dt;
-                pi[j].pos += dr;
+        // Only soft drift
+        auto* pi = ptcl_hard_.getPointer(adr_head);
+        for (PS::S32 j=0; j<n_ptcl; j++) {
+            PS::F64vec dr = pi[j].vel * _dt;
+            pi[j].pos += dr;
 #ifdef CLUSTER_VELOCITY
-                auto& pij_cm = pi[j].group_data.cm;
-                pij_cm.mass = pij_cm.vel.x = pij_cm.vel.y = pij_cm.vel.z = 0.0;
-#endif
-                ASSERT(!std::isinf(pi[j].vel[0]));
-                ASSERT(!std::isnan(pi[j].vel[0]));
-                pi[j].calcRSearch(dt);
-            }
+            auto& pij_cm = pi[j].group_data.cm;
+            pij_cm.mass = pij_cm.vel.x = pij_cm.vel.y = pij_cm.vel.z = 0.0;
 #endif
-
+            ASSERT(!std::isinf(pi[j].vel[0]));
+            ASSERT(!std::isnan(pi[j].vel[0]));
+            pi[j].calcRSearch(_dt);
         }
+#endif
+    }
 
+    //! register interrupted hard integrators after all clusters are integrated
+    /*! If no interrupt exists, advance time_origin_
+       @param[in] _dt: integration ending time
+       \return interrupt cluster number
+     */
+    PS::S32 finishDriveForMultiCluster(const PS::F64 _dt) {
         // regist interrupted hard integrator
         assert(interrupt_list_.size()==0);
-        for (auto iptr = hard_int_; iptr<hard_int_front_ptr; iptr++) 
+        for (auto iptr = hard_int_; iptr<hard_int_front_ptr_; iptr++) 
             if (iptr->is_initialized) {
                 assert(iptr->interrupt_binary.status!=AR::InterruptStatus::none);
 #ifdef HARD_INTERRUPT_PRINT
@@ -2439,12 +2501,33 @@ public:
 
         // advance time_origin if all clusters finished
         PS::S32 n_interrupt = interrupt_list_.size();
-        if (n_interrupt==0) time_origin_ += dt;
-        else interrupt_dt_ = dt;
+        if (n_interrupt==0) time_origin_ += _dt;
+        else interrupt_dt_ = _dt;
 
         return n_interrupt;
     }
 
+    //! Hard integration for clusters
+    /*! Integrate (drift) all clusters with OpenMP
+      If interrupt integration exist, record in the interrupt_list_;
+      Clusters of several hard systems can be integrated in one parallel region with HardDrivePool instead.
+       @param[in] _dt: integration ending time (initial time is fixed to 0)
+       @param[in] _ptcl_soft: global particle array which contains the artificial particles for constructing tidal tensors.
+       \return interrupt cluster number
+     */
+    template<class Tpsoft>
+    int driveForMultiClusterOMP(const PS::F64 dt, Tpsoft* _ptcl_soft){
+        initialDriveForMultiCluster();
+
+        const PS::S32 n_cluster = n_ptcl_in_cluster_.size();
+#pragma omp parallel for schedule(dynamic)
+        for(PS::S32 i=0; i<n_cluster; i++){
+            driveOneClusterOMP(i, dt, _ptcl_soft);
+        }
+
+        return finishDriveForMultiCluster(dt);
+    }
+
     //! Finish interrupt integration
     /*! Finish interrupted integrations, if new interruption appear, record in the interrupt_list and this function need to be called again after modification of interrupt clusters
       If no new interrupt cluster appear, update time_origin_ with drift time.
@@ -2506,6 +2589,40 @@ public:
             cluster_index(_cluster), group_index(_group), n_members(_member), n_member_offset(_offset), isolated_case(_isolated_case) {}
     };
 
+    //! check whether an isolated binary can be integrated without artificial particles
+    /*! If the slowdown period can be larger than tree step * N_step_per_orbit, it is fine without tidal tensor
+      @param[in] _bin: binary tree root
+      @param[in] _dt_tree: tree time step
+     */
+    template <class Tbin>
+    bool isIsolatedBinaryWithoutArtificialParticles(Tbin& _bin, const PS::F64 _dt_tree) {
+        /* old criterion
+           P k / dt > ns
+           P^2/a^3 = 4 pi^2 / (G (m1 + m2))
+           k = kr pert_in/pert_out  = rs^3/a^3 kr (assume no mass and ecc dependence)
+           => P < 4pi^2 kr rs^3 / (G (m1 + m2) dt ns)  
+
+           //PS::F64 pot_ch_inv = bin.r_search*bin.r_search*bin.r_search/(ap_manager.gravitational_constant*bin.mass);
+           //if (bin.period < 4.93480220054 * manager->ar_manager.slowdown_pert_ratio_ref * pot_ch_inv / dt_nstep) {
+        */
+                
+        // directly estimate slowdown based on perturbation calculation method for more general cases
+        AR::SlowDown sd;
+        sd.initialSlowDownReference(manager->ar_manager.slowdown_pert_ratio_ref,manager->ar_manager.slowdown_timescale_max);
+        sd.pert_in = manager->ar_manager.interaction.calcPertFromBinary(_bin);
+        sd.pert_out = manager->ar_manager.interaction.calcPertFromMR(_bin.r_search, _bin.mass, 1.0/Ptcl::mean_mass_inv);
+        sd.period = _bin.period;
+        // here use twice to ensure the period*sd can be larger than dt_nstep
+        sd.timescale = 2*manager->ar_manager.slowdown_timescale_max;
+        sd.calcSlowDownFactor();
+
+        PS::F64 dt_nstep = _dt_tree*manager->n_step_per_orbit;
+
+        //std::cerr<<"GROUP_SEL_RECORD: "<<sd.pert_in<<" "<<sd.pert_out<<" "<<sd.getSlowDownFactor()<<" "<<sd.getSlowDownFactorOrigin()<<" "<<bin.m1<<" "<<bin.m2<<" "<<bin.semi<<" "<<bin.ecc<<" "<<bin.period<<" "<<dt_nstep<<" "<<(bin.period*sd.getSlowDownFactor() > dt_nstep)<<std::endl;
+
+        return (_bin.period*sd.getSlowDownFactor() > dt_nstep);
+    }
+
     //! generate artificial particles,
     /*  
         @param[in]     _i_cluster: cluster index
@@ -2575,38 +2692,65 @@ public:
 
             // be careful, here t_crit should be >= hard slowdown_timescale_max to avoid using slowdown for wide binaries
             stable_checker.t_crit = manager->ar_manager.slowdown_timescale_max;
+
+#ifdef HARD_GROUP_RECORD
+            // search the record of the same group in the last tree step by member IDs
+            typedef COMM::BinaryTree<Tptcl,COMM::Binary> BinTree;
+            std::vector<BinTree*> node_list;
+            node_list.reserve(n_members-1);
+            binary_tree.back().processTreeIter(node_list, (PS::S32)0, (PS::S32)0, GroupRecordCache::collectNodeIter<BinTree>);
+            PS::S64 member_id[n_members];
+            for (int k=0; k<n_members; k++) member_id[k] = _ptcl_in_cluster[member_list[k]].id;
+            std::sort(member_id, member_id+n_members);
+            const PS::S64 record_key = GroupRecordCache::calcKey(member_id, n_members);
+            const PS::S32 record_index = group_record_.find(record_key, member_id, n_members);
+            const GroupRecord* record_old = record_index>=0 ? &group_record_.getRecord(record_index) : NULL;
+            const PS::F64 r_in_root = binary_tree.back().changeover.getRin();
+            // reuse the record if the orbits and the changeover are not changed
+            const bool record_hit_flag = (record_old!=NULL && record_old->isConsistent(node_list.data(), node_list.size(), _n_ptcl, _dt_tree, stable_checker.t_crit, r_in_root, group_record_.tolerance));
+            GroupRecord record_new;
+            if (record_hit_flag) {
+                stable_checker.stable_binary_tree.resizeNoInitialize(0);
+                for (auto k: record_old->stable_node) stable_checker.stable_binary_tree.push_back(node_list[k]);
+            }
+            else {
+                stable_checker.findStableTree(binary_tree.back());
+
+                record_new.n_ptcl_cluster = _n_ptcl;
+                record_new.dt_tree = _dt_tree;
+                record_new.t_crit = stable_checker.t_crit;
+                record_new.r_in = r_in_root;
+                record_new.member_id.assign(member_id, member_id+n_members);
+                record_new.node.resize(node_list.size());
+                for (PS::S32 k=0; k<PS::S32(node_list.size()); k++) record_new.node[k].set(*node_list[k]);
+                for (int k=0; k<stable_checker.stable_binary_tree.size(); k++) {
+                    PS::S32 k_node = std::find(node_list.begin(), node_list.end(), stable_checker.stable_binary_tree[k]) - node_list.begin();
+                    assert(k_node<PS::S32(node_list.size()));
+                    record_new.stable_node.push_back(k_node);
+                }
+            }
+            const GroupRecord& record = record_hit_flag ? *record_old : record_new;
+#else
             stable_checker.findStableTree(binary_tree.back());
+#endif
 
             // in isolated binary case, if the slowdown period can be larger than tree step * N_step_per_orbit, it is fine without tidal tensor
             if (_n_ptcl==2&&stable_checker.stable_binary_tree.size()==1) {
                 auto& bin = *stable_checker.stable_binary_tree[i];
                 const PS::S32 n_members = bin.getMemberN();
 
-                /* old criterion
-                   P k / dt > ns
-                   P^2/a^3 = 4 pi^2 / (G (m1 + m2))
-                   k = kr pert_in/pert_out  = rs^3/a^3 kr (assume no mass and ecc dependence)
-                   => P < 4pi^2 kr rs^3 / (G (m1 + m2) dt ns)  
-
-                   //PS::F64 pot_ch_inv = bin.r_search*bin.r_search*bin.r_search/(ap_manager.gravitational_constant*bin.mass);
-                   //if (bin.period < 4.93480220054 * manager->ar_manager.slowdown_pert_ratio_ref * pot_ch_inv / dt_nstep) {
-                */
-                
-                // directly estimate slowdown based on perturbation calculation method for more general cases
-                AR::SlowDown sd;
-                sd.initialSlowDownReference(manager->ar_manager.slowdown_pert_ratio_ref,manager->ar_manager.slowdown_timescale_max);
-                sd.pert_in = manager->ar_manager.interaction.calcPertFromBinary(bin);
-                sd.pert_out = manager->ar_manager.interaction.calcPertFromMR(bin.r_search, bin.mass, 1.0/Ptcl::mean_mass_inv);
-                sd.period = bin.period;
-                // here use twice to ensure the period*sd can be larger than dt_nstep
-                sd.timescale = 2*manager->ar_manager.slowdown_timescale_max;
-                sd.calcSlowDownFactor();
-
-                PS::F64 dt_nstep = _dt_tree*manager->n_step_per_orbit;
-
-                //std::cerr<<"GROUP_SEL_RECORD: "<<sd.pert_in<<" "<<sd.pert_out<<" "<<sd.getSlowDownFactor()<<" "<<sd.getSlowDownFactorOrigin()<<" "<<bin.m1<<" "<<bin.m2<<" "<<bin.semi<<" "<<bin.ecc<<" "<<bin.period<<" "<<dt_nstep<<" "<<(bin.period*sd.getSlowDownFactor() > dt_nstep)<<std::endl;
+#ifdef HARD_GROUP_RECORD
+                bool isolated_binary_flag;
+                if (record_hit_flag) isolated_binary_flag = record_old->isolated_binary_flag;
+                else {
+                    isolated_binary_flag = isIsolatedBinaryWithoutArtificialParticles(bin, _dt_tree);
+                    record_new.isolated_binary_flag = isolated_binary_flag;
+                }
+#else
+                const bool isolated_binary_flag = isIsolatedBinaryWithoutArtificialParticles(bin, _dt_tree);
+#endif
 
-                if (bin.period*sd.getSlowDownFactor() > dt_nstep) {
+                if (isolated_binary_flag) {
                     // Set member particle type, backup mass, collect member particle index to group_ptcl_adr_list
                     //use _ptcl_in_cluster as the first particle address as reference to calculate the particle index.
                     struct { Tptcl* adr_ref; PS::S32* group_list; PS::S32 n; PS::S64 pcm_id; ChangeOver* changeover_cm; PS::F64 rsearch_cm; bool changeover_update_flag;}
@@ -2629,6 +2773,10 @@ public:
                     _n_member_in_group.push_back(GroupIndexInfo(_i_cluster, _n_groups, n_members, group_ptcl_adr_offset, 1));
                     _n_groups++;
                     group_ptcl_adr_offset += n_members;
+#ifdef HARD_GROUP_RECORD
+                    if (record_hit_flag) group_record_.keep(PS::Comm::getThreadNum(), record_key, record_index);
+                    else group_record_.add(PS::Comm::getThreadNum(), record_key, record_new);
+#endif
                     continue;
                 }
             }
@@ -2660,7 +2808,34 @@ public:
                 if (group_index_pars.changeover_update_flag) changeover_update_flag = true;
 
                 // generate artificial particles
+#ifdef HARD_GROUP_RECORD
+                // orbital sample particles relative to c.m. are reused from the record,
+                // the c.m. is added in the same way as in createSampleParticles, thus the particles are the same as the new ones for the same orbit
+                const PS::S32 n_orbit_record = ap_manager.getOrbitalParticleN();
+                ap_manager.createArtificialParticles(ptcl_artificial_i, binary_stable_i, index_group, 2, false);
+                Tptcl* ptcl_orbit_record = ap_manager.getOrbitalParticles(ptcl_artificial_i);
+                if (record_hit_flag) {
+                    const OrbitalSampleRecord* sample = &record.orbit_sample[i*n_orbit_record];
+                    for (int j=0; j<n_orbit_record; j++) {
+                        ptcl_orbit_record[j].pos  = sample[j].pos;
+                        ptcl_orbit_record[j].vel  = sample[j].vel;
+                        ptcl_orbit_record[j].mass = sample[j].mass;
+                    }
+                }
+                else {
+                    ap_manager.orbit_manager.createSampleParticles(ptcl_orbit_record, binary_stable_i, false);
+                    for (int j=0; j<n_orbit_record; j++) {
+                        OrbitalSampleRecord sample = {ptcl_orbit_record[j].pos, ptcl_orbit_record[j].vel, ptcl_orbit_record[j].mass};
+                        record_new.orbit_sample.push_back(sample);
+                    }
+                }
+                for (int j=0; j<n_orbit_record; j++) {
+                    ptcl_orbit_record[j].pos += binary_stable_i.pos;
+                    ptcl_orbit_record[j].vel += binary_stable_i.vel;
+                }
+#else
                 ap_manager.createArtificialParticles(ptcl_artificial_i, binary_stable_i, index_group, 2);
+#endif
 
                 // set rsearch and changeover for c.m. particle
                 auto* pcm = ap_manager.getCMParticles(ptcl_artificial_i);
@@ -2727,6 +2902,10 @@ public:
                 group_ptcl_adr_offset += n_members;
                 _n_groups++;
             }
+#ifdef HARD_GROUP_RECORD
+            if (record_hit_flag) group_record_.keep(PS::Comm::getThreadNum(), record_key, record_index);
+            else group_record_.add(PS::Comm::getThreadNum(), record_key, record_new);
+#endif
         }
 
         assert(group_ptcl_adr_offset<=_n_ptcl);
@@ -2803,6 +2982,9 @@ public:
             i_cluster_changeover_update_threads[i].resizeNoInitialize(0);
         }
         auto& ap_manager = manager->ap_manager;
+#ifdef HARD_GROUP_RECORD
+        group_record_.prepare(num_thread);
+#endif
 
 #pragma omp parallel for schedule(dynamic)
         for (PS::S32 i=0; i<n_cluster; i++){
@@ -2825,6 +3007,11 @@ public:
             findGroupsAndCreateArtificialParticlesOneCluster(i, ptcl_in_cluster, n_ptcl, ptcl_artificial_thread[ith], binary_table_thread[ith], n_group_in_cluster_[i], n_member_in_group_thread[ith], i_cluster_changeover_update_threads[ith], group_candidate, _dt_tree);
         }
 
+#ifdef HARD_GROUP_RECORD
+        // keep only the records of groups found in this step
+        group_record_.update();
+#endif
+
         // gether binary table
         PS::S32 n_binary_table_offset_thread[num_thread+1];
         n_binary_table_offset_thread[0] = 0;
@@ -2,6 +2,10 @@
 
 #include <cassert>
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
 #include "hard_ptcl.hpp"
 #include "Hermite/hermite_particle.h"
 #include "soft_ptcl.hpp"
@@ -221,6 +225,161 @@ public:
 
 static HardDumpList hard_dump;
 
+//! capture of slow hard clusters for replay with petar.hard.debug
+/*! Before integrating a cluster, the thread backs up the initial data to its scratch slot (getBackup).
+    After integration, record() keeps the backup if the cluster is among the n_slow_max slowest clusters of this thread,
+    and dumps it immediately if the wall time exceeds time_threshold.
+    dumpSlowest() writes the n_slow_max slowest clusters of all threads since the last call and clears the records, it must be called outside parallel regions.
+    Each dump is also listed in the text file [prefix]_list.[MPI rank] with the time, file name, wall time, number of particles and groups,
+    the list file name does not match [prefix].*, thus it is not picked up together with the dump files.
+ */
+class HardDumpSlow{
+private:
+    PS::S32 n_thread_;
+    HardDump* dump_;   // n_slow_max+1 slots per thread
+    std::vector<std::vector<std::pair<PS::F64,PS::S32>>> record_; // (wall time, slot) of kept clusters of each thread
+    std::vector<PS::S32> scratch_;   // slot for the next backup of each thread
+    std::vector<PS::S64> n_dump_threshold_; // counter of dumps above time_threshold of each thread
+    std::ofstream flog_;
+
+    HardDump& getSlot(const PS::S32 _ith, const PS::S32 _k) {
+        return dump_[_ith*(n_slow_max+1)+_k];
+    }
+
+    void writeLog(const PS::F64 _time, const std::string& _fname, const PS::F64 _wtime, const HardDump& _dump) {
+        flog_<<std::setw(WRITE_WIDTH)<<_time
+             <<" "<<_fname
+             <<std::setw(WRITE_WIDTH)<<_wtime
+             <<std::setw(WRITE_WIDTH)<<_dump.n_ptcl
+             <<std::setw(WRITE_WIDTH)<<_dump.n_group
+             <<std::endl;
+    }
+
+public:
+    PS::S32 n_slow_max;  ///> number of slowest clusters dumped per output interval, 0: off
+    PS::F64 time_threshold;  ///> dump clusters with wall time [s] above this value, 0: off
+    PS::S32 mpi_rank;
+    std::string fname_prefix;  ///> prefix of dump file names
+
+    HardDumpSlow(): n_thread_(0), dump_(NULL), record_(), scratch_(), n_dump_threshold_(), flog_(), n_slow_max(0), time_threshold(0.0), mpi_rank(0), fname_prefix() {}
+
+    //! initialization
+    /*! @param[in] _n_thread: number of OpenMP threads
+      @param[in] _n_slow_max: number of slowest clusters dumped per output interval
+      @param[in] _time_threshold: wall time threshold [s] for immediate dump
+      @param[in] _fname_prefix: prefix of dump file names
+      @param[in] _rank: MPI rank
+      @param[in] _append_flag: append the list file
+     */
+    void initial(const PS::S32 _n_thread, const PS::S32 _n_slow_max, const PS::F64 _time_threshold, const std::string& _fname_prefix, const PS::S32 _rank, const bool _append_flag) {
+        clear();
+        n_thread_ = _n_thread;
+        n_slow_max = _n_slow_max;
+        time_threshold = _time_threshold;
+        fname_prefix = _fname_prefix;
+        mpi_rank = _rank;
+        if (!isActive()) return;
+        dump_ = new HardDump[n_thread_*(n_slow_max+1)];
+        record_.resize(n_thread_);
+        scratch_.resize(n_thread_);
+        n_dump_threshold_.resize(n_thread_);
+        for (PS::S32 i=0; i<n_thread_; i++) {
+            record_[i].reserve(n_slow_max);
+            scratch_[i] = 0;
+            n_dump_threshold_[i] = 0;
+        }
+        std::string fname_log = fname_prefix + "_list." + std::to_string(mpi_rank);
+        if (_append_flag) flog_.open(fname_log.c_str(), std::ofstream::out|std::ofstream::app);
+        else flog_.open(fname_log.c_str(), std::ofstream::out);
+        flog_<<std::setprecision(WRITE_PRECISION);
+    }
+
+    void clear() {
+        if (dump_!=NULL) {
+            delete[] dump_;
+            dump_ = NULL;
+        }
+        record_.clear();
+        scratch_.clear();
+        n_dump_threshold_.clear();
+        if (flog_.is_open()) flog_.close();
+    }
+
+    ~HardDumpSlow() {
+        clear();
+    }
+
+    //! whether slow cluster capture is switched on
+    bool isActive() const {
+        return n_slow_max>0 || time_threshold>0.0;
+    }
+
+    //! get the scratch backup of the current thread
+    HardDump& getBackup() {
+        const PS::S32 ith = PS::Comm::getThreadNum();
+        assert(ith<n_thread_);
+        return getSlot(ith, scratch_[ith]);
+    }
+
+    //! record the wall time of the cluster backed up by getBackup of the current thread
+    /*! @param[in] _wtime: wall time of the cluster integration [s]
+      @param[in] _time: current time of the system, for the list file
+     */
+    void record(const PS::F64 _wtime, const PS::F64 _time) {
+        const PS::S32 ith = PS::Comm::getThreadNum();
+        assert(ith<n_thread_);
+        HardDump& backup = getSlot(ith, scratch_[ith]);
+        if (time_threshold>0.0 && _wtime>time_threshold) {
+            std::string fname = fname_prefix + "." + std::to_string(mpi_rank) + ".t" + std::to_string(ith) + "." + std::to_string(n_dump_threshold_[ith]++);
+            backup.dumpOneCluster(fname.c_str());
+#pragma omp critical
+            writeLog(_time, fname, _wtime, backup);
+        }
+        if (n_slow_max>0) {
+            auto& rec = record_[ith];
+            if ((PS::S32)rec.size()<n_slow_max) {
+                rec.push_back(std::make_pair(_wtime, scratch_[ith]));
+                scratch_[ith] = rec.size();
+            }
+            else {
+                auto rmin = std::min_element(rec.begin(), rec.end());
+                if (rmin->first<_wtime) {
+                    PS::S32 slot_free = rmin->second;
+                    *rmin = std::make_pair(_wtime, scratch_[ith]);
+                    scratch_[ith] = slot_free;
+                }
+            }
+        }
+    }
+
+    //! dump the slowest clusters of all threads and clear records
+    /*! @param[in] _index: index of the dump set (e.g. snapshot index), used in the file names [prefix].[MPI rank].[_index].[k]
+      @param[in] _time: current time of the system, for the list file
+     */
+    void dumpSlowest(const PS::S64 _index, const PS::F64 _time) {
+        if (n_slow_max<=0) return;
+        std::vector<std::pair<PS::F64,PS::S32>> slowest; // (wall time, global slot index)
+        for (PS::S32 i=0; i<n_thread_; i++) {
+            for (auto& r: record_[i]) slowest.push_back(std::make_pair(r.first, i*(n_slow_max+1)+r.second));
+        }
+        std::sort(slowest.begin(), slowest.end(), [](const std::pair<PS::F64,PS::S32>& a, const std::pair<PS::F64,PS::S32>& b){ return a.first>b.first;});
+        const PS::S32 n_dump = std::min((PS::S32)slowest.size(), n_slow_max);
+        for (PS::S32 k=0; k<n_dump; k++) {
+            std::string fname = fname_prefix + "." + std::to_string(mpi_rank) + "." + std::to_string(_index) + "." + std::to_string(k);
+            HardDump& dump = dump_[slowest[k].second];
+            dump.dumpOneCluster(fname.c_str());
+            writeLog(_time, fname, slowest[k].first, dump);
+        }
+        // reset records, slot 0 is used as scratch
+        for (PS::S32 i=0; i<n_thread_; i++) {
+            record_[i].clear();
+            scratch_[i] = 0;
+        }
+    }
+};
+
+static HardDumpSlow hard_dump_slow;
+
 #ifdef HARD_DUMP
 #define DATADUMP(expr) hard_dump.dumpThread(expr)
 #else
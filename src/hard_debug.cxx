@@ -1,7 +1,11 @@
 #include <iostream>
 #include <iomanip>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include<getopt.h>
+#include <dirent.h>
+#include <sys/stat.h>
 
 #include <particle_simulator.hpp>
 #define HARD_DEBUG_PRINT_FEQ 1024
@@ -13,6 +17,53 @@
 #include "soft_ptcl.hpp"
 #include "static_variables.hpp"
 
+#ifdef SOFT_PERT
+//! set all tidal tensor forces of a dumped cluster to zero
+void suppressSoftPert(HardDump& _hard_dump, HardManager& _hard_manager) {
+    if (_hard_dump.n_group>0) {
+        // if no artificial particles, continue
+        if (_hard_dump.ptcl_arti_bk.getPointer()!=NULL) {
+            // set all tidal tensor force to zero
+            for (int i=0; i<_hard_dump.n_group; i++) {
+                int offset= i*_hard_manager.ap_manager.getArtificialParticleN();
+                auto* pi = &(_hard_dump.ptcl_arti_bk[offset]);
+                //auto* pcm = ap_manager.getCMParticles(pi);
+                auto* ptt = _hard_manager.ap_manager.getTidalTensorParticles(pi);
+                for (int j=0; j<_hard_manager.ap_manager.getTidalTensorParticleN(); j++) {
+                    ptt[j].acc = PS::F64vec(0.0);
+                }
+            }
+        }
+    }
+}
+#endif
+
+//! add a dump file, or all regular files in a directory, to the list
+void collectDumpFiles(std::vector<std::string>& _flist, const std::string& _path) {
+    struct stat st;
+    if (stat(_path.c_str(), &st)!=0) {
+        std::cerr<<"Error: cannot access "<<_path<<std::endl;
+        abort();
+    }
+    if (S_ISDIR(st.st_mode)) {
+        DIR* dir = opendir(_path.c_str());
+        if (dir==NULL) {
+            std::cerr<<"Error: cannot open directory "<<_path<<std::endl;
+            abort();
+        }
+        std::vector<std::string> flist_dir;
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != NULL) {
+            std::string fname = _path + "/" + entry->d_name;
+            if (stat(fname.c_str(), &st)==0 && S_ISREG(st.st_mode)) flist_dir.push_back(fname);
+        }
+        closedir(dir);
+        std::sort(flist_dir.begin(), flist_dir.end());
+        _flist.insert(_flist.end(), flist_dir.begin(), flist_dir.end());
+    }
+    else _flist.push_back(_path);
+}
+
 int main(int argc, char **argv){
   int arg_label;
   int mode=0; // 0: integrate to time; 1: times stability
@@ -28,6 +79,7 @@ int main(int argc, char **argv){
   PS::S32 step_arc_limit = 100000;
   std::string filename="hard_dump";
   std::string fhardpar="input.par.hard";
+  bool fixed_n_kernel_flag=true;
 #ifdef BSE_BASE
   int idum=0;
   std::string bse_name = BSEManager::getBSEName();
@@ -44,7 +96,7 @@ int main(int argc, char **argv){
   bool soft_pert_flag=true;
 #endif
 
-  while ((arg_label = getopt(argc, argv, "k:E:A:a:D:d:e:s:c:m:b:B:p:I:v:i:Sh")) != -1)
+  while ((arg_label = getopt(argc, argv, "k:E:A:a:D:d:e:s:c:m:b:B:p:I:v:i:SGh")) != -1)
     switch (arg_label) {
     case 'k':
         slowdown_factor = atof(optarg);
@@ -81,6 +133,9 @@ int main(int argc, char **argv){
     case 'p':
         fhardpar = optarg;
         break;
+    case 'G':
+        fixed_n_kernel_flag = false;
+        break;
 #ifdef SOFT_PERT
     case 'S':
         soft_pert_flag=false;
@@ -119,7 +174,7 @@ int main(int argc, char **argv){
                  <<"    -a [double]:  AR energy limit \n"
                  <<"    -D [double]:  hard time step max (should use together with -d)\n"
                  <<"    -d [int]:     hard time step min power (should use together with -D)\n"
-                 <<"    -m [int]:     running mode: 0: evolve system to time_end; 1: stability check: "<<mode<<std::endl
+                 <<"    -m [int]:     running mode: 0: evolve system to time_end; 1: stability check; 2: batch replay of dump files and directories given as arguments in parallel, report wall time of each cluster: "<<mode<<std::endl
                  <<"    -p [string]:  hard parameter file name: "<<fhardpar<<std::endl
 #ifdef STELLAR_EVOLUTION
                  <<"    -I [int]:     Stellar evolution option: \n"
@@ -133,6 +188,7 @@ int main(int argc, char **argv){
                  <<"    -S:           Suppress soft perturbation (tidal tensor)\n"
 #endif
                  <<"    -v [int]:     version of hard parameters: 0: default, 1: mssing ds_scale in ar_manager: 0\n"
+                 <<"    -G:           use the generic AR inner force kernel for groups with 3-5 members (for benchmark)\n"
                  <<"    -h:           help\n";
         return 0;
     default:
@@ -140,11 +196,21 @@ int main(int argc, char **argv){
         abort();
     }
 
-  if (optind<argc) {
-      filename=argv[argc-1];
+  std::vector<std::string> fdump_list;
+  if (mode==2) {
+      for (int k=optind; k<argc; k++) collectDumpFiles(fdump_list, argv[k]);
+      if (fdump_list.size()==0) {
+          std::cerr<<"Error: no dump file is given for batch replay!\n";
+          abort();
+      }
+      std::cerr<<"Batch replay of "<<fdump_list.size()<<" dump files\n";
+  }
+  else {
+      if (optind<argc) {
+          filename=argv[argc-1];
+      }
+      std::cerr<<"Reading dump file:"<<filename<<std::endl;
   }
-
-  std::cerr<<"Reading dump file:"<<filename<<std::endl;
   std::cerr<<"Hard manager parameter file:"<<fhardpar<<std::endl;
 
   std::cout<<std::setprecision(WRITE_PRECISION);
@@ -187,6 +253,8 @@ int main(int argc, char **argv){
       hard_manager.ar_manager.interaction.fout_bse.open((filename+fbse_suffix).c_str(), std::ofstream::out);
       hard_manager.ar_manager.interaction.fout_sse<<std::setprecision(WRITE_PRECISION);
       hard_manager.ar_manager.interaction.fout_bse<<std::setprecision(WRITE_PRECISION);      
+      hard_manager.ar_manager.interaction.sse_event.open(filename+fsse_suffix+".bin", false, PS::Comm::getNumberOfThread(), WRITE_WIDTH, WRITE_PRECISION);
+      hard_manager.ar_manager.interaction.bse_event.open(filename+fbse_suffix+".bin", false, PS::Comm::getNumberOfThread(), WRITE_WIDTH, WRITE_PRECISION);
   }
 #endif // BSE_BASE
 #endif //STELLAR_EVOLUTION
@@ -245,33 +313,26 @@ int main(int argc, char **argv){
       hard_manager.ar_manager.energy_error_relative_max = e_err_ar;
   }
 
+  if (!fixed_n_kernel_flag) {
+      std::cerr<<"Use generic AR inner force kernel\n";
+      hard_manager.ar_manager.interaction.fixed_n_kernel_flag = false;
+  }
+
   hard_manager.checkParams();
   hard_manager.print(std::cerr);
 
   HardDump hard_dump;
-  hard_dump.readOneCluster(filename.c_str());
-  std::cerr<<"Time end: "<<hard_dump.time_end<<std::endl;
+  if (mode!=2) {
+      hard_dump.readOneCluster(filename.c_str());
+      std::cerr<<"Time end: "<<hard_dump.time_end<<std::endl;
 
 #ifdef SOFT_PERT
-  if (!soft_pert_flag) {
-      std::cerr<<"Suppress soft perturbation\n";
-      if (hard_dump.n_group>0) {
-          // if no artificial particles, continue
-          if (hard_dump.ptcl_arti_bk.getPointer()!=NULL) {
-              // set all tidal tensor force to zero
-              for (int i=0; i<hard_dump.n_group; i++) {
-                  int offset= i*hard_manager.ap_manager.getArtificialParticleN();
-                  auto* pi = &(hard_dump.ptcl_arti_bk[offset]);
-                  //auto* pcm = ap_manager.getCMParticles(pi);
-                  auto* ptt = hard_manager.ap_manager.getTidalTensorParticles(pi);
-                  for (int j=0; j<hard_manager.ap_manager.getTidalTensorParticleN(); j++) {
-                      ptt[j].acc = PS::F64vec(0.0);
-                  }
-              }
-          }
+      if (!soft_pert_flag) {
+          std::cerr<<"Suppress soft perturbation\n";
+          suppressSoftPert(hard_dump, hard_manager);
       }
-  }
 #endif
+  }
 
   // running mode
   if (mode==0) {
@@ -284,7 +345,9 @@ int main(int argc, char **argv){
       HardIntegrator hard_int;
       hard_int.initial(hard_dump.ptcl_bk.getPointer(), hard_dump.n_ptcl, hard_dump.ptcl_arti_bk.getPointer(), hard_dump.n_group, hard_dump.n_member_in_group.getPointer(), &hard_manager, hard_dump.time_offset);
 
+      PS::F64 t_start = PS::GetWtime();
       auto& interrupt_binary = hard_int.integrateToTime(hard_dump.time_end);
+      std::cerr<<"Wall time of integration [s]: "<<PS::GetWtime() - t_start<<std::endl;
       if (interrupt_binary.status!=AR::InterruptStatus::none) {
           hard_int.printInterruptBinaryInfo(std::cerr);
       }
@@ -315,10 +378,65 @@ int main(int argc, char **argv){
       // generate artificial particles, stability test is included
       sys.findGroupsAndCreateArtificialParticlesOneCluster(0, ptcl, n_ptcl, ptcl_new, binary_table, n_group_in_cluster, n_member_in_group, i_cluster_changeover_update, group_candidate, hard_dump.time_end);
   }
+  // batch replay
+  else if (mode==2) {
+      const PS::S32 n_dump = fdump_list.size();
+      // read all dumps first, the static particle parameters are set by readOneCluster
+      std::vector<HardDump> dump_list(n_dump);
+      for (PS::S32 k=0; k<n_dump; k++) {
+          dump_list[k].readOneCluster(fdump_list[k].c_str());
+#ifdef SOFT_PERT
+          if (!soft_pert_flag) suppressSoftPert(dump_list[k], hard_manager);
+#endif
+      }
+
+      std::vector<PS::F64> wtime(n_dump);
+      std::vector<char> interrupt_flag(n_dump); // not vector<bool>, elements are written by different threads
+      PS::F64 wtime_start = PS::GetWtime();
+#pragma omp parallel for schedule(dynamic)
+      for (PS::S32 k=0; k<n_dump; k++) {
+          auto& dump = dump_list[k];
+          HardIntegrator hard_int;
+          hard_int.initial(dump.ptcl_bk.getPointer(), dump.n_ptcl, dump.ptcl_arti_bk.getPointer(), dump.n_group, dump.n_member_in_group.getPointer(), &hard_manager, dump.time_offset);
+
+          PS::F64 t_start = PS::GetWtime();
+          auto& interrupt_binary = hard_int.integrateToTime(dump.time_end);
+          wtime[k] = PS::GetWtime() - t_start;
+          interrupt_flag[k] = (interrupt_binary.status!=AR::InterruptStatus::none);
+          if (!interrupt_flag[k]) hard_int.driftClusterCMRecordGroupCMDataAndWriteBack(dump.time_end);
+          hard_int.clear();
+      }
+      PS::F64 wtime_total = PS::GetWtime() - wtime_start;
+
+      // report
+      const int width = 16;
+      std::cout<<std::setw(width)<<"Wall_time[s]"
+               <<std::setw(width)<<"N_ptcl"
+               <<std::setw(width)<<"N_group"
+               <<std::setw(width)<<"Interrupt"
+               <<"  File"<<std::endl;
+      PS::F64 wtime_sum = 0.0;
+      for (PS::S32 k=0; k<n_dump; k++) {
+          std::cout<<std::setw(width)<<wtime[k]
+                   <<std::setw(width)<<dump_list[k].n_ptcl
+                   <<std::setw(width)<<dump_list[k].n_group
+                   <<std::setw(width)<<(interrupt_flag[k]?1:0)
+                   <<"  "<<fdump_list[k]<<std::endl;
+          wtime_sum += wtime[k];
+      }
+      std::cout<<"Clusters: "<<n_dump
+               <<" Sum of wall time[s]: "<<wtime_sum
+               <<" Elapsed wall time[s]: "<<wtime_total
+               <<" Threads: "<<PS::Comm::getNumberOfThread()
+               <<std::endl;
+  }
 
 #ifdef STELLAR_EVOLUTION
 #ifdef BSE_BASE
   auto& interaction = hard_manager.ar_manager.interaction;
+  interaction.flushEventLog();
+  interaction.sse_event.close();
+  interaction.bse_event.close();
   if (interaction.fout_sse.is_open()) interaction.fout_sse.close();
   if (interaction.fout_bse.is_open()) interaction.fout_bse.close();
 #endif
@@ -0,0 +1,105 @@
+#pragma once
+#include <particle_simulator.hpp>
+#include <vector>
+#include <algorithm>
+
+//! shared dynamic work pool of cluster integrations from several hard systems
+/*! In the drift, the clusters of isolated and connected hard systems were integrated in two parallel regions one after another,
+    thus threads idled at the end of the first region until its largest cluster finished, although the clusters of the second system do not depend on them.
+    The pool collects the clusters of all added systems (the only dependency is that a system is prepared by initialDriveForMultiCluster before
+    and finished by finishDriveForMultiCluster after) and integrates them in one parallel region with one dynamic schedule,
+    larger clusters first so that the expensive ones do not start at the end.
+    The busy time of each thread is measured per cluster, the idle time is the thread time of the region (wall time times thread number)
+    minus the busy time, which includes waiting at the end barrier and the fork-join overhead.
+ */
+template <class Tsys>
+class HardDrivePool{
+private:
+    //! one cluster integration
+    struct Task{
+        Tsys* sys;
+        PS::S32 i_cluster;
+        PS::S32 n_ptcl;
+    };
+
+    PS::ReallocatableArray<Task> task_;
+    std::vector<Tsys*> sys_;
+    std::vector<PS::F64> time_busy_thx_;
+    PS::F64 time_busy_; // accumulated busy time of threads
+    PS::F64 time_idle_; // accumulated idle time of threads
+    PS::S64 n_task_;    // accumulated number of integrated clusters
+
+public:
+    HardDrivePool(): task_(), sys_(), time_busy_thx_(), time_busy_(0.0), time_idle_(0.0), n_task_(0) {}
+
+    //! add all clusters of a hard system and prepare its hard integrators
+    void add(Tsys& _sys) {
+        _sys.initialDriveForMultiCluster();
+        sys_.push_back(&_sys);
+        const PS::S32 n_cluster = _sys.getNumberOfClusters();
+        const PS::S32* n_ptcl = _sys.getClusterNumberOfMemberList();
+        for (PS::S32 i=0; i<n_cluster; i++) task_.push_back(Task{&_sys, i, n_ptcl[i]});
+    }
+
+    //! integrate all clusters in one parallel region and register interrupted clusters of each system
+    /*! @param[in] _dt: integration ending time
+      @param[in] _ptcl_soft: global particle array which contains the artificial particles
+      @param[out] _n_interrupt: interrupt cluster number of each added system in the order of add()
+     */
+    template<class Tpsoft>
+    void drive(const PS::F64 _dt, Tpsoft* _ptcl_soft, PS::S32* _n_interrupt) {
+        const PS::S64 n_task = task_.size();
+        // stable sort keeps the cluster order of each system for the same size
+        std::stable_sort(task_.getPointer(), task_.getPointer()+n_task, [](const Task& a, const Task& b){ return a.n_ptcl>b.n_ptcl;});
+
+        const PS::S32 num_thread = PS::Comm::getNumberOfThread();
+        time_busy_thx_.assign(num_thread, 0.0);
+        Task* task = task_.getPointer();
+        const PS::F64 time_start = PS::GetWtime();
+#pragma omp parallel
+        {
+            const PS::S32 ith = PS::Comm::getThreadNum();
+            PS::F64 time_busy = 0.0;
+#pragma omp for schedule(dynamic) nowait
+            for (PS::S64 i=0; i<n_task; i++) {
+                const PS::F64 t0 = PS::GetWtime();
+                task[i].sys->driveOneClusterOMP(task[i].i_cluster, _dt, _ptcl_soft);
+                time_busy += PS::GetWtime() - t0;
+            }
+            time_busy_thx_[ith] = time_busy;
+        }
+        const PS::F64 time_region = (PS::GetWtime() - time_start)*num_thread;
+
+        PS::F64 time_busy = 0.0;
+        for (PS::S32 i=0; i<num_thread; i++) time_busy += time_busy_thx_[i];
+        time_busy_ += time_busy;
+        time_idle_ += time_region - time_busy;
+        n_task_ += n_task;
+
+        for (std::size_t k=0; k<sys_.size(); k++) _n_interrupt[k] = sys_[k]->finishDriveForMultiCluster(_dt);
+        sys_.clear();
+        task_.resizeNoInitialize(0);
+    }
+
+    //! accumulated busy time of all threads
+    PS::F64 getBusyTime() const {
+        return time_busy_;
+    }
+
+    //! accumulated idle time of all threads
+    PS::F64 getIdleTime() const {
+        return time_idle_;
+    }
+
+    //! accumulated number of integrated clusters
+    PS::S64 getNumberOfTask() const {
+        return n_task_;
+    }
+
+    //! reset time and task counters
+    void clearProfile() {
+        time_busy_ = 0.0;
+        time_idle_ = 0.0;
+        n_task_ = 0;
+    }
+};
@@ -0,0 +1,504 @@
+#include <iostream>
+#include <cstdio>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <cassert>
+#include <getopt.h>
+#include <particle_simulator.hpp>
+
+#ifdef P3T_64BIT
+#define CALC_EP_64bit
+#define CALC_SP_64bit
+#define RSQRT_NR_EPJ_X4
+#define RSQRT_NR_SPJ_X4
+
+#elif P3T_MIXBIT
+#define CALC_EP_64bit
+#define RSQRT_NR_EPJ_X4
+
+#else
+#define RSQRT_NR_EPJ_X2
+//#define RSQRT_NR_SPJ_X2
+#endif
+
+#include <get_version.hpp>
+#include "io.hpp"
+#include "hard_assert.hpp"
+#include "cluster_list.hpp"
+#include "hard.hpp"
+#include "soft_ptcl.hpp"
+#include "soft_force.hpp"
+#include "tidal_tensor.hpp"
+#include "particle_distribution_generator.hpp"
+#include "static_variables.hpp"
+#ifdef USE_GPU
+#include "force_gpu_cuda.hpp"
+#else
+#ifdef USE_QUAD
+#define SPJSoft PS::SPJQuadrupoleInAndOut
+#else
+#define SPJSoft PS::SPJMonopoleInAndOut
+#endif
+#ifdef USE_FUGAKU
+#include "force_fugaku.hpp"
+#endif
+#endif
+
+//! results of kernels are added here so that the compiler cannot remove the kernel calls
+static volatile PS::F64 bench_sink = 0.0;
+
+//! instruction set the benchmark is compiled for
+const char* getISAName() {
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+    return "AVX512";
+#elif defined(__AVX2__)
+    return "AVX2";
+#elif defined(__AVX__)
+    return "AVX";
+#elif defined(__ARM_FEATURE_SVE)
+    return "SVE";
+#else
+    return "Generic";
+#endif
+}
+
+//! timing and printing of kernel benchmark
+/*! Each kernel is called in a loop; the call number is increased until one loop takes longer than t_min.
+    The loop is repeated n_repeat times and the fastest one is used, so the result is insensitive to the system noise.
+    One line is printed for each kernel, variant and size with fixed columns, so that outputs of different commits can be compared by diff or paste.
+ */
+class KernelBench{
+public:
+    PS::F64 t_min;      // minimum wall time of one timing loop
+    PS::S32 n_repeat;   // number of timing loops, the fastest one is used
+    std::string filter; // only measure kernels whose names contain this string
+
+    KernelBench(): t_min(0.05), n_repeat(5), filter() {}
+
+    //! print table title
+    void printTitle(std::ostream& _fout) const {
+        _fout<<std::left
+             <<std::setw(28)<<"Kernel"
+             <<std::setw(10)<<"Variant"
+             <<std::right
+             <<std::setw(8)<<"N"
+             <<std::setw(16)<<"ns/call"
+             <<std::setw(16)<<"Interactions/s"
+             <<std::endl;
+    }
+
+    //! measure one kernel and print the result
+    /*! @param[in] _kernel: kernel name
+      @param[in] _variant: kernel variant (instruction set or algorithm)
+      @param[in] _n: input size
+      @param[in] _n_interaction: number of interactions (pairs, evaluations) per call
+      @param[in] _func: function calling the kernel once
+     */
+    template<class Tfunc>
+    void run(const char* _kernel, const char* _variant, const PS::S64 _n, const PS::F64 _n_interaction, Tfunc&& _func) {
+        if (filter.size()>0 && std::string(_kernel).find(filter)==std::string::npos) return;
+
+        // calibrate the call number of one loop
+        const PS::S64 n_call_max = PS::S64(1)<<40;
+        PS::S64 n_call = 1;
+        PS::F64 dt = timeLoop(_func, n_call);
+        while (dt<t_min && n_call<n_call_max) {
+            PS::S64 fac = dt>0.0? PS::S64(1.2*t_min/dt)+1: 100;
+            n_call *= std::max(PS::S64(2), std::min(fac, PS::S64(100)));
+            dt = timeLoop(_func, n_call);
+        }
+        PS::F64 dt_best = dt;
+        for (PS::S32 k=1; k<n_repeat; k++) dt_best = std::min(dt_best, timeLoop(_func, n_call));
+
+        const PS::F64 t_call = dt_best/n_call;
+        std::cout<<std::left
+                 <<std::setw(28)<<_kernel
+                 <<std::setw(10)<<_variant
+                 <<std::right
+                 <<std::setw(8)<<_n
+                 <<std::setw(16)<<std::fixed<<std::setprecision(2)<<t_call*1e9
+                 <<std::setw(16)<<std::scientific<<std::setprecision(4)<<_n_interaction/t_call
+                 <<std::endl;
+    }
+
+private:
+    template<class Tfunc>
+    PS::F64 timeLoop(Tfunc& _func, const PS::S64 _n_call) {
+        const PS::F64 t0 = PS::GetWtime();
+        for (PS::S64 k=0; k<_n_call; k++) _func();
+        return PS::GetWtime() - t0;
+    }
+};
+
+//! set super particles with random mass and position, same as in simd_test
+void setSpj(const PS::F64 _n, SPJSoft& _sp, std::mt19937_64& _gen) {
+    std::uniform_real_distribution<PS::F64> uni(0.0, 1.0);
+    _sp.mass =  1.0/_n+0.001/_n*uni(_gen);
+    _sp.pos.x = 1.0+10.0*uni(_gen);
+    _sp.pos.y = 1.0+10.0*uni(_gen);
+    _sp.pos.z = 1.0+10.0*uni(_gen);
+#ifdef USE_QUAD
+    _sp.quad.xx = 10.0*uni(_gen);
+    _sp.quad.yy = 10.0*uni(_gen);
+    _sp.quad.zz = 10.0*uni(_gen);
+    _sp.quad.xy = 10.0*uni(_gen);
+    _sp.quad.yz = 10.0*uni(_gen);
+    _sp.quad.xz = 10.0*uni(_gen);
+#endif
+}
+
+//! benchmark one soft force kernel with n_i = n_j = n
+template<class Tfunc, class Tepj>
+void benchSoftKernel(KernelBench& _bench, const char* _kernel, const char* _variant, Tfunc& _func,
+                     const EPISoft* _epi, const Tepj* _epj, ForceSoft* _force, const std::vector<PS::S32>& _n_list) {
+    for (auto n: _n_list)
+        _bench.run(_kernel, _variant, n, PS::F64(n)*PS::F64(n), [&](){ _func(_epi, n, _epj, n, _force);});
+    bench_sink += _force[0].acc.x;
+}
+
+//! print size of particle types and memory of particle arrays
+/*! Each tree step copies every local particle from FPSoft to EPISoft and EPJSoft of the force tree and to EPISoft and EPJNB of the neighbor search tree,
+    and the LET of each tree sends the EPJ of exported particles, thus the EPJ sizes set the copy and communication volume per particle.
+    @param[in] _n: particle number
+ */
+void printParticleMemory(const PS::S64 _n) {
+    const PS::F64 mb = 1.0/(1024.0*1024.0);
+    const PS::S32 w = 16;
+    std::cout<<"# Particle type size [bytes] and memory [MB] of "<<_n<<" particles
+";
+    std::cout<<"#"<<std::setw(w)<<"Type"<<std::setw(w)<<"Size"<<std::setw(w)<<"Memory"<<std::endl;
+    auto printOne = [&](const char* _name, const std::size_t _size) {
+        std::cout<<"#"<<std::setw(w)<<_name<<std::setw(w)<<_size<<std::setw(w)<<_size*_n*mb<<std::endl;
+    };
+    printOne("FPSoft", sizeof(FPSoft));
+    printOne("EPISoft", sizeof(EPISoft));
+    printOne("EPJSoft", sizeof(EPJSoft));
+    printOne("EPJNB", sizeof(EPJNB));
+    printOne("ForceSoft", sizeof(ForceSoft));
+    printOne("SPJSoft", sizeof(SPJSoft));
+#if defined(SOFT_LET_COMPRESS) && defined(USE_QUAD)
+    printOne("SPJSoftF32", sizeof(SPJQuadrupoleInAndOutF32));
+#endif
+    printOne("PtclHard", sizeof(PtclHard));
+    // read FPSoft twice, write EPISoft twice and one EPJ for each tree
+    const std::size_t tree_copy = 2*sizeof(FPSoft) + 2*sizeof(EPISoft) + sizeof(EPJSoft) + sizeof(EPJNB);
+    printOne("Tree_copy/step", tree_copy);
+}
+
+//! generate a compact cluster of hard particles with random velocities
+/*! @param[out] _ptcl: particle array
+    @param[in] _n: number of particles
+    @param[in] _size: cluster size
+    @param[in] _r_in: changeover inner radius
+    @param[in] _r_out: changeover outer radius
+    @param[in] _gen: random generator
+ */
+void generateHardCluster(std::vector<PtclHard>& _ptcl, const PS::S32 _n, const PS::F64 _size, const PS::F64 _r_in, const PS::F64 _r_out, std::mt19937_64& _gen) {
+    std::uniform_real_distribution<PS::F64> uni(-1.0, 1.0);
+    _ptcl.resize(_n);
+    for (PS::S32 i=0; i<_n; i++) {
+        PtclHard& pi = _ptcl[i];
+        pi.mass = (1.0 + 0.5*uni(_gen))/_n;
+        pi.pos = PS::F64vec(uni(_gen), uni(_gen), uni(_gen))*_size;
+        pi.vel = PS::F64vec(uni(_gen), uni(_gen), uni(_gen));
+        pi.id = i+1;
+        pi.changeover.setR(pi.mass*_n, _r_in, _r_out);
+    }
+}
+
+int main(int argc, char **argv){
+    KernelBench bench;
+    PS::S32 n_max = 2048;
+    PS::S32 seed = 1;
+    PS::S64 n_mem = 10000000;
+
+    int copt;
+    while ((copt = getopt(argc, argv, "N:t:r:k:s:m:h")) != -1)
+        switch (copt) {
+        case 'N':
+            n_max = atoi(optarg);
+            break;
+        case 't':
+            bench.t_min = atof(optarg);
+            break;
+        case 'r':
+            bench.n_repeat = atoi(optarg);
+            break;
+        case 'k':
+            bench.filter = optarg;
+            break;
+        case 's':
+            seed = atoi(optarg);
+            break;
+        case 'm':
+            n_mem = atol(optarg);
+            break;
+        case 'h':
+            std::cout<<"Micro-benchmark of force and regularization kernels: soft tree force, neighbor search, Hermite pair force, SDAR inner force,\n"
+                     <<"changeover functions, tidal tensor and group-candidate partner search.\n"
+                     <<"For each kernel, variant and input size N, the wall time per call and the interactions (pairs or evaluations) per second are printed.\n"
+                     <<"For the soft kernels, N_i = N_j = N; for partner search, the interaction number is N(N-1)/2 (all pairs).\n"
+                     <<"The Simd variants of soft kernels use the instruction set shown in the title; configure with different --with-simd options to compare AVX2 and AVX-512.\n"
+                     <<"Options:\n"
+                     <<"  -N [int]:    maximum particle number of soft and search kernels ("<<n_max<<")\n"
+                     <<"  -t [double]: minimum wall time of one timing loop in seconds ("<<bench.t_min<<")\n"
+                     <<"  -r [int]:    number of timing loops, the fastest one is used ("<<bench.n_repeat<<")\n"
+                     <<"  -k [string]: only measure kernels whose names contain this string\n"
+                     <<"  -s [int]:    random seed ("<<seed<<")\n"
+                     <<"  -m [int]:    particle number for the memory report of particle types ("<<n_mem<<")\n"
+                     <<"  -h:          help\n";
+            return 0;
+        default:
+            std::cerr<<"Unknown argument. check '-h' for help.\n";
+            abort();
+        }
+
+    std::cout<<"# PeTar kernel benchmark, version: "<<GetVersion()<<", ISA: "<<getISAName();
+#ifdef USE_SIMD
+    std::cout<<", USE_SIMD";
+#endif
+#ifdef USE_QUAD
+    std::cout<<", USE_QUAD";
+#endif
+#ifdef P3T_64BIT
+    std::cout<<", P3T_64BIT";
+#endif
+#ifdef SOFT_MIXED_PRECISION
+    std::cout<<", SOFT_MIXED_PRECISION";
+#endif
+#ifdef TIDAL_TENSOR_3RD
+    std::cout<<", TIDAL_TENSOR_3RD";
+#endif
+    std::cout<<std::endl;
+    printParticleMemory(n_mem);
+    bench.printTitle(std::cout);
+
+    std::mt19937_64 gen(seed);
+
+    // input sizes of soft and search kernels
+    std::vector<PS::S32> n_list;
+    for (PS::S32 n=32; n<=n_max; n*=4) n_list.push_back(n);
+    if (n_list.size()==0) n_list.push_back(n_max);
+    const PS::S32 n_ptcl = n_list.back();
+
+    // soft kernels, setup follows simd_test
+    EPISoft::r_out = 0.01;
+    EPISoft::eps = 1e-4;
+    ForceSoft::grav_const = 1.0;
+    {
+        PS::F64 * mass;
+        PS::F64vec * pos;
+        PS::F64vec * vel;
+        ParticleDistributionGenerator::makePlummerModel(1.0, n_ptcl, n_ptcl, mass, pos, vel, -0.25, seed);
+        std::vector<FPSoft> ptcl(n_ptcl);
+        std::vector<EPISoft> epi(n_ptcl);
+        std::vector<EPJSoft> epj(n_ptcl);
+        std::vector<EPJNB> epj_nb(n_ptcl);
+        std::vector<SPJSoft> spj(n_ptcl);
+        std::vector<ForceSoft> force(n_ptcl);
+        for (PS::S32 i=0; i<n_ptcl; i++) {
+            ptcl[i].mass = mass[i];
+            ptcl[i].pos = pos[i];
+            ptcl[i].vel = vel[i];
+            ptcl[i].id = i+1;
+            ptcl[i].group_data.artificial.setParticleTypeToSingle();
+            ptcl[i].changeover.setR(1.0, 0.001, 0.01);
+            ptcl[i].calcRSearch(1.0/2048.0);
+            epi[i].copyFromFP(ptcl[i]);
+            epj[i].copyFromFP(ptcl[i]);
+            epj_nb[i].copyFromFP(ptcl[i]);
+            setSpj(PS::F64(n_ptcl), spj[i], gen);
+            force[i].clear();
+        }
+        delete [] mass;
+        delete [] pos;
+        delete [] vel;
+
+        CalcForceEpEpWithLinearCutoffNoSimd f_ep_ep;
+        benchSoftKernel(bench, "Soft::EpEp", "NoSimd", f_ep_ep, epi.data(), epj.data(), force.data(), n_list);
+#ifdef USE_SIMD
+        CalcForceEpEpWithLinearCutoffSimd f_ep_ep_simd;
+        benchSoftKernel(bench, "Soft::EpEp", getISAName(), f_ep_ep_simd, epi.data(), epj.data(), force.data(), n_list);
+#endif
+#ifdef USE_FUGAKU
+        CalcForceEpEpWithLinearCutoffFugaku f_ep_ep_fgk(EPISoft::eps*EPISoft::eps, EPISoft::r_out*EPISoft::r_out, ForceSoft::grav_const);
+        benchSoftKernel(bench, "Soft::EpEp", "Fugaku", f_ep_ep_fgk, epi.data(), epj.data(), force.data(), n_list);
+#endif
+
+#ifdef USE_QUAD
+        const char* sp_name = "Soft::EpSpQuad";
+        CalcForceEpSpQuadNoSimd f_ep_sp;
+#else
+        const char* sp_name = "Soft::EpSpMono";
+        CalcForceEpSpMonoNoSimd f_ep_sp;
+#endif
+        benchSoftKernel(bench, sp_name, "NoSimd", f_ep_sp, epi.data(), spj.data(), force.data(), n_list);
+#ifdef USE_SIMD
+#ifdef USE_QUAD
+        CalcForceEpSpQuadSimd f_ep_sp_simd;
+#else
+        CalcForceEpSpMonoSimd f_ep_sp_simd;
+#endif
+        benchSoftKernel(bench, sp_name, getISAName(), f_ep_sp_simd, epi.data(), spj.data(), force.data(), n_list);
+#endif
+#ifdef USE_FUGAKU
+#ifdef USE_QUAD
+        CalcForceEpSpQuadFugaku f_ep_sp_fgk(EPISoft::eps*EPISoft::eps, ForceSoft::grav_const);
+#else
+        CalcForceEpSpMonoFugaku f_ep_sp_fgk(EPISoft::eps*EPISoft::eps, ForceSoft::grav_const);
+#endif
+        benchSoftKernel(bench, sp_name, "Fugaku", f_ep_sp_fgk, epi.data(), spj.data(), force.data(), n_list);
+#endif
+
+        SearchNeighborEpEpNoSimd f_nb;
+        benchSoftKernel(bench, "Soft::SearchNeighbor", "NoSimd", f_nb, epi.data(), epj_nb.data(), force.data(), n_list);
+#ifdef USE_SIMD
+        SearchNeighborEpEpSimd f_nb_simd;
+        benchSoftKernel(bench, "Soft::SearchNeighbor", getISAName(), f_nb_simd, epi.data(), epj_nb.data(), force.data(), n_list);
+#endif
+#ifdef USE_FUGAKU
+        SearchNeighborEpEpFugaku f_nb_fgk;
+        benchSoftKernel(bench, "Soft::SearchNeighbor", "Fugaku", f_nb_fgk, epi.data(), epj_nb.data(), force.data(), n_list);
+#endif
+    }
+
+    // Hermite pair force of one i particle with N j particles
+    {
+        const PS::F64 r_in = 1e-3, r_out = 1e-2;
+        HermiteInteraction interaction;
+        interaction.eps_sq = 0.0;
+        interaction.gravitational_constant = 1.0;
+        std::vector<PtclHard> ptcl;
+        for (PS::S32 n=8; n<=512; n*=4) {
+            generateHardCluster(ptcl, n+1, r_out, r_in, r_out, gen);
+            H4::ForceH4 force;
+            force.clear();
+            PS::F64 sum = 0.0;
+            bench.run("Hermite::AccJerkPair", "Scalar", n, PS::F64(n), [&](){
+                    for (PS::S32 j=1; j<=n; j++)
+                        sum += interaction.calcAccJerkPairSingleSingle(force, ptcl[0], ptcl[j]);
+                });
+            bench_sink += sum + force.acc0[0];
+        }
+    }
+
+    // SDAR inner force of all members
+    {
+        ARInteraction interaction;
+        interaction.eps_sq = 0.0;
+        interaction.gravitational_constant = 1.0;
+        std::vector<PtclHard> ptcl;
+        const PS::S32 n_ar_list[7] = {2, 3, 4, 5, 6, 8, 16};
+        for (auto n: n_ar_list) {
+            generateHardCluster(ptcl, n, 1e-4, 1e-3, 1e-2, gen);
+            std::vector<AR::Force> force(n);
+            const PtclHard* p = ptcl.data();
+            AR::Force* f = force.data();
+            PS::F64 epot = 0.0, sum = 0.0;
+            const PS::F64 n_pair = 0.5*n*(n-1);
+            if (n==2)
+                bench.run("SDAR::InnerAccPotGTKickInv", "Two", n, n_pair, [&](){ sum += interaction.calcInnerAccPotAndGTKickInvTwo(f[0], f[1], epot, p[0], p[1]);});
+            else if (n==3)
+                bench.run("SDAR::InnerAccPotGTKickInv", "FixedN", n, n_pair, [&](){ sum += interaction.calcInnerAccPotAndGTKickInvFixedN<3>(f, epot, p);});
+            else if (n==4)
+                bench.run("SDAR::InnerAccPotGTKickInv", "FixedN", n, n_pair, [&](){ sum += interaction.calcInnerAccPotAndGTKickInvFixedN<4>(f, epot, p);});
+            else if (n==5)
+                bench.run("SDAR::InnerAccPotGTKickInv", "FixedN", n, n_pair, [&](){ sum += interaction.calcInnerAccPotAndGTKickInvFixedN<5>(f, epot, p);});
+            bench.run("SDAR::InnerAccPotGTKickInv", "Generic", n, n_pair, [&](){ sum += interaction.calcInnerAccPotAndGTKickInv(f, epot, p, n);});
+            bench_sink += sum + epot;
+        }
+    }
+
+    // changeover functions of N pairs with distances covering inner, transition and outer regions
+    {
+        const PS::S32 n = 1024;
+        const PS::F64 r_in = 1e-3, r_out = 1e-2;
+        std::uniform_real_distribution<PS::F64> uni(0.0, 1.0);
+        std::vector<ChangeOver> ch1(n), ch2(n);
+        std::vector<PS::F64> dr(n), drdot(n);
+        for (PS::S32 i=0; i<n; i++) {
+            ch1[i].setR(0.5+uni(gen), r_in, r_out);
+            ch2[i].setR(0.5+uni(gen), r_in, r_out);
+            dr[i] = (0.5 + uni(gen))*r_out;
+            drdot[i] = 2.0*uni(gen) - 1.0;
+        }
+        PS::F64 sum = 0.0;
+        bench.run("ChangeOver::PotW", "Scalar", n, PS::F64(n), [&](){
+                for (PS::S32 i=0; i<n; i++) sum += ChangeOver::calcPotWTwo(ch1[i], ch2[i], dr[i]);
+            });
+        bench.run("ChangeOver::Acc0W", "Scalar", n, PS::F64(n), [&](){
+                for (PS::S32 i=0; i<n; i++) sum += ChangeOver::calcAcc0WTwo(ch1[i], ch2[i], dr[i]);
+            });
+        bench.run("ChangeOver::Acc1W", "Scalar", n, PS::F64(n), [&](){
+                for (PS::S32 i=0; i<n; i++) sum += ChangeOver::calcAcc1WTwo(ch1[i], ch2[i], dr[i], drdot[i]);
+            });
+        bench_sink += sum;
+    }
+
+    // tidal tensor fit from measure points and evaluation at N positions
+    {
+#ifdef TIDAL_TENSOR_3RD
+        const char* tt_variant = "3rd";
+#else
+        const char* tt_variant = "2nd";
+#endif
+        std::uniform_real_distribution<PS::F64> uni(-1.0, 1.0);
+        const PS::S32 n_point = TidalTensor::getParticleN();
+        const PS::F64 size = 1e-3;
+        std::vector<FPSoft> ptcl_tt(n_point);
+        FPSoft ptcl_cm;
+        ptcl_cm.pos = PS::F64vec(uni(gen), uni(gen), uni(gen));
+        TidalTensor::createTidalTensorMeasureParticles(ptcl_tt.data(), ptcl_cm, size);
+        for (PS::S32 i=0; i<n_point; i++) ptcl_tt[i].acc = PS::F64vec(uni(gen), uni(gen), uni(gen));
+
+        TidalTensor tt;
+        bench.run("TidalTensor::fit", tt_variant, n_point, PS::F64(n_point), [&](){ tt.fit(ptcl_tt.data(), ptcl_cm, size);});
+
+        const PS::S32 n = 1024;
+        std::vector<PS::F64vec> pos(n);
+        for (PS::S32 i=0; i<n; i++) pos[i] = PS::F64vec(uni(gen), uni(gen), uni(gen))*size;
+        PS::F64vec acc(0.0);
+        bench.run("TidalTensor::eval", tt_variant, n, PS::F64(n), [&](){
+                for (PS::S32 i=0; i<n; i++) tt.eval(&acc.x, pos[i]);
+            });
+        bench_sink += acc.x;
+    }
+
+    // partner search of group candidates in a Plummer cluster
+    {
+        for (auto n: n_list) {
+            PS::F64 * mass;
+            PS::F64vec * pos;
+            PS::F64vec * vel;
+            ParticleDistributionGenerator::makePlummerModel(1.0, n, n, mass, pos, vel, -0.25, seed);
+            std::vector<PtclHard> ptcl(n);
+            const PS::F64 r_in = 0.1*std::pow(PS::F64(n), -1.0/3.0);
+            for (PS::S32 i=0; i<n; i++) {
+                ptcl[i].mass = mass[i];
+                ptcl[i].pos = pos[i];
+                ptcl[i].vel = vel[i];
+                ptcl[i].id = i+1;
+                ptcl[i].changeover.setR(1.0, r_in, 10.0*r_in);
+            }
+            delete [] mass;
+            delete [] pos;
+            delete [] vel;
+
+            SearchGroupCandidate<PtclHard> search_direct, search_grid;
+            search_direct.n_grid_threshold = n+1;
+            search_grid.n_grid_threshold = 0;
+            PS::ReallocatableArray<PS::S32> list, disp, n_part;
+            const PS::F64 n_pair = 0.5*PS::F64(n)*PS::F64(n-1);
+            bench.run("SearchGroup::Partner", "Direct", n, n_pair, [&](){ search_direct.searchPartner(list, disp, n_part, ptcl.data(), n);});
+            bench.run("SearchGroup::Partner", "Grid", n, n_pair, [&](){ search_grid.searchPartner(list, disp, n_part, ptcl.data(), n);});
+            bench_sink += list.size();
+        }
+    }
+
+    return 0;
+}
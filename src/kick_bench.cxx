@@ -0,0 +1,277 @@
+#include <iostream>
+#include <cstdio>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <cassert>
+#include <getopt.h>
+#include <particle_simulator.hpp>
+#include <get_version.hpp>
+#include "hard_assert.hpp"
+#include "hard.hpp"
+#include "soft_ptcl.hpp"
+#include "fused_kick.hpp"
+#include "static_variables.hpp"
+
+//! local particle array with the interface of PS::ParticleSystem used by the kick
+class SystemSoftBench{
+public:
+    PS::ReallocatableArray<FPSoft> ptcl;
+
+    FPSoft& operator [](const PS::S64 _i) {
+        return ptcl[_i];
+    }
+
+    PS::S64 getNumberOfParticleLocal() const {
+        return ptcl.size();
+    }
+};
+
+//! kick of one tree step with separate passes, same as PeTar::kick before the fused kick
+/*! Each category has its own OpenMP parallel loop: single particles, isolated clusters and c.m. particles
+ */
+void kickMultiPass(SystemSoftBench& _sys,
+                   const PS::ReallocatableArray<PS::S32>& _adr_single,
+                   PS::ReallocatableArray<PtclH4>& _ptcl_iso,
+                   const PS::S32 _adr_artificial_start,
+                   ArtificialParticleManager& _ap_manager,
+                   const PS::F64 _dt) {
+    // single
+    const PS::S64 n_single = _adr_single.size();
+#pragma omp parallel for
+    for (PS::S64 i=0; i<n_single; i++) {
+        const PS::S32 k = _adr_single[i];
+        _sys[k].vel += _sys[k].acc * _dt;
+        _sys[k].group_data.artificial.setParticleTypeToSingle();
+    }
+    // isolated clusters
+    const PS::S64 n_iso = _ptcl_iso.size();
+#pragma omp parallel for
+    for (PS::S64 i=0; i<n_iso; i++) {
+        auto& pi_artificial = _ptcl_iso[i].group_data.artificial;
+        if (pi_artificial.isMember()) {
+            const PS::S64 cm_adr = _ptcl_iso[i].getParticleCMAddress();
+            if (cm_adr>0) {
+                _ptcl_iso[i].mass = pi_artificial.getMassBackup();
+                _ptcl_iso[i].vel += _sys[cm_adr].acc * _dt;
+                continue;
+            }
+        }
+        const PS::S64 i_adr = _ptcl_iso[i].adr_org;
+        if (i_adr>=0) _ptcl_iso[i].vel += _sys[i_adr].acc * _dt;
+    }
+    // c.m. artificial
+    const PS::S64 n_tot = _sys.getNumberOfParticleLocal();
+    const PS::S32 n_artificial_per_group = _ap_manager.getArtificialParticleN();
+#pragma omp parallel for
+    for (PS::S64 i=_adr_artificial_start; i<n_tot; i+= n_artificial_per_group) {
+        auto* pcm = _ap_manager.getCMParticles(&(_sys[i]));
+        pcm->vel += pcm->acc * _dt;
+    }
+}
+
+//! STREAM triad a = b + s*c, reference of the memory bandwidth
+void streamTriad(PS::ReallocatableArray<PS::F64>& _a, const PS::ReallocatableArray<PS::F64>& _b, const PS::ReallocatableArray<PS::F64>& _c, const PS::F64 _s) {
+    const PS::S64 n = _a.size();
+#pragma omp parallel for
+    for (PS::S64 i=0; i<n; i++) _a[i] = _b[i] + _s*_c[i];
+}
+
+//! measure the best wall time of a function
+/*! The function is called n_call times in one loop, the loop is repeated n_repeat times and the fastest one is used
+ */
+template<class Tfunc>
+PS::F64 measure(const PS::S32 _n_call, const PS::S32 _n_repeat, Tfunc&& _func) {
+    PS::F64 dt_best = PS::LARGE_FLOAT;
+    for (PS::S32 k=0; k<_n_repeat; k++) {
+        const PS::F64 t0 = PS::GetWtime();
+        for (PS::S32 i=0; i<_n_call; i++) _func();
+        dt_best = std::min(dt_best, (PS::GetWtime() - t0)/_n_call);
+    }
+    return dt_best;
+}
+
+//! print one result line
+void printResult(const char* _variant, const PS::S64 _n, const PS::F64 _t_call, const PS::F64 _bytes) {
+    std::cout<<std::left<<std::setw(12)<<_variant
+             <<std::right
+             <<std::setw(12)<<_n
+             <<std::setw(16)<<std::fixed<<std::setprecision(3)<<_t_call*1e3
+             <<std::setw(16)<<std::setprecision(3)<<_t_call*1e9/_n
+             <<std::setw(16)<<std::setprecision(2)<<_bytes/_t_call*1e-9
+             <<std::endl;
+}
+
+int main(int argc, char **argv){
+    PS::S64 n_real = 1000000;
+    PS::F64 f_cluster = 0.1;
+    PS::S32 n_call = 10;
+    PS::S32 n_repeat = 5;
+    PS::S32 seed = 1;
+
+    int copt;
+    while ((copt = getopt(argc, argv, "N:f:n:r:s:h")) != -1)
+        switch (copt) {
+        case 'N':
+            n_real = atol(optarg);
+            break;
+        case 'f':
+            f_cluster = atof(optarg);
+            break;
+        case 'n':
+            n_call = atoi(optarg);
+            break;
+        case 'r':
+            n_repeat = atoi(optarg);
+            break;
+        case 's':
+            seed = atoi(optarg);
+            break;
+        case 'h':
+            std::cout<<"Benchmark of the leap-frog kick of one tree step in one OpenMP parallel region against one parallel loop per particle category.\n"
+                     <<"A synthetic local particle system is kicked: single particles, isolated clusters of four particles (one binary with artificial particles and two singles)\n"
+                     <<"and the c.m. artificial particles of binaries. Variants:\n"
+                     <<"  MultiPass: one OpenMP loop per particle category (the previous kick of PeTar)\n"
+                     <<"  Fused:     FusedKick::kickAll, all categories in one parallel region\n"
+                     <<"  Triad:     STREAM triad on arrays with the same kick data size, reference of the memory bandwidth\n"
+                     <<"The effective bandwidth counts the useful data of each kicked particle: velocity read and write and acceleration read (72 bytes).\n"
+                     <<"MultiPass and Fused move the same data, Fused only saves the fork-joins and barriers between the categories.\n"
+                     <<"Results of MultiPass and Fused are checked to be identical.\n"
+                     <<"Options:\n"
+                     <<"  -N [int]:    number of real particles ("<<n_real<<")\n"
+                     <<"  -f [double]: fraction of particles in clusters ("<<f_cluster<<")\n"
+                     <<"  -n [int]:    number of kicks in one timing loop ("<<n_call<<")\n"
+                     <<"  -r [int]:    number of timing loops, the fastest one is used ("<<n_repeat<<")\n"
+                     <<"  -s [int]:    random seed ("<<seed<<")\n"
+                     <<"  -h:          help\n";
+            return 0;
+        default:
+            std::cerr<<"Unknown argument. check '-h' for help.\n";
+            abort();
+        }
+
+    // clusters have four particles, the first two are the binary members
+    const PS::S64 n_cluster = PS::S64(f_cluster*n_real)/4;
+    ArtificialParticleManager ap_manager;
+    const PS::S32 n_artificial_per_group = ap_manager.getArtificialParticleN();
+    const PS::S32 i_cm_offset = ap_manager.getIndexOffsetCM();
+
+    std::mt19937_64 gen(seed);
+    std::uniform_real_distribution<PS::F64> uni(-1.0, 1.0);
+
+    SystemSoftBench sys;
+    sys.ptcl.resizeNoInitialize(n_real + n_cluster*n_artificial_per_group);
+    for (PS::S64 i=0; i<sys.getNumberOfParticleLocal(); i++) {
+        FPSoft& pi = sys[i];
+        pi.mass = 1.0;
+        pi.pos = PS::F64vec(uni(gen), uni(gen), uni(gen));
+        pi.vel = PS::F64vec(uni(gen), uni(gen), uni(gen));
+        pi.acc = PS::F64vec(uni(gen), uni(gen), uni(gen));
+        pi.group_data.artificial.setParticleTypeToSingle();
+    }
+
+    // random cluster particles
+    std::vector<PS::S64> index(n_real);
+    for (PS::S64 i=0; i<n_real; i++) index[i] = i;
+    std::shuffle(index.begin(), index.end(), gen);
+    std::vector<bool> single_flag(n_real, true);
+
+    PS::ReallocatableArray<PtclH4> ptcl_iso;
+    for (PS::S64 k=0; k<n_cluster; k++) {
+        const PS::S64 adr_cm = n_real + k*n_artificial_per_group + i_cm_offset;
+        sys[adr_cm].group_data.artificial.setParticleTypeToCM(2.0, 2.0);
+        for (PS::S32 j=0; j<4; j++) {
+            const PS::S64 adr = index[4*k+j];
+            single_flag[adr] = false;
+            ptcl_iso.push_back(PtclHard(sys[adr], k, adr));
+            if (j<2) ptcl_iso.back().group_data.artificial.setParticleTypeToMember(1.0, -PS::F64(adr_cm));
+        }
+    }
+    PS::ReallocatableArray<PS::S32> adr_single;
+    for (PS::S64 i=0; i<n_real; i++) if (single_flag[i]) adr_single.push_back(i);
+
+    // backup for checking
+    PS::ReallocatableArray<FPSoft> sys_bk;
+    PS::ReallocatableArray<PtclH4> ptcl_iso_bk;
+    sys_bk.resizeNoInitialize(sys.ptcl.size());
+    ptcl_iso_bk.resizeNoInitialize(ptcl_iso.size());
+    for (PS::S64 i=0; i<sys.ptcl.size(); i++) sys_bk[i] = sys.ptcl[i];
+    for (PS::S64 i=0; i<ptcl_iso.size(); i++) ptcl_iso_bk[i] = ptcl_iso[i];
+    auto restore = [&]() {
+        for (PS::S64 i=0; i<sys.ptcl.size(); i++) sys.ptcl[i].vel = sys_bk[i].vel;
+        for (PS::S64 i=0; i<ptcl_iso.size(); i++) ptcl_iso[i].vel = ptcl_iso_bk[i].vel;
+    };
+    auto isSameVec = [](const PS::F64vec& _v1, const PS::F64vec& _v2) {
+        return _v1.x==_v2.x && _v1.y==_v2.y && _v1.z==_v2.z;
+    };
+    auto isSame = [&](PS::ReallocatableArray<PS::F64vec>& _vel) {
+        PS::S64 k=0;
+        for (PS::S64 i=0; i<sys.ptcl.size(); i++, k++) if (!isSameVec(sys.ptcl[i].vel, _vel[k])) return false;
+        for (PS::S64 i=0; i<ptcl_iso.size(); i++, k++) if (!isSameVec(ptcl_iso[i].vel, _vel[k])) return false;
+        return true;
+    };
+
+    const PS::F64 dt = 1.0/1024.0;
+
+    // check results of two kicks
+    PS::ReallocatableArray<PS::F64vec> vel_ref;
+    kickMultiPass(sys, adr_single, ptcl_iso, n_real, ap_manager, dt);
+    kickMultiPass(sys, adr_single, ptcl_iso, n_real, ap_manager, dt);
+    for (PS::S64 i=0; i<sys.ptcl.size(); i++) vel_ref.push_back(sys.ptcl[i].vel);
+    for (PS::S64 i=0; i<ptcl_iso.size(); i++) vel_ref.push_back(ptcl_iso[i].vel);
+    restore();
+    FusedKick<FPSoft>::kickAll(sys, adr_single, ptcl_iso, (PS::ReallocatableArray<PtclH4>*)NULL, (const PS::ReallocatableArray<PS::S32>*)NULL, n_real, ap_manager, dt);
+    FusedKick<FPSoft>::kickAll(sys, adr_single, ptcl_iso, (PS::ReallocatableArray<PtclH4>*)NULL, (const PS::ReallocatableArray<PS::S32>*)NULL, n_real, ap_manager, dt);
+    if (!isSame(vel_ref)) {
+        std::cerr<<"Error: velocities of the fused kick are different from the multi-pass kick!\n";
+        abort();
+    }
+    restore();
+
+    const PS::S64 n_kick = n_real + n_cluster;
+    const PS::F64 bytes = 72.0*n_kick;
+
+    std::cout<<"# PeTar kick benchmark, version: "<<GetVersion()
+             <<", threads: "<<PS::Comm::getNumberOfThread()
+             <<", N_real: "<<n_real<<", N_cluster_ptcl: "<<4*n_cluster<<", N_cm: "<<n_cluster<<std::endl;
+    std::cout<<std::left<<std::setw(12)<<"Variant"
+             <<std::right
+             <<std::setw(12)<<"N_kick"
+             <<std::setw(16)<<"ms/kick"
+             <<std::setw(16)<<"ns/particle"
+             <<std::setw(16)<<"GB/s"
+             <<std::endl;
+
+    PS::F64 t_multi = measure(n_call, n_repeat, [&]() { kickMultiPass(sys, adr_single, ptcl_iso, n_real, ap_manager, dt); });
+    printResult("MultiPass", n_kick, t_multi, bytes);
+    restore();
+
+    PS::F64 t_fused = measure(n_call, n_repeat, [&]() {
+            FusedKick<FPSoft>::kickAll(sys, adr_single, ptcl_iso, (PS::ReallocatableArray<PtclH4>*)NULL, (const PS::ReallocatableArray<PS::S32>*)NULL, n_real, ap_manager, dt); });
+    printResult("Fused", n_kick, t_fused, bytes);
+    restore();
+
+
+    // triad with the same data size: 2 arrays read and 1 written
+    const PS::S64 n_triad = PS::S64(bytes/24.0);
+    PS::ReallocatableArray<PS::F64> a, b, c;
+    a.resizeNoInitialize(n_triad);
+    b.resizeNoInitialize(n_triad);
+    c.resizeNoInitialize(n_triad);
+#pragma omp parallel for
+    for (PS::S64 i=0; i<n_triad; i++) {
+        a[i] = 0.0;
+        b[i] = 1.0;
+        c[i] = 2.0;
+    }
+    PS::F64 t_triad = measure(n_call, n_repeat, [&]() { streamTriad(a, b, c, 3.0); });
+    printResult("Triad", n_kick, t_triad, 24.0*n_triad);
+
+    std::cout<<"# Speedup of Fused over MultiPass: "<<std::setprecision(2)<<t_multi/t_fused<<std::endl;
+
+    return 0;
+}
@@ -36,10 +36,12 @@ public:
         Mass is weighted by mean anomaly and summation is the same as binary mass.
         @param[in] _ptcl_artificial: particle array to store the sample particles, 2*n_split_ will be used
         @param[in] _bin: binary orbit 
+        @param[in] _shift_cm: if false, the positions and velocities are relative to the c.m. of _bin
      */
     template <class Tptcl>
     void createSampleParticles(Tptcl* _ptcl_artificial,
-                                    COMM::BinaryTree<Tptcl> &_bin) {
+                                    COMM::BinaryTree<Tptcl> &_bin,
+                                    const bool _shift_cm=true) {
 #ifdef ARTIFICIAL_PARTICLE_DEBUG
         PS::F64 m_check[2]={0.0,0.0};
 #endif
@@ -72,8 +74,10 @@ public:
                 pj->mass = mass_member[j] * dmean_anomaly * inverse_twopi;
 
                 // center_of_mass_correction 
-                pj->pos += _bin.pos;
-                pj->vel += _bin.vel;
+                if (_shift_cm) {
+                    pj->pos += _bin.pos;
+                    pj->vel += _bin.vel;
+                }
 
 #ifdef ARTIFICIAL_PARTICLE_DEBUG
                 assert(mass_member[j]>0);
@@ -83,7 +87,8 @@ public:
             }
 #ifdef ARTIFICIAL_PARTICLE_DEBUG
             PS::F64vec pos_i_cm = (_ptcl_artificial[2*i].mass*_ptcl_artificial[2*i].pos+_ptcl_artificial[2*i+1].mass*_ptcl_artificial[2*i+1].pos)/(_ptcl_artificial[2*i].mass + _ptcl_artificial[2*i+1].mass);
-            assert(abs((pos_i_cm - _bin.pos)*(pos_i_cm - _bin.pos))<1e-10);
+            const PS::F64vec pos_cm_ref = _shift_cm? _bin.pos: PS::F64vec(0.0);
+            assert(abs((pos_i_cm - pos_cm_ref)*(pos_i_cm - pos_cm_ref))<1e-10);
 #endif
             //mnormal += odv;
         }
@@ -188,7 +188,7 @@ public:
         vel = new PS::F64vec[n_loc];
 
         PS::MTTS mt;
-        mt.init_genrand( PS::Comm::getRank() );
+        mt.init_genrand( PS::Comm::getRank()+seed*PS::Comm::getNumberOfProc() );
         for(int i=0; i<n_loc; i++){
             mass[i] = mass_glb / n_glb;
             double r_tmp = 9999.9;
@@ -0,0 +1,137 @@
+#pragma once
+#include <particle_simulator.hpp>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstring>
+#include <cassert>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define PERF_COUNTER_N 6
+
+//! Intel FP_ARITH_INST_RETIRED, packed single and double precision of 128, 256 and 512 bits
+#define PERF_COUNTER_FP_VECTOR_RAW_EVENT 0xfcc7
+
+//! hardware performance counters of all OpenMP threads from perf_event_open (Linux only)
+/*! Each OpenMP thread opens its own counters of cycles, instructions, L1 data cache read misses,
+    last-level cache misses, branch misses and retired floating-point vector instructions (a raw PMU event,
+    the default is for Intel CPUs since Skylake). Counters that cannot be opened (e.g. due to
+    /proc/sys/kernel/perf_event_paranoid or the CPU model) are reported as zero.
+    read() collects the counts of all threads from the master thread and must be called outside parallel regions.
+    Counts are scaled by the enabled/running time when the kernel multiplexes counters.
+    When the counters are not initialized, the cost of a Tprofile start/end is one branch.
+ */
+class PerfCounter{
+private:
+    std::vector<int> fd_;  // file descriptors [thread*PERF_COUNTER_N + counter], -1: unavailable
+    PS::S32 n_thread_;
+    bool active_flag_;
+
+#ifdef __linux__
+    static int openEvent(const PS::U32 _type, const PS::U64 _config) {
+        struct perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = _type;
+        attr.config = _config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        // pid=0, cpu=-1: the calling thread on any CPU
+        return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+#endif
+
+public:
+    PerfCounter(): fd_(), n_thread_(0), active_flag_(false) {}
+
+    //! counter names
+    static const char* getName(const PS::S32 _k) {
+        static const char* names[PERF_COUNTER_N] = {"Cycles", "Instructions", "L1D_miss", "LLC_miss", "Branch_miss", "FP_vector"};
+        return names[_k];
+    }
+
+    //! open counters in each OpenMP thread
+    /*! @param[in] _fp_event: raw PMU event code of floating-point vector instructions, 0: not counted
+      \return number of counters available on all threads
+     */
+    PS::S32 initial(const PS::U64 _fp_event=PERF_COUNTER_FP_VECTOR_RAW_EVENT) {
+        n_thread_ = PS::Comm::getNumberOfThread();
+        fd_.assign(n_thread_*PERF_COUNTER_N, -1);
+#ifdef __linux__
+        const PS::U32 type[PERF_COUNTER_N] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_RAW};
+        const PS::U64 config[PERF_COUNTER_N] = {PERF_COUNT_HW_CPU_CYCLES,
+                                                PERF_COUNT_HW_INSTRUCTIONS,
+                                                PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ<<8) | (PERF_COUNT_HW_CACHE_RESULT_MISS<<16),
+                                                PERF_COUNT_HW_CACHE_MISSES,
+                                                PERF_COUNT_HW_BRANCH_MISSES,
+                                                _fp_event};
+#pragma omp parallel
+        {
+            const PS::S32 ith = PS::Comm::getThreadNum();
+            for (PS::S32 k=0; k<PERF_COUNTER_N; k++) {
+                if (type[k]==PERF_TYPE_RAW && _fp_event==0) continue;
+                fd_[ith*PERF_COUNTER_N+k] = openEvent(type[k], config[k]);
+            }
+        }
+#endif
+        PS::S32 n_avail = 0;
+        for (PS::S32 k=0; k<PERF_COUNTER_N; k++) {
+            bool avail_flag = true;
+            for (PS::S32 i=0; i<n_thread_; i++) if (fd_[i*PERF_COUNTER_N+k]<0) avail_flag = false;
+            if (avail_flag) n_avail++;
+        }
+        active_flag_ = (n_avail>0);
+        return n_avail;
+    }
+
+    //! whether counters are switched on
+    bool isActive() const {
+        return active_flag_;
+    }
+
+    //! number of values returned by read()
+    PS::S32 getSize() const {
+        return n_thread_*PERF_COUNTER_N;
+    }
+
+    //! number of threads
+    PS::S32 getNumberOfThread() const {
+        return n_thread_;
+    }
+
+    //! read current counts of all threads
+    /*! @param[out] _count: array of getSize(), [thread*PERF_COUNTER_N + counter]
+     */
+    void read(PS::S64* _count) const {
+        for (PS::S32 i=0; i<(PS::S32)fd_.size(); i++) {
+            _count[i] = 0;
+#ifdef __linux__
+            if (fd_[i]<0) continue;
+            PS::U64 buf[3]; // value, time enabled, time running
+            if (::read(fd_[i], buf, sizeof(buf))!=sizeof(buf)) continue;
+            if (buf[2]>0) _count[i] = (buf[2]<buf[1])? PS::S64(PS::F64(buf[0])*PS::F64(buf[1])/PS::F64(buf[2])): PS::S64(buf[0]);
+#endif
+        }
+    }
+
+    //! close all counters
+    void close() {
+#ifdef __linux__
+        for (auto fd: fd_) if (fd>=0) ::close(fd);
+#endif
+        fd_.clear();
+        active_flag_ = false;
+    }
+
+    ~PerfCounter() {
+        close();
+    }
+};
+
+// global counters, defined in static_variables.hpp
+extern PerfCounter perf_counter;
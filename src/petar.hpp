@@ -25,6 +25,7 @@
 #include<sstream>
 //#include<unistd.h>
 #include<getopt.h>
+#include<new>
 
 #ifdef MPI_DEBUG
 #include <mpi.h>
@@ -68,10 +69,24 @@ int MPI_Irecv(void* buffer, int count, MPI_Datatype datatype, int dest, int tag,
 #ifdef USE_FUGAKU
 #include "force_fugaku.hpp"
 #endif
+#ifdef SOFT_MIXED_PRECISION
+#if !defined(USE_SIMD) || defined(P3T_64BIT) || defined(USE_GPU) || defined(USE_FUGAKU)
+#error "SOFT_MIXED_PRECISION requires the 32 bits CPU SIMD force kernels"
+#endif
+#endif
+#ifdef SOFT_LET_COMPRESS
+#if !defined(USE_QUAD) || defined(USE_GPU) || defined(USE_FUGAKU)
+#error "SOFT_LET_COMPRESS requires USE_QUAD and the CPU force kernels"
+#endif
+#endif
 #include"energy.hpp"
 #include"hard.hpp"
 #include"io.hpp"
 #include"status.hpp"
+#include"global_reduction.hpp"
+#include"fused_kick.hpp"
+#include"hard_drive_pool.hpp"
+#include"tree_tuner.hpp"
 #include"particle_distribution_generator.hpp"
 #include"domain.hpp"
 #include"cluster_list.hpp"
@@ -137,6 +152,17 @@ public:
     IOParams<PS::S64> interrupt_detection_option;
 #ifdef ADJUST_GROUP_PRINT
     IOParams<PS::S64> adjust_group_write_option;
+#endif
+    IOParams<PS::S64> hard_dump_slow_n;
+    IOParams<PS::F64> hard_dump_slow_time;
+    IOParams<PS::S64> trace_buffer_size;
+    IOParams<PS::S64> perf_counter_option;
+    IOParams<PS::S64> perf_fp_event;
+    IOParams<PS::S64> hard_shared_pool_option;
+    IOParams<PS::S64> tree_tune_option;
+    IOParams<PS::S64> tree_tune_n_step;
+#ifdef HARD_GROUP_RECORD
+    IOParams<PS::F64> group_record_tol;
 #endif
     IOParams<PS::S64> append_switcher;
     IOParams<std::string> fname_snp;
@@ -207,6 +233,17 @@ public:
 #endif
 #ifdef ADJUST_GROUP_PRINT
                      adjust_group_write_option(input_par_store, 1, "write-group-info", "Print new and end of groups: 0: no print; 1: print to file [data filename prefix].group.[MPI rank] if -w >0"),
+#endif
+                     hard_dump_slow_n   (input_par_store, 0,   "hard-dump-slow-number", "Number of the slowest hard clusters dumped per output interval to files [data filename prefix].hard_slow.[MPI rank].[snapshot index].[k], for replay with petar.hard.debug; all dumps are listed in [data filename prefix].hard_slow_list.[MPI rank]; 0: off"),
+                     hard_dump_slow_time(input_par_store, 0.0, "hard-dump-slow-time", "Dump hard clusters with integration wall time [s] larger than this value to files [data filename prefix].hard_slow.[MPI rank].t[thread].[k]; 0: off"),
+                     trace_buffer_size  (input_par_store, 0,   "trace-buffer-size", "Timeline trace of phases, hard clusters and collectives: number of spans kept per thread between outputs (older ones are dropped), written to [data filename prefix].trace.[MPI rank] in Chrome trace-event format, merge with petar.trace.merge; 0: off"),
+                     perf_counter_option(input_par_store, 0, "perf-counter", "Hardware performance counters (cycles, instructions, L1/LLC misses, branch misses, FP vector instructions) of each phase from perf_event_open (Linux only), summed over threads and printed with the time profile: 0: off; 1: on"),
+                     perf_fp_event(input_par_store, PERF_COUNTER_FP_VECTOR_RAW_EVENT, "perf-fp-event", "Raw PMU event code of floating-point vector instructions for '--perf-counter', hexadecimal with prefix '0x' is accepted; default is Intel FP_ARITH_INST_RETIRED (packed); 0: not counted"),
+                     hard_shared_pool_option(input_par_store, 1, "hard-shared-pool", "Integrate isolated clusters and clusters crossing MPI domains in one shared dynamic work pool, without the barrier between the two sets; the busy and idle time of threads in hard cluster integration are printed with the time profile: 0: off; 1: on"),
+                     tree_tune_option(input_par_store, 0, "tree-tune", "Tune particle-tree leaf and group number limits online from the measured tree time per step; candidates around the current limits are measured one after another; theta is not changed: 0: off; 1: search at the beginning (also after restart); 2: also search again when the tree time per step increases by more than 20%"),
+                     tree_tune_n_step(input_par_store, 4, "tree-tune-step", "Number of measured tree steps per candidate for '--tree-tune'"),
+#ifdef HARD_GROUP_RECORD
+                     group_record_tol(input_par_store, 0.0, "group-record-tol", "Relative tolerance of orbital parameters to reuse the group record of the last tree step (stability verdicts and orbital sample particles); 0: reuse only for identical orbits, the results are the same as without records; a positive value (e.g. 1e-5) also reuses records of slightly changed orbits and changes the results"),
 #endif
                      append_switcher(input_par_store, 1, "a", "Data output style: 0 - create new output files and overwrite existing ones except snapshots; 1 - append new data to existing files"),
                      fname_snp(input_par_store, "data", "f", "Prefix of filenames for output data: [prefix].**"),
@@ -259,6 +296,17 @@ public:
             {adjust_group_write_option.key,   required_argument, &petar_flag, 24},
 #endif            
             {nstep_dt_soft_kepler.key,  required_argument, &petar_flag, 25},
+            {hard_dump_slow_n.key,      required_argument, &petar_flag, 26},
+            {hard_dump_slow_time.key,   required_argument, &petar_flag, 27},
+            {trace_buffer_size.key,     required_argument, &petar_flag, 28},
+            {perf_counter_option.key,   required_argument, &petar_flag, 29},
+            {perf_fp_event.key,         required_argument, &petar_flag, 30},
+            {hard_shared_pool_option.key, required_argument, &petar_flag, 31},
+            {tree_tune_option.key,      required_argument, &petar_flag, 32},
+            {tree_tune_n_step.key,      required_argument, &petar_flag, 33},
+#ifdef HARD_GROUP_RECORD
+            {group_record_tol.key,      required_argument, &petar_flag, 34},
+#endif
             {"help",                  no_argument, 0, 'h'},        
             {0,0,0,0}
         };
@@ -428,6 +476,62 @@ public:
                     if(print_flag) nstep_dt_soft_kepler.print(std::cout);
                     opt_used += 2;
                     break;
+                case 26:
+                    hard_dump_slow_n.value = atoi(optarg);
+                    if(print_flag) hard_dump_slow_n.print(std::cout);
+                    opt_used += 2;
+                    assert(hard_dump_slow_n.value>=0);
+                    break;
+                case 27:
+                    hard_dump_slow_time.value = atof(optarg);
+                    if(print_flag) hard_dump_slow_time.print(std::cout);
+                    opt_used += 2;
+                    assert(hard_dump_slow_time.value>=0.0);
+                    break;
+                case 28:
+                    trace_buffer_size.value = atol(optarg);
+                    if(print_flag) trace_buffer_size.print(std::cout);
+                    opt_used += 2;
+                    assert(trace_buffer_size.value>=0);
+                    break;
+                case 29:
+                    perf_counter_option.value = atoi(optarg);
+                    if(print_flag) perf_counter_option.print(std::cout);
+                    opt_used += 2;
+                    assert(perf_counter_option.value>=0&&perf_counter_option.value<=1);
+                    break;
+                case 30:
+                    perf_fp_event.value = strtoll(optarg, NULL, 0);
+                    if(print_flag) perf_fp_event.print(std::cout);
+                    opt_used += 2;
+                    assert(perf_fp_event.value>=0);
+                    break;
+                case 31:
+                    hard_shared_pool_option.value = atoi(optarg);
+                    if(print_flag) hard_shared_pool_option.print(std::cout);
+                    opt_used += 2;
+                    assert(hard_shared_pool_option.value>=0&&hard_shared_pool_option.value<=1);
+                    break;
+                case 32:
+                    tree_tune_option.value = atoi(optarg);
+                    if(print_flag) tree_tune_option.print(std::cout);
+                    opt_used += 2;
+                    assert(tree_tune_option.value>=0&&tree_tune_option.value<=2);
+                    break;
+                case 33:
+                    tree_tune_n_step.value = atoi(optarg);
+                    if(print_flag) tree_tune_n_step.print(std::cout);
+                    opt_used += 2;
+                    assert(tree_tune_n_step.value>0);
+                    break;
+#ifdef HARD_GROUP_RECORD
+                case 34:
+                    group_record_tol.value = atof(optarg);
+                    if(print_flag) group_record_tol.print(std::cout);
+                    opt_used += 2;
+                    assert(group_record_tol.value>=0.0);
+                    break;
+#endif
                 default:
                     break;
                 }
@@ -607,6 +711,18 @@ public:
         assert(n_smp_ave.value>0.0);
         assert(theta.value>=0.0);
         assert(eta.value>0.0);
+#ifndef PROFILE
+        // the counters are read in the time profile
+        if (perf_counter_option.value>0) {
+            std::cerr<<"Error: '--perf-counter' requires the time profile (compile with -D PROFILE)"<<std::endl;
+            abort();
+        }
+        // the tree time is measured in the time profile
+        if (tree_tune_option.value>0) {
+            std::cerr<<"Error: '--tree-tune' requires the time profile (compile with -D PROFILE)"<<std::endl;
+            abort();
+        }
+#endif
         return true;
     }
 
@@ -617,14 +733,23 @@ public:
 class PeTar {
 public:
 #ifdef USE_QUAD
+#ifdef SOFT_LET_COMPRESS
+    // same as QuadrupoleWithSymmetrySearch but sending single precision super particles in LET
+    typedef SPJQuadrupoleInAndOutF32 SPJForce;
+    typedef PS::TreeForForce<PS::SEARCH_MODE_LONG_SYMMETRY, ForceSoft, EPISoft, EPJSoft, 
+                             PS::MomentQuadrupoleInAndOut, PS::MomentQuadrupoleInAndOut, SPJForce, PS::CALC_DISTANCE_TYPE_NORMAL> TreeForce;
+#else
+    typedef PS::SPJQuadrupoleInAndOut SPJForce;
     typedef PS::TreeForForceLong<ForceSoft, EPISoft, EPJSoft>::QuadrupoleWithSymmetrySearch TreeForce; 
+#endif
 #else
+    typedef PS::SPJMonopoleInAndOut SPJForce;
     typedef PS::TreeForForceLong<ForceSoft, EPISoft, EPJSoft>::MonopoleWithSymmetrySearch TreeForce;
 #endif
     typedef PS::ParticleSystem<FPSoft> SystemSoft;
 
     // For neighbor searching
-    typedef PS::TreeForForceShort<ForceSoft, EPISoft, EPJSoft>::Symmetry TreeNB;
+    typedef PS::TreeForForceShort<ForceSoft, EPISoft, EPJNB>::Symmetry TreeNB;
 
     // IO
     IOParamsPeTar input_parameters;
@@ -674,9 +799,22 @@ public:
     // tree time step manager
     KickDriftStep dt_manager;
 
-    // tree
-    TreeNB tree_nb;
-    TreeForce tree_soft;
+    //! neighbor search and force trees with one leaf and group limit setting
+    struct TreeSet{
+        PS::S64 n_leaf_limit;
+        PS::S64 n_group_limit;
+        TreeNB nb;
+        TreeForce soft;
+
+        TreeSet(): n_leaf_limit(0), n_group_limit(0), nb(), soft() {}
+    };
+    // trees of the current limits and of the best candidate of the tree tuner, FDPS trees cannot be initialized twice
+    std::vector<TreeSet*> tree_set;
+    // tree in use
+    TreeNB* tree_nb;
+    TreeForce* tree_soft;
+    // online tuning of tree leaf and group limits
+    TreeParameterTuner tree_tuner;
 
 #ifdef GALPY
     GalpyManager galpy_manager;
@@ -690,6 +828,16 @@ public:
     SystemHard system_hard_connected;
 #endif
     int n_interrupt_glb;
+    // shared work pool of cluster integrations of isolated and connected hard systems
+    HardDrivePool<SystemHard> hard_drive_pool;
+
+    // fused global reductions, one collective per synchronization point
+    GlobalReduction reduction_step;       // blocking reduction of scalars
+    GlobalReduction reduction_changeover; // non-blocking reduction of changeover update number, started in createGroup
+#ifdef PROFILE
+    GlobalReduction reduction_profile;    // non-blocking reduction of profile counts, finished before the next use
+    PS::ReallocatableArray<NumCounter*> reduction_profile_counter; // global counters to accumulate reduction_profile
+#endif
 
     // mass change particle list
     PS::ReallocatableArray<PS::S32> mass_modify_list;
@@ -733,7 +881,7 @@ public:
         file_header(), system_soft(), id_adr_map(),
         n_loop(0), domain_decompose_weight(1.0), dinfo(), pos_domain(NULL), 
         dt_manager(),
-        tree_nb(), tree_soft(), 
+        tree_set(1, new TreeSet()), tree_nb(&tree_set[0]->nb), tree_soft(&tree_set[0]->soft), tree_tuner(),
 #ifdef GALPY
         galpy_manager(),
 #endif
@@ -741,7 +889,7 @@ public:
 #ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
         system_hard_connected(), 
 #endif
-        n_interrupt_glb(0),
+        n_interrupt_glb(0), hard_drive_pool(),
         mass_modify_list(), remove_list(), remove_id_record(),
         search_cluster(),
         read_parameters_flag(false), read_data_flag(false), initial_parameters_flag(false), initial_step_flag(false) {
@@ -767,19 +915,19 @@ public:
     void treeNeighborSearch() {
 #ifdef PROFILE
         profile.tree_nb.start();
-        tree_nb.clearNumberOfInteraction();
-        tree_nb.clearTimeProfile();
+        tree_nb->clearNumberOfInteraction();
+        tree_nb->clearTimeProfile();
 #endif
 #ifdef USE_SIMD
-        tree_nb.calcForceAllAndWriteBack(SearchNeighborEpEpSimd(), system_soft, dinfo);
+        tree_nb->calcForceAllAndWriteBack(SearchNeighborEpEpSimd(), system_soft, dinfo);
 #elif USE_FUGAKU
-        tree_nb.calcForceAllAndWriteBack(SearchNeighborEpEpFugaku(), system_soft, dinfo);
+        tree_nb->calcForceAllAndWriteBack(SearchNeighborEpEpFugaku(), system_soft, dinfo);
 #else
-        tree_nb.calcForceAllAndWriteBack(SearchNeighborEpEpNoSimd(), system_soft, dinfo);
+        tree_nb->calcForceAllAndWriteBack(SearchNeighborEpEpNoSimd(), system_soft, dinfo);
 #endif
         
 #ifdef PROFILE
-        tree_nb_profile += tree_nb.getTimeProfile();
+        tree_nb_profile += tree_nb->getTimeProfile();
         //profile.tree_nb.barrier();
         //PS::Comm::barrier();
         profile.tree_nb.end();
@@ -793,22 +941,22 @@ public:
         profile.search_cluster.start();
 #endif
         // >2.1 search clusters ----------------------------------------
-        search_cluster.searchNeighborOMP<SystemSoft, TreeNB, EPJSoft>
-            (system_soft, tree_nb, pos_domain, 1.0, input_parameters.search_peri_factor.value);
+        search_cluster.searchNeighborOMP<SystemSoft, TreeNB, EPJNB>
+            (system_soft, *tree_nb, pos_domain, 1.0, input_parameters.search_peri_factor.value);
 
         search_cluster.searchClusterLocal();
         search_cluster.setIdClusterLocal();
 
         // >2.2 Send/receive connect cluster
 #ifdef PARTICLE_SIMULATOR_MPI_PARALLEL        
-        search_cluster.connectNodes(pos_domain,tree_nb);
-        search_cluster.setIdClusterGlobalIteration();
+        search_cluster.connectNodes();
+        search_cluster.setIdClusterGlobal();
         search_cluster.sendAndRecvCluster(system_soft);
 #endif
 
 #ifdef PROFILE
         profile.search_cluster.barrier();
-        PS::Comm::barrier();
+        barrierProfile();
         profile.search_cluster.end();
 #endif    
     }
@@ -856,7 +1004,17 @@ public:
 
         // update total particle number including artificial particles
         stat.n_all_loc = system_soft.getNumberOfParticleLocal();
-        stat.n_all_glb = system_soft.getNumberOfParticleGlobal();
+
+        // the global particle number and changeover update number are not needed until the end of the tree step,
+        // start a non-blocking reduction here and finish it in finishGroupReduction
+        reduction_changeover.clear();
+        reduction_changeover.add(PS::F64(stat.n_all_loc));
+#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL        
+        reduction_changeover.add(PS::F64(system_hard_connected.getNClusterChangeOverUpdate() + system_hard_isolated.getNClusterChangeOverUpdate()));
+#else
+        reduction_changeover.add(PS::F64(system_hard_isolated.getNClusterChangeOverUpdate()));
+#endif
+        reduction_changeover.startReduce();
             
         // >2.4 set adr/rank for artificial particles in GPS
 #pragma omp parallel for
@@ -870,18 +1028,45 @@ public:
         // >3 Tree for force ----------------------------------------
 #ifdef PROFILE
         profile.create_group.barrier();
-        PS::Comm::barrier();
+        barrierProfile();
         profile.create_group.end();
 #endif
     }
 
+#ifdef SOFT_MIXED_PRECISION
+    //! set the reference position of single precision coordinates to the center of the local particle box
+    /*! The SIMD kernels and the changeover corrections round positions relative to this reference, it is updated only before the tree force.
+        Minimum and maximum are used since they do not depend on the thread number.
+     */
+    void setSoftKernelPosRef() {
+        const PS::S64 n_loc = system_soft.getNumberOfParticleLocal();
+        if (n_loc==0) return;
+        PS::F64 x_min = system_soft[0].pos.x, y_min = system_soft[0].pos.y, z_min = system_soft[0].pos.z;
+        PS::F64 x_max = x_min, y_max = y_min, z_max = z_min;
+#pragma omp parallel for reduction(min: x_min, y_min, z_min) reduction(max: x_max, y_max, z_max)
+        for (PS::S64 i=0; i<n_loc; i++) {
+            const PS::F64vec& pos = system_soft[i].pos;
+            x_min = std::min(x_min, pos.x);
+            y_min = std::min(y_min, pos.y);
+            z_min = std::min(z_min, pos.z);
+            x_max = std::max(x_max, pos.x);
+            y_max = std::max(y_max, pos.y);
+            z_max = std::max(z_max, pos.z);
+        }
+        EPISoft::pos_ref = PS::F64vec(0.5*(x_min+x_max), 0.5*(y_min+y_max), 0.5*(z_min+z_max));
+    }
+#endif
+
     //! calculate tree solf force
     void treeSoftForce() {
+#ifdef SOFT_MIXED_PRECISION
+        setSoftKernelPosRef();
+#endif
 #ifdef PROFILE
         profile.tree_soft.start();
 
-        tree_soft.clearNumberOfInteraction();
-        tree_soft.clearTimeProfile();
+        tree_soft->clearNumberOfInteraction();
+        tree_soft->clearTimeProfile();
 #endif
 
 #ifdef USE_GPU
@@ -891,14 +1076,14 @@ public:
         PS::F64 rout2 = EPISoft::r_out*EPISoft::r_out;
         PS::F64 G= ForceSoft::grav_const;
 #ifdef PARTICLE_SIMULATOR_GPU_MULIT_WALK_INDEX
-        tree_soft.calcForceAllAndWriteBackMultiWalkIndex(CalcForceWithLinearCutoffCUDAMultiWalk(my_rank, eps2, rout2, G),
+        tree_soft->calcForceAllAndWriteBackMultiWalkIndex(CalcForceWithLinearCutoffCUDAMultiWalk(my_rank, eps2, rout2, G),
                                                          RetrieveForceCUDA,
                                                          tag_max,
                                                          system_soft,
                                                          dinfo,
                                                          n_walk_limit);
 #else // no multi-walk index
-        tree_soft.calcForceAllAndWriteBackMultiWalk(CalcForceWithLinearCutoffCUDA(my_rank, eps2, rout2, G),
+        tree_soft->calcForceAllAndWriteBackMultiWalk(CalcForceWithLinearCutoffCUDA(my_rank, eps2, rout2, G),
                                                     RetrieveForceCUDA,
                                                     tag_max,
                                                     system_soft,
@@ -910,7 +1095,7 @@ public:
         PS::F64 eps2 = EPISoft::eps*EPISoft::eps;
         PS::F64 rout2 = EPISoft::r_out*EPISoft::r_out;
         PS::F64 G= ForceSoft::grav_const;
-        tree_soft.calcForceAllAndWriteBack(CalcForceEpEpWithLinearCutoffFugaku(eps2, rout2, G),
+        tree_soft->calcForceAllAndWriteBack(CalcForceEpEpWithLinearCutoffFugaku(eps2, rout2, G),
 #ifdef USE_QUAD
                                            CalcForceEpSpQuadFugaku(eps2, G),
 #else // no quad
@@ -920,7 +1105,7 @@ public:
                                            dinfo);
         
 #elif USE_SIMD // end use_gpu
-        tree_soft.calcForceAllAndWriteBack(CalcForceEpEpWithLinearCutoffSimd(),
+        tree_soft->calcForceAllAndWriteBack(CalcForceEpEpWithLinearCutoffSimd(),
 #ifdef USE_QUAD
                                            CalcForceEpSpQuadSimd(),
 #else // no quad
@@ -929,7 +1114,7 @@ public:
                                            system_soft,
                                            dinfo);
 #else // end use_simd
-        tree_soft.calcForceAllAndWriteBack(CalcForceEpEpWithLinearCutoffNoSimd(),
+        tree_soft->calcForceAllAndWriteBack(CalcForceEpEpWithLinearCutoffNoSimd(),
 #ifdef USE_QUAD
                                            CalcForceEpSpQuadNoSimd(),
 #else
@@ -940,12 +1125,13 @@ public:
 #endif // end else
 
 #ifdef PROFILE
-        n_count.ep_ep_interact     += tree_soft.getNumberOfInteractionEPEPLocal();
-        n_count_sum.ep_ep_interact += tree_soft.getNumberOfInteractionEPEPGlobal();
-        n_count.ep_sp_interact     += tree_soft.getNumberOfInteractionEPSPLocal();
-        n_count_sum.ep_sp_interact += tree_soft.getNumberOfInteractionEPSPGlobal(); 
+        n_count.ep_ep_interact     += tree_soft->getNumberOfInteractionEPEPLocal();
+        addProfileReduction(n_count_sum.ep_ep_interact, tree_soft->getNumberOfInteractionEPEPLocal());
+        n_count.ep_sp_interact     += tree_soft->getNumberOfInteractionEPSPLocal();
+        addProfileReduction(n_count_sum.ep_sp_interact, tree_soft->getNumberOfInteractionEPSPLocal());
 
-        tree_soft_profile += tree_soft.getTimeProfile();
+        tree_soft_profile += tree_soft->getTimeProfile();
+        tree_soft_profile.addLETSend<EPJSoft, SPJForce>(*tree_soft);
         domain_decompose_weight = tree_soft_profile.calc_force;
 
         //profile.tree_soft.barrier();
@@ -958,7 +1144,7 @@ public:
     //! correct force due to change over function by using particle tree neighbor search
     void treeForceCorrectChangeoverTreeNeighbor() {
         // all particles
-        SystemHard::correctForceWithCutoffTreeNeighborOMP<SystemSoft, FPSoft, TreeForce, EPJSoft>(system_soft, tree_soft, system_soft.getNumberOfParticleLocal(), hard_manager.ap_manager);        
+        SystemHard::correctForceWithCutoffTreeNeighborOMP<SystemSoft, FPSoft, TreeForce, EPJSoft>(system_soft, *tree_soft, system_soft.getNumberOfParticleLocal(), hard_manager.ap_manager);        
     }
 
     //! correct force due to change over function
@@ -985,7 +1171,7 @@ public:
 
 #ifdef PARTICLE_SIMULATOR_MPI_PARALLEL        
         // Connected clusters
-        system_hard_connected.correctForceWithCutoffTreeNeighborAndClusterOMP<SystemSoft, FPSoft, TreeForce, EPJSoft>(system_soft, tree_soft, search_cluster.getAdrSysConnectClusterSend());
+        system_hard_connected.correctForceWithCutoffTreeNeighborAndClusterOMP<SystemSoft, FPSoft, TreeForce, EPJSoft>(system_soft, *tree_soft, search_cluster.getAdrSysConnectClusterSend());
 #endif
 
 #ifdef CORRECT_FORCE_DEBUG
@@ -998,7 +1184,7 @@ public:
         }
 
         // all particles
-        SystemHard::correctForceWithCutoffTreeNeighborOMP<SystemSoft, FPSoft, TreeForce, EPJSoft>(system_soft, tree_soft, n_loc, hard_manager.ap_manager);
+        SystemHard::correctForceWithCutoffTreeNeighborOMP<SystemSoft, FPSoft, TreeForce, EPJSoft>(system_soft, *tree_soft, n_loc, hard_manager.ap_manager);
 
         // single 
         //system_hard_one_cluster.correctPotWithCutoffOMP(system_soft, search_cluster.getAdrSysOneCluster());
@@ -1026,7 +1212,7 @@ public:
 #endif
 #ifdef PROFILE
         profile.force_correct.barrier();
-        PS::Comm::barrier();
+        barrierProfile();
         profile.force_correct.end();
 #endif
     }
@@ -1074,7 +1260,7 @@ public:
         
 #ifdef PROFILE
         profile.other.barrier();
-        PS::Comm::barrier();
+        barrierProfile();
         profile.other.end();
 #endif
     }
@@ -1125,13 +1311,23 @@ public:
     void GradientKick() {
 #ifdef PROFILE
         profile.tree_soft.start();
-        tree_soft.clearNumberOfInteraction();
-        tree_soft.clearTimeProfile();
+        tree_soft->clearNumberOfInteraction();
+        tree_soft->clearTimeProfile();
 #endif
         // correction calculation
         //tree_soft.setParticaleLocalTree(system_soft, false);
         
-        tree_soft.calcForceAllAndWriteBack(CalcCorrectEpEpWithLinearCutoffNoSimd(),
+#ifdef USE_SIMD
+        tree_soft->calcForceAllAndWriteBack(CalcCorrectEpEpWithLinearCutoffSimd(),
+#ifdef USE_QUAD
+                                           CalcForceEpSpQuadSimd(),
+#else
+                                           CalcForceEpSpMonoSimd(),
+#endif
+                                           system_soft,
+                                           dinfo);
+#else
+        tree_soft->calcForceAllAndWriteBack(CalcCorrectEpEpWithLinearCutoffNoSimd(),
 #ifdef USE_QUAD
                                            CalcForceEpSpQuadNoSimd(),
 #else
@@ -1139,18 +1335,20 @@ public:
 #endif
                                            system_soft,
                                            dinfo);
+#endif
 
 #ifdef PROFILE
-        n_count.ep_ep_interact     += tree_soft.getNumberOfInteractionEPEPLocal();
-        n_count_sum.ep_ep_interact += tree_soft.getNumberOfInteractionEPEPGlobal();
-        n_count.ep_sp_interact     += tree_soft.getNumberOfInteractionEPSPLocal();
-        n_count_sum.ep_sp_interact += tree_soft.getNumberOfInteractionEPSPGlobal(); 
+        n_count.ep_ep_interact     += tree_soft->getNumberOfInteractionEPEPLocal();
+        addProfileReduction(n_count_sum.ep_ep_interact, tree_soft->getNumberOfInteractionEPEPLocal());
+        n_count.ep_sp_interact     += tree_soft->getNumberOfInteractionEPSPLocal();
+        addProfileReduction(n_count_sum.ep_sp_interact, tree_soft->getNumberOfInteractionEPSPLocal());
 
-        tree_soft_profile += tree_soft.getTimeProfile();
+        tree_soft_profile += tree_soft->getTimeProfile();
+        tree_soft_profile.addLETSend<EPJSoft, SPJForce>(*tree_soft);
         domain_decompose_weight += tree_soft_profile.calc_force;
 
         profile.tree_soft.barrier();
-        PS::Comm::barrier();
+        barrierProfile();
         profile.tree_soft.end();
         profile.force_correct.start();
 #endif 
@@ -1160,12 +1358,12 @@ public:
 
 #ifdef PARTICLE_SIMULATOR_MPI_PARALLEL        
         // Connected clusters
-        system_hard_connected.correctForceWithCutoffTreeNeighborAndClusterOMP<SystemSoft, FPSoft, TreeForce, EPJSoft>(system_soft, tree_soft, search_cluster.getAdrSysConnectClusterSend(), true);
+        system_hard_connected.correctForceWithCutoffTreeNeighborAndClusterOMP<SystemSoft, FPSoft, TreeForce, EPJSoft>(system_soft, *tree_soft, search_cluster.getAdrSysConnectClusterSend(), true);
 #endif
 
 #ifdef PROFILE
         profile.force_correct.barrier();
-        PS::Comm::barrier();
+        barrierProfile();
         profile.force_correct.end();
 #endif
 //        if (true) {
@@ -1188,29 +1386,6 @@ public:
     }
 #endif
 
-    //!leap frog kick for single----------------------------------------------
-    /* modify the velocity of particle in global system
-       reset particle type to single
-       @param[in,out] _sys: particle system
-       @param[in]: _dt: tree step
-       @param[in]; _adr: address for single particles
-    */
-    void kickOne(SystemSoft & _sys, 
-                 const PS::F64 _dt, 
-                 const PS::ReallocatableArray<PS::S32>& _adr) {
-        const PS::S64 n= _adr.size();
-#pragma omp parallel for
-        for(PS::S32 i=0; i<n; i++){
-            const PS::S32 k=_adr[i];
-#ifdef KDKDK_4TH
-            _sys[k].vel  += _dt*(_sys[k].acc + 9.0/192.0*_dt*_dt*_sys[k].acorr); 
-#else
-            _sys[k].vel  += _sys[k].acc * _dt;
-#endif
-            _sys[k].group_data.artificial.setParticleTypeToSingle();
-        }
-    }
-
     //!leap frog kick for clusters
     /*! modify the velocity of particle in local, if particle is from remote note and is not group member, do nothing, need MPI receive to update data
        Recover the mass of members for energy calculation
@@ -1296,32 +1471,6 @@ public:
         }
     }
 
-    //! kick for artifical c.m. particles
-    /*! Kick c.m. velocity (both isolated and connected clusters)
-      @param[in,out] _sys: particle system
-      @param[in] _adr_artificial_start: c.m. particle starting address
-      @param[in] _ap_manager: artificial particle manager
-      @param[in] _dt: tree step
-    */
-    void kickCM(SystemSoft& _sys,
-                const PS::S32 _adr_artificial_start,
-                ArtificialParticleManager& _ap_manager,
-                const PS::F64 _dt) {
-        const PS::S64 n_tot= _sys.getNumberOfParticleLocal();
-        const PS::S32 n_artifical_per_group = _ap_manager.getArtificialParticleN();
-#pragma omp parallel for
-        for(PS::S32 i=_adr_artificial_start; i<n_tot; i+= n_artifical_per_group) {
-            auto* pcm = _ap_manager.getCMParticles(&(_sys[i]));
-            pcm->vel += pcm->acc * _dt;
-#ifdef KDKDK_4TH
-            pcm->vel += _dt*_dt* pcm->acorr /48; 
-#endif
-#ifdef HARD_DEBUG
-            assert(pcm->group_data.artificial.isCM());
-#endif
-        }
-    }
-
     //! drift for single particles
     void driftSingle(SystemSoft & system,
                      const PS::F64 dt){
@@ -1340,24 +1489,27 @@ public:
     }
 
     //! kick
+    /*! @param[in] _dt_kick: kick step
+     */
     void kick(const PS::F64 _dt_kick) {
 #ifdef PROFILE
         profile.kick.start();
 #endif
 
         /// Member mass are recovered
-        // single and reset particle type to single (due to binary disruption)
-        kickOne(system_soft, _dt_kick, search_cluster.getAdrSysOneCluster());
-        // isolated
-        kickClusterAndRecoverGroupMemberMass(system_soft, system_hard_isolated.getPtcl(), _dt_kick);
-        // c.m. artificial
-        kickCM(system_soft, stat.n_real_loc, hard_manager.ap_manager, _dt_kick);
+        // single, isolated, c.m. artificial, connected and sending list in one parallel region
+        assert(Ptcl::group_data_mode == GroupDataMode::artificial);
+#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
+        FusedKick<FPSoft>::kickAll(system_soft, search_cluster.getAdrSysOneCluster(), system_hard_isolated.getPtcl(), 
+                                   &system_hard_connected.getPtcl(), &search_cluster.getAdrSysConnectClusterSend(), 
+                                   stat.n_real_loc, hard_manager.ap_manager, _dt_kick);
+#else
+        FusedKick<FPSoft>::kickAll(system_soft, search_cluster.getAdrSysOneCluster(), system_hard_isolated.getPtcl(), 
+                                   (PS::ReallocatableArray<PtclH4>*)NULL, (const PS::ReallocatableArray<PS::S32>*)NULL,
+                                   stat.n_real_loc, hard_manager.ap_manager, _dt_kick);
+#endif
         
 #ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
-        // connected
-        kickClusterAndRecoverGroupMemberMass(system_soft, system_hard_connected.getPtcl(), _dt_kick);
-        // sending list for connected clusters
-        kickSend(system_soft, search_cluster.getAdrSysConnectClusterSend(), _dt_kick);
         // send kicked particle from sending list, and receive remote single particle
         search_cluster.SendSinglePtcl(system_soft, system_hard_connected.getPtcl());
 #endif
@@ -1402,11 +1554,38 @@ public:
 
 #ifdef PROFILE
         profile.kick.barrier();
-        PS::Comm::barrier();
+        barrierProfile();
         profile.kick.end();
 #endif
     }
 
+#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
+    //! sum interrupt numbers of isolated and connected clusters in one collective
+    /*! n_interrupt_glb is set to the global isolated interrupt number
+      @param[in] _n_isolated: local isolated interrupt number
+      @param[in] _n_connected: local connected interrupt number
+      @param[out] _n_connected_glb: global connected interrupt number
+     */
+    void reduceInterruptNumber(const PS::S32 _n_isolated, const PS::S32 _n_connected, PS::S32& _n_connected_glb) {
+        reduction_step.clear();
+        const PS::S32 i_iso = reduction_step.add(PS::F64(_n_isolated));
+        const PS::S32 i_con = reduction_step.add(PS::F64(_n_connected));
+        reduction_step.reduce();
+        n_interrupt_glb = reduction_step.getSumInt(i_iso);
+        _n_connected_glb = reduction_step.getSumInt(i_con);
+    }
+#endif
+
+    //! finish the non-blocking reduction started in createGroup
+    /*! Update the global particle number including artificial particles
+      \return global number of clusters that need changeover update
+     */
+    PS::S64 finishGroupReduction() {
+        if (!reduction_changeover.isReduced()) return 0;
+        stat.n_all_glb = reduction_changeover.getSumInt(0);
+        return reduction_changeover.getSumInt(1);
+    }
+
     //! hard drift
     /*! \return interrupted cluster total number in all MPI processors
      */
@@ -1430,7 +1609,7 @@ public:
 
 #ifdef PROFILE
         profile.hard_single.barrier();
-        PS::Comm::barrier();
+        barrierProfile();
         profile.hard_single.end();
 #endif
         ////////////////
@@ -1442,9 +1621,17 @@ public:
         // reset slowdown energy correction
         system_hard_isolated.energy.resetEnergyCorrection();
         // integrate multi cluster A
-        system_hard_isolated.driveForMultiClusterOMP(_dt_drift, &(system_soft[0]));
+        // in the shared pool, clusters of B are integrated together with A, the time is counted in hard_isolated
+        PS::S32 n_interrupt_pool[2] = {0, 0};
+        hard_drive_pool.add(system_hard_isolated);
+#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
+        const bool shared_pool_flag = (input_parameters.hard_shared_pool_option.value>0);
+        system_hard_connected.energy.resetEnergyCorrection();
+        if (shared_pool_flag) hard_drive_pool.add(system_hard_connected);
+#endif
+        hard_drive_pool.drive(_dt_drift, &(system_soft[0]), n_interrupt_pool);
         //system_hard_isolated.writeBackPtclForMultiCluster(system_soft, search_cluster.adr_sys_multi_cluster_isolated_,remove_list);
-        PS::S32 n_interrupt_isolated = system_hard_isolated.getNumberOfInterruptClusters();
+        PS::S32 n_interrupt_isolated = n_interrupt_pool[0];
         if(n_interrupt_isolated==0) system_hard_isolated.writeBackPtclForMultiCluster(system_soft, mass_modify_list);
         // integrate multi cluster A
 
@@ -1453,38 +1640,41 @@ public:
         profile.hard_isolated.barrier();
 #endif
 
-#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL        
-        n_interrupt_glb = PS::Comm::getSum(n_interrupt_isolated);
-#else 
+#ifndef PARTICLE_SIMULATOR_MPI_PARALLEL
         n_interrupt_glb = n_interrupt_isolated;
+#ifdef PROFILE
+        n_count_sum.hard_interrupt += n_interrupt_glb;
+#endif
 #endif
 
 #ifdef PROFILE
-        n_count_sum.hard_interrupt += n_interrupt_glb;
         profile.hard_isolated.end();
 #endif
         /////////////
 
-#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL        
+#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
         /////////////
 #ifdef PROFILE
         profile.hard_connected.start();
 #endif
-        // reset slowdown energy correction
-        system_hard_connected.energy.resetEnergyCorrection();
         // integrate multi cluster B
-        system_hard_connected.driveForMultiClusterOMP(_dt_drift, &(system_soft[0]));
-        PS::S32 n_interrupt_connected = system_hard_connected.getNumberOfInterruptClusters();
+        PS::S32 n_interrupt_connected = n_interrupt_pool[1];
+        if (!shared_pool_flag) {
+            hard_drive_pool.add(system_hard_connected);
+            hard_drive_pool.drive(_dt_drift, &(system_soft[0]), &n_interrupt_connected);
+        }
 
 #ifdef PROFILE
         n_count.hard_interrupt += n_interrupt_connected;
         profile.hard_connected.barrier();
 #endif
 
-        PS::S32 n_interrupt_connected_glb = PS::Comm::getSum(n_interrupt_connected);
+        // isolated and connected interrupt numbers are summed in one collective
+        PS::S32 n_interrupt_connected_glb;
+        reduceInterruptNumber(n_interrupt_isolated, n_interrupt_connected, n_interrupt_connected_glb);
 
 #ifdef PROFILE
-        n_count_sum.hard_interrupt += n_interrupt_connected_glb;
+        n_count_sum.hard_interrupt += n_interrupt_glb + n_interrupt_connected_glb;
         profile.hard_connected.end();
         profile.hard_connected.start();
 #endif
@@ -1499,7 +1689,7 @@ public:
         n_interrupt_glb += n_interrupt_connected_glb;
 #ifdef PROFILE
         profile.hard_connected.barrier();
-        PS::Comm::barrier();
+        barrierProfile();
         profile.hard_connected.end();
 #endif
 #endif
@@ -1509,6 +1699,11 @@ public:
 #ifdef GALPY
         galpy_manager.driftMovePot(_dt_drift);
 #endif
+
+#ifdef BSE_BASE
+        // write SSE/BSE events recorded by threads
+        hard_manager.ar_manager.interaction.flushEventLog();
+#endif
         
         if (n_interrupt_glb==0) Ptcl::group_data_mode = GroupDataMode::cm;
         
@@ -1538,14 +1733,14 @@ public:
         profile.hard_isolated.barrier();
 #endif
 
-#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
-        n_interrupt_glb = PS::Comm::getSum(n_interrupt_isolated);
-#else
+#ifndef PARTICLE_SIMULATOR_MPI_PARALLEL
         n_interrupt_glb = n_interrupt_isolated;
+#ifdef PROFILE
+        n_count_sum.hard_interrupt += n_interrupt_glb;
+#endif
 #endif
 
 #ifdef PROFILE
-        n_count_sum.hard_interrupt += n_interrupt_glb;
         profile.hard_isolated.end();
 #endif
 
@@ -1566,10 +1761,11 @@ public:
         profile.hard_connected.barrier();
 #endif
 
-        PS::S32 n_interrupt_connected_glb = PS::Comm::getSum(n_interrupt_connected);
+        PS::S32 n_interrupt_connected_glb;
+        reduceInterruptNumber(n_interrupt_isolated, n_interrupt_connected, n_interrupt_connected_glb);
 
 #ifdef PROFILE
-        n_count_sum.hard_interrupt += n_interrupt_connected_glb;
+        n_count_sum.hard_interrupt += n_interrupt_glb + n_interrupt_connected_glb;
         profile.hard_connected.end();
         profile.hard_connected.start();
 #endif
@@ -1584,7 +1780,7 @@ public:
 
 #ifdef PROFILE
         profile.hard_connected.barrier();
-        PS::Comm::barrier();
+        barrierProfile();
         profile.hard_connected.end();
 #endif
 #endif
@@ -1595,9 +1791,13 @@ public:
         }
 #endif
 
+#ifdef BSE_BASE
+        hard_manager.ar_manager.interaction.flushEventLog();
+#endif
+
 #ifdef PROFILE
         profile.hard_interrupt.barrier();
-        PS::Comm::barrier();
+        barrierProfile();
         profile.hard_interrupt.end();
 #endif
 
@@ -1674,7 +1874,7 @@ public:
 
 #ifdef PROFILE
         profile.output.barrier();
-        PS::Comm::barrier();
+        barrierProfile();
         profile.output.end();
 #endif
     }
@@ -1696,7 +1896,7 @@ public:
 #endif
 #ifdef PROFILE
         profile.search_cluster.barrier();
-        PS::Comm::barrier();
+        barrierProfile();
         profile.search_cluster.end();
 #endif
     }
@@ -1710,22 +1910,64 @@ public:
 #endif
         // correct changeover for first step
         // Isolated clusters
-        system_hard_isolated.correctForceForChangeOverUpdateOMP<SystemSoft, TreeForce, EPJSoft>(system_soft, tree_soft);
+        system_hard_isolated.correctForceForChangeOverUpdateOMP<SystemSoft, TreeForce, EPJSoft>(system_soft, *tree_soft);
 
 #ifdef PARTICLE_SIMULATOR_MPI_PARALLEL        
         // Connected clusters
         auto& adr_send = search_cluster.getAdrSysConnectClusterSend();
-        system_hard_connected.correctForceForChangeOverUpdateOMP<SystemSoft, TreeForce, EPJSoft>(system_soft, tree_soft, adr_send.getPointer(), adr_send.size());
+        system_hard_connected.correctForceForChangeOverUpdateOMP<SystemSoft, TreeForce, EPJSoft>(system_soft, *tree_soft, adr_send.getPointer(), adr_send.size());
 #endif
 
 #ifdef PROFILE
         profile.force_correct.barrier();
-        PS::Comm::barrier();
+        barrierProfile();
         profile.force_correct.end();
 #endif
 
     }
 
+    //! switch the neighbor search and force trees to new leaf and group limits
+    /*! FDPS trees cannot be initialized twice, thus each limit setting has its own trees in tree_set.
+      The trees of the new setting are created if they do not exist, the trees of the kept setting (best tuning candidate) are not deleted,
+      so switching back to it does not allocate again; other trees are deleted, thus at most two settings are stored.
+      Call before the tree steps (between two integration steps), since the tree content is not kept.
+      @param[in] _n_leaf_limit: new leaf number limit
+      @param[in] _n_group_limit: new group number limit
+      @param[in] _n_leaf_keep: leaf number limit of kept trees
+      @param[in] _n_group_keep: group number limit of kept trees
+     */
+    void switchTree(const PS::S64 _n_leaf_limit, const PS::S64 _n_group_limit, const PS::S64 _n_leaf_keep, const PS::S64 _n_group_keep) {
+        input_parameters.n_leaf_limit.value = _n_leaf_limit;
+        input_parameters.n_group_limit.value = _n_group_limit;
+
+        TreeSet* tree_new = NULL;
+        for (auto tree: tree_set) 
+            if (tree->n_leaf_limit==_n_leaf_limit && tree->n_group_limit==_n_group_limit) tree_new = tree;
+        if (tree_new==NULL) {
+            tree_new = new TreeSet();
+            tree_new->n_leaf_limit = _n_leaf_limit;
+            tree_new->n_group_limit = _n_group_limit;
+#ifdef FDPS_COMM
+            tree_new->nb.setCommInfo(comm_info);
+            tree_new->soft.setCommInfo(comm_info);
+#endif
+            tree_new->nb.initialize(input_parameters.n_glb.value, input_parameters.theta.value, _n_leaf_limit, _n_group_limit);
+            PS::S64 n_tree_init = input_parameters.n_glb.value + input_parameters.n_bin.value;
+            tree_new->soft.initialize(n_tree_init, input_parameters.theta.value, _n_leaf_limit, _n_group_limit);
+            tree_set.push_back(tree_new);
+        }
+        tree_nb = &tree_new->nb;
+        tree_soft = &tree_new->soft;
+
+        // delete unused trees
+        std::size_t n_keep = 0;
+        for (auto tree: tree_set) {
+            if (tree==tree_new || (tree->n_leaf_limit==_n_leaf_keep && tree->n_group_limit==_n_group_keep)) tree_set[n_keep++] = tree;
+            else delete tree;
+        }
+        tree_set.resize(n_keep);
+    }
+
     //! domain decomposition
     /*!
       @param[in] _enforce: do domain decompose without check n_loop (false)
@@ -1742,7 +1984,7 @@ public:
         }
 #ifdef PROFILE
         profile.domain.barrier();
-        PS::Comm::barrier();
+        barrierProfile();
         profile.domain.end();
 #endif
     }
@@ -1813,36 +2055,43 @@ public:
 #else
             stat.energy.calc(&system_soft[0], stat.n_real_loc);
 #endif
-#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
-            stat.energy.getSumMultiNodes();
-#endif
-
+            // soft and hard energies are summed in one collective
+            reduction_step.clear();
+            const PS::S32 i_energy = stat.energy.addToReduction(reduction_step);
 #ifdef HARD_CHECK_ENERGY
             HardEnergy energy_local = system_hard_one_cluster.energy;
             energy_local += system_hard_isolated.energy;
 #ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
             energy_local += system_hard_connected.energy;
 #endif
+            const PS::S32 i_hard_energy = energy_local.addToReduction(reduction_step);
+#endif
+            reduction_step.reduce();
+            stat.energy.setSumFromReduction(reduction_step, i_energy);
+
+#ifdef HARD_CHECK_ENERGY
+            HardEnergy energy_glb;
+            energy_glb.setSumFromReduction(reduction_step, i_hard_energy);
             // hard energy error
-            stat.energy.error_hard_cum += PS::Comm::getSum(energy_local.de);
-            stat.energy.error_hard_sd_cum += PS::Comm::getSum(energy_local.de_sd);
+            stat.energy.error_hard_cum += energy_glb.de;
+            stat.energy.error_hard_sd_cum += energy_glb.de_sd;
             // energy correction due to slowdown 
-            PS::F64 ekin_sd_correction = PS::Comm::getSum(energy_local.ekin_sd_correction);
+            PS::F64 ekin_sd_correction = energy_glb.ekin_sd_correction;
             stat.energy.ekin_sd = stat.energy.ekin + ekin_sd_correction;
-            PS::F64 epot_sd_correction = PS::Comm::getSum(energy_local.epot_sd_correction);
+            PS::F64 epot_sd_correction = energy_glb.epot_sd_correction;
             stat.energy.epot_sd = stat.energy.epot + epot_sd_correction;
             PS::F64 etot_sd_correction = ekin_sd_correction + epot_sd_correction;
-            PS::F64 de_change_cum = PS::Comm::getSum(energy_local.de_change_cum);
-            PS::F64 de_change_binary_interrupt = PS::Comm::getSum(energy_local.de_change_binary_interrupt);
-            PS::F64 de_change_modify_single = PS::Comm::getSum(energy_local.de_change_modify_single);
+            PS::F64 de_change_cum = energy_glb.de_change_cum;
+            PS::F64 de_change_binary_interrupt = energy_glb.de_change_binary_interrupt;
+            PS::F64 de_change_modify_single = energy_glb.de_change_modify_single;
             stat.energy.etot_ref += de_change_cum;
             stat.energy.de_change_cum += de_change_cum;
             stat.energy.de_change_binary_interrupt += de_change_binary_interrupt;
             stat.energy.de_change_modify_single += de_change_modify_single;
             // for total energy reference, first add the cumulative change due to slowdown change in the integration (referring to no slowdown case), then add slowdown energy correction from current time
-            PS::F64 de_sd_change_cum  = PS::Comm::getSum(energy_local.de_sd_change_cum) + etot_sd_correction;
-            PS::F64 de_sd_change_binary_interrupt = PS::Comm::getSum(energy_local.de_sd_change_binary_interrupt);
-            PS::F64 de_sd_change_modify_single = PS::Comm::getSum(energy_local.de_sd_change_modify_single);
+            PS::F64 de_sd_change_cum  = energy_glb.de_sd_change_cum + etot_sd_correction;
+            PS::F64 de_sd_change_binary_interrupt = energy_glb.de_sd_change_binary_interrupt;
+            PS::F64 de_sd_change_modify_single = energy_glb.de_sd_change_modify_single;
             stat.energy.etot_sd_ref += de_sd_change_cum; 
             stat.energy.de_sd_change_cum += de_sd_change_cum;
             stat.energy.de_sd_change_binary_interrupt += de_sd_change_binary_interrupt;
@@ -1863,7 +2112,7 @@ public:
 
 #ifdef PROFILE
         profile.status.barrier();
-        PS::Comm::barrier();
+        barrierProfile();
         profile.status.end();
 #endif
     }
@@ -1873,6 +2122,8 @@ public:
 #ifdef PROFILE
         profile.output.start();
 #endif
+        // make sure the global particle number is updated
+        finishGroupReduction();
         bool print_flag = input_parameters.print_flag;
         int write_style = input_parameters.write_style.value;
         std::cout<<std::setprecision(PRINT_PRECISION);
@@ -1941,14 +2192,28 @@ public:
         // save current error
         stat.energy.saveEnergyError();
 
+        // dump the slowest hard clusters in this output interval
+        if (hard_dump_slow.isActive()) hard_dump_slow.dumpSlowest(file_header.nfile, stat.time);
+
 #ifdef PROFILE
         profile.output.barrier();
-        PS::Comm::barrier();
+        barrierProfile();
         profile.output.end();
 #endif
     }
 
 #ifdef PROFILE
+    //! MPI barrier to separate the time profiles of components
+    /*! The barrier is counted as a collective in the profile. 
+        If PROFILE_NO_BARRIER is defined, the barrier is skipped and the waiting time due to load imbalance is included in the next component.
+     */
+    void barrierProfile() {
+#ifndef PROFILE_NO_BARRIER
+        PS::Comm::barrier();
+        GlobalReduction::countCollective();
+#endif
+    }
+
     //! measure profiles
     void calcProfile() {
         
@@ -1960,8 +2225,8 @@ public:
         n_count.hard_single      += n_hard_single;
         n_count.hard_isolated    += n_hard_isolated;
 
-        n_count_sum.hard_single      += PS::Comm::getSum(n_hard_single);
-        n_count_sum.hard_isolated    += PS::Comm::getSum(n_hard_isolated);
+        addProfileReduction(n_count_sum.hard_single,   n_hard_single);
+        addProfileReduction(n_count_sum.hard_isolated, n_hard_isolated);
 
         PS::S64 ARC_substep_sum   = system_hard_isolated.ARC_substep_sum;
         PS::S64 ARC_tsyn_step_sum   = system_hard_isolated.ARC_tsyn_step_sum;
@@ -1975,7 +2240,7 @@ public:
 #ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
         PS::S32 n_hard_connected  = system_hard_connected.getPtcl().size();
         n_count.hard_connected   += n_hard_connected;
-        n_count_sum.hard_connected += PS::Comm::getSum(n_hard_connected);
+        addProfileReduction(n_count_sum.hard_connected, n_hard_connected);
 
         ARC_substep_sum += system_hard_connected.ARC_substep_sum;
         ARC_tsyn_step_sum += system_hard_connected.ARC_tsyn_step_sum;
@@ -1996,13 +2261,13 @@ public:
         n_count.n_neighbor_zero  += n_neighbor_zero;
 #endif
 
-        n_count_sum.ARC_substep_sum  += PS::Comm::getSum(ARC_substep_sum);
-        n_count_sum.ARC_tsyn_step_sum+= PS::Comm::getSum(ARC_tsyn_step_sum);
-        n_count_sum.ARC_n_groups     += PS::Comm::getSum(ARC_n_groups);
-        n_count_sum.ARC_n_groups_iso     += PS::Comm::getSum(ARC_n_groups_iso);
-        n_count_sum.H4_step_sum      += PS::Comm::getSum(H4_step_sum);
+        addProfileReduction(n_count_sum.ARC_substep_sum,   ARC_substep_sum);
+        addProfileReduction(n_count_sum.ARC_tsyn_step_sum, ARC_tsyn_step_sum);
+        addProfileReduction(n_count_sum.ARC_n_groups,      ARC_n_groups);
+        addProfileReduction(n_count_sum.ARC_n_groups_iso,  ARC_n_groups_iso);
+        addProfileReduction(n_count_sum.H4_step_sum,       H4_step_sum);
 #ifdef HARD_COUNT_NO_NEIGHBOR
-        n_count_sum.n_neighbor_zero  += PS::Comm::getSum(n_neighbor_zero);
+        addProfileReduction(n_count_sum.n_neighbor_zero,   n_neighbor_zero);
 #endif
 
         system_hard_isolated.ARC_substep_sum = 0;
@@ -2030,7 +2295,7 @@ public:
 
         const PS::S32  n_isolated_cluster = system_hard_isolated.getNumberOfClusters();
         n_count.cluster_isolated += n_isolated_cluster;
-        n_count_sum.cluster_isolated += PS::Comm::getSum(n_isolated_cluster);
+        addProfileReduction(n_count_sum.cluster_isolated, n_isolated_cluster);
 
         const PS::S32* isolated_cluster_n_list = system_hard_isolated.getClusterNumberOfMemberList();
         for (PS::S32 i=0; i<n_isolated_cluster; i++) n_count.clusterCount(isolated_cluster_n_list[i]);
@@ -2038,7 +2303,7 @@ public:
 #ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
         const PS::S32  n_connected_cluster = system_hard_connected.getNumberOfClusters();
         n_count.cluster_connected += n_connected_cluster;
-        n_count_sum.cluster_connected += PS::Comm::getSum(n_connected_cluster);
+        addProfileReduction(n_count_sum.cluster_connected, n_connected_cluster);
         const PS::S32* connected_cluster_n_list = system_hard_connected.getClusterNumberOfMemberList();
         for (PS::S32 i=0; i<n_connected_cluster; i++) n_count.clusterCount(connected_cluster_n_list[i]);
 #endif
@@ -2062,6 +2327,7 @@ public:
                              n_member_in_cluster_recv, cluster_hist_size_recv, cluster_hist_size_disp);
         PS::Comm::allGatherV(n_cluster_loc, cluster_hist_size_loc, 
                              n_cluster_recv, cluster_hist_size_recv, cluster_hist_size_disp);
+        GlobalReduction::countCollective(3);
         for (PS::S32 i=0; i<cluster_hist_size_total; i++) {
             n_count_sum.clusterCount(n_member_in_cluster_recv[i], n_cluster_recv[i]);
         }
@@ -2069,12 +2335,43 @@ public:
         n_count_sum.addClusterCount(n_count);
 #endif
 
+        // global summation of counts overlaps with the following steps
+        reduction_profile.startReduce();
+
+        // number of collectives issued in this step
+        const PS::S64 n_collective = GlobalReduction::getCollectiveCount();
+        n_count.collective += n_collective;
+        n_count_sum.collective += n_collective;
+        GlobalReduction::resetCollectiveCount();
+
         dn_loop++;
 
     }
 
+    //! add a local count for the non-blocking global summation of profile counts
+    /*! The summation is added to _counter_sum when the reduction is finished
+      @param[in] _counter_sum: global counter to accumulate the summation
+      @param[in] _n_loc: local count
+     */
+    void addProfileReduction(NumCounter& _counter_sum, const PS::S64 _n_loc) {
+        if (reduction_profile.isReduced()) finishProfileReduction();
+        reduction_profile.add(PS::F64(_n_loc));
+        reduction_profile_counter.push_back(&_counter_sum);
+    }
+
+    //! finish the non-blocking global summation of profile counts and accumulate the results
+    void finishProfileReduction() {
+        if (reduction_profile.isReduced()) {
+            for (PS::S32 i=0; i<reduction_profile_counter.size(); i++) 
+                *reduction_profile_counter[i] += reduction_profile.getSumInt(i);
+            reduction_profile.clear();
+            reduction_profile_counter.resizeNoInitialize(0);
+        }
+    }
+
     //! clear profile
     void clearProfile() {
+        finishProfileReduction();
         profile.clear();
         tree_soft_profile.clear();
         tree_nb_profile.clear();
@@ -2084,11 +2381,20 @@ public:
 #endif
         n_count.clear();
         n_count_sum.clear();
+        hard_drive_pool.clearProfile();
+        tree_tuner.clearTimeReference();
+#ifdef HARD_GROUP_RECORD
+        system_hard_isolated.getGroupRecord().clearProfile();
+#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
+        system_hard_connected.getGroupRecord().clearProfile();
+#endif
+#endif
         dn_loop=0;
     }
 
     //! output profile data
     void printProfile() {
+        finishProfileReduction();
 
         const SysProfile& profile_min = profile.getMin();
         
@@ -2108,12 +2414,46 @@ public:
             profile.dump(std::cout,dn_loop);
             std::cout<<std::endl;
 
+            if (perf_counter.isActive()) {
+                std::cout<<"**** Hardware counters per step (local, sum of threads):\n";
+                profile.dumpPerfCounter(std::cout,dn_loop);
+            }
+
+            std::cout<<"**** Hard cluster integration per step (local, sum of threads):\n";
+            std::cout<<std::setw(PROFILE_PRINT_WIDTH)<<"Busy"<<std::setw(PROFILE_PRINT_WIDTH)<<"Idle"<<std::setw(PROFILE_PRINT_WIDTH)<<"Cluster_N"<<std::endl;
+            std::cout<<std::setw(PROFILE_PRINT_WIDTH)<<hard_drive_pool.getBusyTime()/dn_loop
+                     <<std::setw(PROFILE_PRINT_WIDTH)<<hard_drive_pool.getIdleTime()/dn_loop
+                     <<std::setw(PROFILE_PRINT_WIDTH)<<(PS::F64)hard_drive_pool.getNumberOfTask()/dn_loop<<std::endl;
+
+
+#ifdef HARD_GROUP_RECORD
+            {
+                PS::S64 n_record_hit = system_hard_isolated.getGroupRecord().getHitN();
+                PS::S64 n_record_miss = system_hard_isolated.getGroupRecord().getMissN();
+#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
+                n_record_hit += system_hard_connected.getGroupRecord().getHitN();
+                n_record_miss += system_hard_connected.getGroupRecord().getMissN();
+#endif
+                std::cout<<"**** Group records per step (local):\n";
+                std::cout<<std::setw(PROFILE_PRINT_WIDTH)<<"Reused_N"<<std::setw(PROFILE_PRINT_WIDTH)<<"Rebuilt_N"<<std::setw(PROFILE_PRINT_WIDTH)<<"Hit_rate"<<std::endl;
+                std::cout<<std::setw(PROFILE_PRINT_WIDTH)<<(PS::F64)n_record_hit/dn_loop
+                         <<std::setw(PROFILE_PRINT_WIDTH)<<(PS::F64)n_record_miss/dn_loop
+                         <<std::setw(PROFILE_PRINT_WIDTH)<<(PS::F64)n_record_hit/std::max(n_record_hit+n_record_miss, PS::S64(1))<<std::endl;
+            }
+#endif
+
             std::cout<<"**** FDPS tree soft force time profile (local):\n";
             tree_soft_profile.dumpName(std::cout);
             std::cout<<std::endl;
             tree_soft_profile.dump(std::cout,dn_loop);
             std::cout<<std::endl;
 
+            std::cout<<"**** FDPS tree soft force LET sending per step (local):\n";
+            tree_soft_profile.dumpLETName(std::cout);
+            std::cout<<std::endl;
+            tree_soft_profile.dumpLET(std::cout,dn_loop);
+            std::cout<<std::endl;
+
             std::cout<<"**** Tree neighbor time profile (local):\n";
             tree_nb_profile.dumpName(std::cout);
             std::cout<<std::endl;
@@ -2180,7 +2520,10 @@ public:
 
 #ifdef STELLAR_EVOLUTION
     //! Correct potential energy due to modificaiton of particle mass
-    void correctSoftPotMassChange() {
+    /*! The global summation is merged into the reduction in removeParticles
+      \return local potential energy change
+     */
+    PS::F64 correctSoftPotMassChange() {
         // correct soft potential energy due to mass change
 		PS::F64 depot_sum = 0;
 #pragma omp parallel for reduction(+:depot_sum)
@@ -2194,16 +2537,8 @@ public:
             //    remove_list.push_back(i);
             //}
         }
-#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL        
-		PS::F64 global_depot_sum = PS::Comm::getSum(depot_sum);
-#else
-        PS::F64 global_depot_sum = depot_sum;
-#endif
-		stat.energy.etot_ref += global_depot_sum;
-		stat.energy.de_change_cum += global_depot_sum;
-		stat.energy.etot_sd_ref += global_depot_sum;
-		stat.energy.de_sd_change_cum += global_depot_sum;
         mass_modify_list.resizeNoInitialize(0);
+        return depot_sum;
     }
 #endif
 
@@ -2218,8 +2553,29 @@ public:
         }
     }
 
+    //! correct energies and references due to external modifications of particle velocities and masses without a new initial step
+    /*! Used by the AMUSE interface when particles are kicked (e.g. by bridge) or the mass of one particle is changed between evolve calls; collective
+      @param[in] _dekin_loc: local kinetic energy change of modified particles
+      @param[in] _depot_loc: local potential energy change of modified particles
+     */
+    void correctEnergyExternalModification(const PS::F64 _dekin_loc, const PS::F64 _depot_loc) {
+        PS::F64vec de_glb = PS::Comm::getSum(PS::F64vec(_dekin_loc, _depot_loc, 0.0));
+        PS::F64 de_sum = de_glb.x + de_glb.y;
+        stat.energy.ekin += de_glb.x;
+        stat.energy.epot += de_glb.y;
+        stat.energy.etot_ref += de_sum;
+        stat.energy.de_change_cum += de_sum;
+        stat.energy.ekin_sd += de_glb.x;
+        stat.energy.epot_sd += de_glb.y;
+        stat.energy.etot_sd_ref += de_sum;
+        stat.energy.de_sd_change_cum += de_sum;
+    }
+
     //! remove artificial and unused particles
-    void removeParticles() {
+    /*! The escaper and removed numbers, the particle number and the potential energy change due to mass modification are summed in one collective
+      @param[in] _depot_sum_loc: local potential energy change due to mass modification from correctSoftPotMassChange
+     */
+    void removeParticles(const PS::F64 _depot_sum_loc=0.0) {
         /////////////
         assert(n_interrupt_glb==0);
 #ifdef PROFILE
@@ -2296,15 +2652,28 @@ public:
         n_remove = remove_list.size();
         system_soft.removeParticle(remove_list.getPointer(), remove_list.size());
 
-        stat.n_escape_glb += PS::Comm::getSum(n_esc);
-        stat.n_remove_glb += PS::Comm::getSum(n_remove);
-
         // reset particle number
         stat.n_real_loc = stat.n_real_loc-remove_list.size();
         system_soft.setNumberOfParticleLocal(stat.n_real_loc);
-        stat.n_real_glb = system_soft.getNumberOfParticleGlobal();
         remove_list.resizeNoInitialize(0);
 
+        reduction_step.clear();
+        const PS::S32 i_esc    = reduction_step.add(PS::F64(n_esc));
+        const PS::S32 i_remove = reduction_step.add(PS::F64(n_remove));
+        const PS::S32 i_real   = reduction_step.add(PS::F64(stat.n_real_loc));
+        const PS::S32 i_depot  = reduction_step.add(_depot_sum_loc);
+        reduction_step.reduce();
+
+        stat.n_escape_glb += reduction_step.getSumInt(i_esc);
+        stat.n_remove_glb += reduction_step.getSumInt(i_remove);
+        stat.n_real_glb = reduction_step.getSumInt(i_real);
+
+        PS::F64 depot_sum_glb = reduction_step.getSum(i_depot);
+        stat.energy.etot_ref += depot_sum_glb;
+        stat.energy.de_change_cum += depot_sum_glb;
+        stat.energy.etot_sd_ref += depot_sum_glb;
+        stat.energy.de_sd_change_cum += depot_sum_glb;
+
 #ifdef PETAR_DEBUG
 #pragma omp parallel for
         for(PS::S32 i=0; i<stat.n_real_loc; i++){
@@ -2318,7 +2687,7 @@ public:
 
 #ifdef PROFILE
         profile.other.barrier();
-        PS::Comm::barrier();
+        barrierProfile();
         profile.other.end();
 #endif
     }
@@ -2370,7 +2739,7 @@ public:
         
 #ifdef PROFILE
         profile.exchange.barrier();
-        PS::Comm::barrier();
+        barrierProfile();
         profile.exchange.end();
 #endif
     }
@@ -2404,8 +2773,8 @@ public:
         comm_info.create(n,rank);
         system_soft.setCommInfo(comm_info);
         dinfo.setCommInfo(comm_info);
-        tree_nb.setCommInfo(comm_info);
-        tree_soft.setCommInfo(comm_info);
+        tree_nb->setCommInfo(comm_info);
+        tree_soft->setCommInfo(comm_info);
         my_rank = comm_info.getRank();
         n_proc = comm_info.getNumberOfProc();
     }
@@ -2421,8 +2790,8 @@ public:
         comm_info = _comm_info;
         system_soft.setCommInfo(comm_info);
         dinfo.setCommInfo(comm_info);
-        tree_nb.setCommInfo(comm_info);
-        tree_soft.setCommInfo(comm_info);
+        tree_nb->setCommInfo(comm_info);
+        tree_soft->setCommInfo(comm_info);
         my_rank = comm_info.getRank();
         n_proc = comm_info.getNumberOfProc();
     }
@@ -2523,6 +2892,10 @@ public:
 #endif
 #endif
 
+#ifdef SOFT_MIXED_PRECISION
+        fout<<"Use single precision soft force relative to the local center\n";
+#endif
+
 #ifdef USE_FUGAKU
         fout<<"Use Fugaku\n";
 #endif
@@ -2609,8 +2982,8 @@ public:
         // help case, return directly
         if (read_flag==-1) {
             // avoid segmentation fault due to FDPS clear function bug
-            tree_nb.initialize(input_parameters.n_glb.value, input_parameters.theta.value, input_parameters.n_leaf_limit.value, input_parameters.n_group_limit.value);
-            tree_soft.initialize(input_parameters.n_glb.value, input_parameters.theta.value, input_parameters.n_leaf_limit.value, input_parameters.n_group_limit.value);
+            tree_nb->initialize(input_parameters.n_glb.value, input_parameters.theta.value, input_parameters.n_leaf_limit.value, input_parameters.n_group_limit.value);
+            tree_soft->initialize(input_parameters.n_glb.value, input_parameters.theta.value, input_parameters.n_leaf_limit.value, input_parameters.n_group_limit.value);
 
             return read_flag;
         }
@@ -2698,6 +3071,12 @@ public:
             }
             hard_manager.ar_manager.interaction.fout_sse<<std::setprecision(WRITE_PRECISION);
             hard_manager.ar_manager.interaction.fout_bse<<std::setprecision(WRITE_PRECISION);
+            // binary event records written by threads, convert to text by petar.se.event.convert
+            std::string fsse_bin_name = fname_snp + fsse_par_suffix + ".bin." + my_rank_str;
+            std::string fbse_bin_name = fname_snp + fbse_par_suffix + ".bin." + my_rank_str;
+            const PS::S32 n_thread = PS::Comm::getNumberOfThread();
+            hard_manager.ar_manager.interaction.sse_event.open(fsse_bin_name, input_parameters.append_switcher.value==1, n_thread, WRITE_WIDTH, WRITE_PRECISION);
+            hard_manager.ar_manager.interaction.bse_event.open(fbse_bin_name, input_parameters.append_switcher.value==1, n_thread, WRITE_WIDTH, WRITE_PRECISION);
 #endif 
 
 #ifdef ADJUST_GROUP_PRINT
@@ -2713,6 +3092,28 @@ public:
 #endif
         }
 
+        // slow hard cluster capture
+        if (input_parameters.hard_dump_slow_n.value>0||input_parameters.hard_dump_slow_time.value>0.0) {
+            hard_dump_slow.initial(PS::Comm::getNumberOfThread(), input_parameters.hard_dump_slow_n.value, input_parameters.hard_dump_slow_time.value,
+                                   fname_snp + ".hard_slow", my_rank, input_parameters.append_switcher.value==1);
+            if (print_flag) std::cout<<"Slow hard clusters are dumped to "<<fname_snp<<".hard_slow.* and listed in "<<fname_snp<<".hard_slow_list."<<my_rank<<", replay them with petar.hard.debug -m 2 -p "<<input_parameters.fname_par.value<<".hard [dump files]"<<std::endl;
+        }
+
+        // timeline trace
+        if (input_parameters.trace_buffer_size.value>0) {
+            trace_log.initial(fname_snp, PS::Comm::getNumberOfThread(), input_parameters.trace_buffer_size.value, my_rank, input_parameters.append_switcher.value==1);
+            if (print_flag) std::cout<<"Timeline trace is written to "<<fname_snp<<".trace.*, merge them with petar.trace.merge"<<std::endl;
+        }
+
+        // hardware performance counters
+        if (input_parameters.perf_counter_option.value>0) {
+            PS::S32 n_avail = perf_counter.initial(input_parameters.perf_fp_event.value);
+            if (print_flag) {
+                if (n_avail==0) std::cerr<<"Warning: no hardware performance counter can be opened, check /proc/sys/kernel/perf_event_paranoid"<<std::endl;
+                else std::cout<<"Hardware performance counters available: "<<n_avail<<" of "<<PERF_COUNTER_N<<std::endl;
+            }
+        }
+
 #ifdef HARD_DUMP
         // initial hard_dump 
         const PS::S32 num_thread = PS::Comm::getNumberOfThread();
@@ -2734,14 +3135,20 @@ public:
         }
 
         // tree for neighbor search
-        tree_nb.initialize(input_parameters.n_glb.value, input_parameters.theta.value, input_parameters.n_leaf_limit.value, input_parameters.n_group_limit.value);
+        tree_set[0]->n_leaf_limit = input_parameters.n_leaf_limit.value;
+        tree_set[0]->n_group_limit = input_parameters.n_group_limit.value;
+        tree_nb->initialize(input_parameters.n_glb.value, input_parameters.theta.value, input_parameters.n_leaf_limit.value, input_parameters.n_group_limit.value);
 
         // tree for force
         PS::S64 n_tree_init = input_parameters.n_glb.value + input_parameters.n_bin.value;
-        tree_soft.initialize(n_tree_init, input_parameters.theta.value, input_parameters.n_leaf_limit.value, input_parameters.n_group_limit.value);
+        tree_soft->initialize(n_tree_init, input_parameters.theta.value, input_parameters.n_leaf_limit.value, input_parameters.n_group_limit.value);
 
-        // initial search cluster
+        // initial search cluster, the cluster exchanges use the communicator of the particle system
+#if defined(PARTICLE_SIMULATOR_MPI_PARALLEL) && defined(FDPS_COMM)
+        search_cluster.initialize(comm_info.getCommunicator());
+#else
         search_cluster.initialize();
+#endif
 
         return read_flag;
     }
@@ -2920,12 +3327,21 @@ public:
     }
 
     //! generate data from plummer model
-    void generatePlummer() {
+    /*! Optionally, a fraction of stars are paired into primordial binaries with the IDs 1,2*n_bin (input parameter n_bin is updated).
+        Each binary replaces the centers of mass of two neighboring particles in the list by the c.m. of the first one,
+        with a log-uniform semi-major axis distribution and a thermal eccentricity distribution.
+      @param[in] _fbin: fraction of stars in binaries
+      @param[in] _semi_min: minimum semi-major axis of binaries (Henon unit)
+      @param[in] _semi_max: maximum semi-major axis of binaries (Henon unit)
+      @param[in] _seed: random seed, the generator of each MPI rank uses my_rank+_seed*n_proc
+     */
+    void generatePlummer(const PS::F64 _fbin=0.0, const PS::F64 _semi_min=1e-5, const PS::F64 _semi_max=1e-3, const PS::S32 _seed=0) {
         // ensure parameters are used
         assert(read_parameters_flag);
 
         PS::S64 n_glb = input_parameters.n_glb.value;
         assert(n_glb>0);
+        assert(_fbin>=0.0&&_fbin<=1.0);
 
         PS::S64 n_loc = n_glb / n_proc; 
         if( n_glb % n_proc > my_rank) n_loc++;
@@ -2938,11 +3354,44 @@ public:
         const PS::F64 m_tot = 1.0;
         const PS::F64 eng = -0.25;
 
-        ParticleDistributionGenerator::makePlummerModel(m_tot, n_glb, n_loc, mass, pos, vel, eng);
+        ParticleDistributionGenerator::makePlummerModel(m_tot, n_glb, n_loc, mass, pos, vel, eng, _seed);
 
         PS::S64 i_h = n_glb/n_proc*my_rank;
         if( n_glb % n_proc  > my_rank) i_h += my_rank;
         else i_h += n_glb % n_proc;
+
+        // primordial binaries
+        if (_fbin>0.0) {
+            const PS::S64 n_bin = PS::S64(0.5*_fbin*n_glb);
+            input_parameters.n_bin.value = n_bin;
+            assert(_semi_min>0.0&&_semi_max>=_semi_min);
+            PS::MTTS mt;
+            mt.init_genrand(my_rank+(_seed+1)*n_proc);
+            const PS::F64 pi = 4.0*atan(1.0);
+            const PS::F64 log_semi_min = std::log(_semi_min);
+            const PS::F64 log_semi_max = std::log(_semi_max);
+            // start from odd ID, a pair split by MPI ranks stays single
+            for (PS::S64 i=(i_h%2==0)?0:1; i+1<n_loc && i_h+i+2<=2*n_bin; i+=2) {
+                COMM::Binary bin;
+                bin.semi = std::exp(log_semi_min + (log_semi_max-log_semi_min)*mt.genrand_res53());
+                bin.ecc = std::sqrt(mt.genrand_res53());
+                bin.incline = std::acos(1.0 - 2.0*mt.genrand_res53());
+                bin.rot_horizon = 2.0*pi*mt.genrand_res53();
+                bin.rot_self    = 2.0*pi*mt.genrand_res53();
+                bin.ecca = bin.calcEccAnomaly(2.0*pi*mt.genrand_res53(), bin.ecc);
+                bin.m1 = mass[i];
+                bin.m2 = mass[i+1];
+                ParticleBase p1, p2;
+                bin.calcParticles(p1, p2, input_parameters.gravitational_constant.value);
+                const PS::F64vec pos_cm = pos[i];
+                const PS::F64vec vel_cm = vel[i];
+                pos[i]   = pos_cm + p1.pos;
+                vel[i]   = vel_cm + p1.vel;
+                pos[i+1] = pos_cm + p2.pos;
+                vel[i+1] = vel_cm + p2.vel;
+            }
+        }
+
         for(PS::S32 i=0; i<n_loc; i++){
             system_soft[i].mass = mass[i];
             system_soft[i].pos = pos[i];
@@ -3392,6 +3841,7 @@ public:
                 auto& pi = system_soft[i];
                 hard_manager.ar_manager.interaction.modifyOneParticle(pi, stat.time, stat.time);
             }
+            hard_manager.ar_manager.interaction.flushEventLog();
         }
 #endif
 #endif
@@ -3414,11 +3864,17 @@ public:
         system_hard_isolated.allocateHardIntegrator(input_parameters.n_interrupt_limit.value);
         system_hard_isolated.manager = &hard_manager;
         system_hard_isolated.setTimeOrigin(stat.time);
+#ifdef HARD_GROUP_RECORD
+        system_hard_isolated.getGroupRecord().tolerance = input_parameters.group_record_tol.value;
+#endif
 
 #ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
         system_hard_connected.allocateHardIntegrator(input_parameters.n_interrupt_limit.value);
         system_hard_connected.manager = &hard_manager;
         system_hard_connected.setTimeOrigin(stat.time);
+#ifdef HARD_GROUP_RECORD
+        system_hard_connected.getGroupRecord().tolerance = input_parameters.group_record_tol.value;
+#endif
 #endif
 
         time_kick = stat.time;
@@ -3580,6 +4036,7 @@ public:
 
 #ifdef PROFILE
         clearProfile();
+        tree_tuner.initialize(input_parameters.tree_tune_option.value, input_parameters.tree_tune_n_step.value, input_parameters.n_leaf_limit.value, input_parameters.n_group_limit.value);
 #endif
         initial_step_flag = true;
     }
@@ -3664,15 +4121,16 @@ public:
 #ifdef PROFILE
                     // profile
                     profile.total.barrier();
-                    PS::Comm::barrier();
+                    barrierProfile();
                     profile.total.end();
 
                     printProfile();
                     clearProfile();
 
-                    PS::Comm::barrier();
+                    barrierProfile();
                     profile.total.start();
 #endif
+                    trace_log.flush();
                 }
 
                 // interrupt
@@ -3680,7 +4138,7 @@ public:
                     assert(checkTimeConsistence());
 #ifdef PROFILE
                     profile.total.barrier();
-                    PS::Comm::barrier();
+                    barrierProfile();
                     profile.total.end();
 #endif
                     return 0;
@@ -3726,6 +4184,9 @@ public:
                     stat.energy.etot_ref += de_kin;
                     stat.energy.etot_sd_ref += de_kin;
                 }
+#ifdef BSE_BASE
+                hard_manager.ar_manager.interaction.flushEventLog();
+#endif
                 // shift time interrupt in order to get consistent time for stellar evolution in the next drift
                 //p.time_record    -= dt;
                 //p.time_interrupt -= dt;
@@ -3734,7 +4195,7 @@ public:
 
 #ifdef PROFILE
                 profile.total.barrier();
-                PS::Comm::barrier();
+                barrierProfile();
                 profile.total.end();
 
                 calcProfile();
@@ -3783,19 +4244,27 @@ public:
             profile.total.start();
 #endif
 
+            PS::F64 depot_sum_loc = 0.0;
 #ifdef STELLAR_EVOLUTION
             // correct soft potential energy due to mass change
-            correctSoftPotMassChange();
+            depot_sum_loc = correctSoftPotMassChange();
 #endif
 
             // remove artificial and ununsed particles in system_soft.
-            removeParticles();
+            removeParticles(depot_sum_loc);
 
 #ifdef RECORD_CM_IN_HEADER
             // update center
             stat.calcAndShiftCenterOfMass(&system_soft[0], stat.n_real_loc);
 #endif
 
+#ifdef PROFILE
+            // online tuning of tree parameters from the tree time of previous steps
+            if (tree_tuner.update(profile.tree_soft.time + profile.tree_nb.time, input_parameters.print_flag, stat.time))
+                switchTree(tree_tuner.getNumberOfLeafLimit(), tree_tuner.getNumberOfGroupLimit(), 
+                           tree_tuner.getNumberOfLeafLimitBest(), tree_tuner.getNumberOfGroupLimitBest());
+#endif
+
             // >9. Domain decomposition
             domainDecompose();
 
@@ -3870,14 +4339,8 @@ public:
                     // output step, get last kick step
                     output_flag = (fmod(stat.time, dt_output) == 0.0);
 
-                    // check changeover change
-                    changeover_flag = (system_hard_isolated.getNClusterChangeOverUpdate()>0);
-
-#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL        
-                    PS::S32 n_changeover_modify_local  = system_hard_connected.getNClusterChangeOverUpdate() + system_hard_isolated.getNClusterChangeOverUpdate();
-                    PS::S32 n_changeover_modify_global = PS::Comm::getSum(n_changeover_modify_local);
-                    if (n_changeover_modify_global>0) changeover_flag = true;
-#endif
+                    // check changeover change, global number is reduced in createGroup
+                    changeover_flag = (finishGroupReduction()>0);
 
                     // check interruption
                     interrupt_flag = (stat.time>=time_break);
@@ -3889,7 +4352,7 @@ public:
                 else dt_kick = dt_manager.getDtKickContinue();
 #ifdef PROFILE
                 profile.other.barrier();
-                PS::Comm::barrier();
+                barrierProfile();
                 profile.other.end();
 #endif
             }
@@ -3913,15 +4376,16 @@ public:
 #ifdef PROFILE
                 // profile
                 profile.total.barrier();
-                PS::Comm::barrier();
+                barrierProfile();
                 profile.total.end();
 
                 printProfile();
                 clearProfile();
 
-                PS::Comm::barrier();
+                barrierProfile();
                 profile.total.start();
 #endif
+                trace_log.flush();
             }
 
             // modify the tree step
@@ -3950,7 +4414,7 @@ public:
 
 #ifdef PROFILE
                 profile.total.barrier();
-                PS::Comm::barrier();
+                barrierProfile();
                 profile.total.end();
 #endif
                 return 0;
@@ -3996,7 +4460,7 @@ public:
 #ifdef PROFILE
             // calculate profile
             profile.total.barrier();
-            PS::Comm::barrier();
+            barrierProfile();
             profile.total.end();
 
             calcProfile();
@@ -4022,9 +4486,14 @@ public:
 #ifdef PROFILE
         if (fprofile.is_open()) fprofile.close();
 #endif
+        if (trace_log.isActive()) trace_log.close();
+        if (perf_counter.isActive()) perf_counter.close();
 
 #ifdef BSE_BASE
         auto& interaction = hard_manager.ar_manager.interaction;
+        interaction.flushEventLog();
+        interaction.sse_event.close();
+        interaction.bse_event.close();
         if (interaction.fout_sse.is_open()) interaction.fout_sse.close();
         if (interaction.fout_bse.is_open()) interaction.fout_bse.close();
 #endif
@@ -4046,7 +4515,11 @@ public:
         initial_step_flag = false;
     }
 
-    ~PeTar() { clear();}
+    ~PeTar() { 
+        clear();
+        for (auto tree: tree_set) delete tree;
+        tree_set.clear();
+    }
 };
 
 bool PeTar::initial_fdps_flag = false;
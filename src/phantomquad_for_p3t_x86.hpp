@@ -33,6 +33,16 @@ private:
     float epjbuf [NJMAX]    [4];      // x, y, z, m
     float rsearchj[NJMAX];            // r_search_j
     float spjbuf [NJMAX]    [3][4];   // x, y, z, m, | xx, yy, zz, pad, | xy, yz, zx, tr
+#ifdef KDKDK_4TH
+#ifdef USE__AVX512
+    float xiaccbuf [NIMAX/16] [3][16]; // ax, ay, az of i particles
+    float acorrbuf [NIMAX/16] [3][16]; // gradient correction x, y, z
+#else
+    float xiaccbuf [NIMAX/8]  [3][8];  // ax, ay, az of i particles
+    float acorrbuf [NIMAX/8]  [3][8];  // gradient correction x, y, z
+#endif
+    float epjaccbuf[NJMAX]    [4];     // ax, ay, az, pad
+#endif
 
     double eps2;
     static double get_a_NaN(){
@@ -330,6 +340,55 @@ public:
         kernel_spj_nounroll(ni, nj);
         // kernel_spj_unroll2(ni, nj);
     }
+
+#ifdef KDKDK_4TH
+    //! set acceleration of i particle for gradient correction
+    void set_xi_acc_one(const int addr, const double ax, const double ay, const double az){
+#ifdef USE__AVX512
+        const int ah = addr / 16;
+        const int al = addr % 16;
+#else
+        const int ah = addr / 8;
+        const int al = addr % 8;
+#endif
+        xiaccbuf[ah][0][al] = ax;
+        xiaccbuf[ah][1][al] = ay;
+        xiaccbuf[ah][2][al] = az;
+    }
+
+    //! set acceleration of j particle for gradient correction, set_epj_one is also needed
+    void set_epj_acc_one(const int addr, const double ax, const double ay, const double az){
+        epjaccbuf[addr][0] = ax;
+        epjaccbuf[addr][1] = ay;
+        epjaccbuf[addr][2] = az;
+        epjaccbuf[addr][3] = 0.0;
+    }
+
+    template <typename real_t>
+    void accum_acorr_one(const int addr, real_t &ax, real_t &ay, real_t &az){
+#ifdef USE__AVX512
+        const int ah = addr / 16;
+        const int al = addr % 16;
+#else
+        const int ah = addr / 8;
+        const int al = addr % 8;
+#endif
+        ax += acorrbuf[ah][0][al];
+        ay += acorrbuf[ah][1][al];
+        az += acorrbuf[ah][2][al];
+    }
+
+    //! gradient correction for KDKDK_4TH with linear cutoff (r_crit2 is used as r_out^2)
+    void run_epj_for_correction_with_linear_cutoff(const int ni, const int nj){
+        if(ni > NIMAX || nj > NJMAX){
+            std::cout<<"ni= "<<ni<<" NIMAX= "<<NIMAX<<" nj= "<<nj<<" NJMAX= "<<NJMAX<<std::endl;
+        }
+        assert(ni <= NIMAX);
+        assert(nj <= NJMAX);
+        kernel_epj_nounroll_for_correction_with_linear_cutoff(ni, nj);
+    }
+#endif
+
     /*
     void run_spj_d(const int ni, const int nj){
 	if(ni > NIMAX || nj > NJMAX){
@@ -727,6 +786,140 @@ private:
 
 #endif
 
+#ifdef KDKDK_4TH
+#ifdef USE__AVX512
+    __attribute__ ((noinline))
+    void kernel_epj_nounroll_for_correction_with_linear_cutoff(const int ni, const int nj){
+        const v16sf veps2 = _mm512_set1_ps((float)eps2);
+        const v16sf vr_out2 = _mm512_set1_ps((float)r_crit2);
+        const v16sf v3p0 = _mm512_set1_ps(3.0f);
+        for(int i=0; i<ni; i+=16){
+            const v16sf xi = *(v16sf *)(xibuf[i/16][0]);
+            const v16sf yi = *(v16sf *)(xibuf[i/16][1]);
+            const v16sf zi = *(v16sf *)(xibuf[i/16][2]);
+            const v16sf axi = *(v16sf *)(xiaccbuf[i/16][0]);
+            const v16sf ayi = *(v16sf *)(xiaccbuf[i/16][1]);
+            const v16sf azi = *(v16sf *)(xiaccbuf[i/16][2]);
+
+            v16sf acx, acy, acz;
+            acx = acy = acz = _mm512_set1_ps(0.0f);
+            for(int j=0; j<nj; j++) {
+                v16sf dx = _mm512_sub_ps(xi, _mm512_set1_ps(epjbuf[j][0]));
+                v16sf dy = _mm512_sub_ps(yi, _mm512_set1_ps(epjbuf[j][1]));
+                v16sf dz = _mm512_sub_ps(zi, _mm512_set1_ps(epjbuf[j][2]));
+                v16sf dax = _mm512_sub_ps(axi, _mm512_set1_ps(epjaccbuf[j][0]));
+                v16sf day = _mm512_sub_ps(ayi, _mm512_set1_ps(epjaccbuf[j][1]));
+                v16sf daz = _mm512_sub_ps(azi, _mm512_set1_ps(epjaccbuf[j][2]));
+
+                v16sf r2 = _mm512_fmadd_ps(dx, dx, veps2);
+                r2 = _mm512_fmadd_ps(dy, dy, r2);
+                r2 = _mm512_fmadd_ps(dz, dz, r2);
+                r2 = _mm512_max_ps(r2, vr_out2);
+                v16sf ri1  = _mm512_rsqrt14_ps(r2);
+                v16sf ri2 = _mm512_mul_ps(ri1, ri1);
+#ifdef RSQRT_NR_EPJ_X4
+                v16sf v1 = _mm512_set1_ps(1.0f);
+                v16sf h = _mm512_fnmadd_ps(r2, ri2, v1);
+                ri2 = _mm512_fmadd_ps(h, _mm512_set1_ps(5.0f), _mm512_set1_ps(6.0f));
+                ri2 = _mm512_fmadd_ps(h, ri2, _mm512_set1_ps(8.0f));
+                ri2 = _mm512_mul_ps(h, ri2);
+                ri2 = _mm512_fmadd_ps(ri2, _mm512_set1_ps((float)1.0/16.0), v1);
+                ri1 = _mm512_mul_ps(ri2, ri1);
+                ri2 = _mm512_mul_ps(ri1, ri1);
+#elif defined(RSQRT_NR_EPJ_X2)
+                ri2 = _mm512_fnmadd_ps(r2, ri2, v3p0);
+                ri2 = _mm512_mul_ps(ri2, _mm512_set1_ps(0.5f));
+                ri1 = _mm512_mul_ps(ri2, ri1);
+                ri2 = _mm512_mul_ps(ri1, ri1);
+#endif
+                v16sf mri3 = _mm512_mul_ps(_mm512_mul_ps(ri1, _mm512_set1_ps(epjbuf[j][3])), ri2);
+
+                // alpha = 3 (dr.da) / r^2
+                v16sf drda = _mm512_mul_ps(dx, dax);
+                drda = _mm512_fmadd_ps(dy, day, drda);
+                drda = _mm512_fmadd_ps(dz, daz, drda);
+                v16sf alpha = _mm512_mul_ps(_mm512_mul_ps(v3p0, drda), ri2);
+
+                // acorr -= m/r^3 (da - alpha dr)
+                acx = _mm512_fnmadd_ps(mri3, _mm512_fnmadd_ps(alpha, dx, dax), acx);
+                acy = _mm512_fnmadd_ps(mri3, _mm512_fnmadd_ps(alpha, dy, day), acy);
+                acz = _mm512_fnmadd_ps(mri3, _mm512_fnmadd_ps(alpha, dz, daz), acz);
+            }
+            *(v16sf *)(acorrbuf[i/16][0]) = acx;
+            *(v16sf *)(acorrbuf[i/16][1]) = acy;
+            *(v16sf *)(acorrbuf[i/16][2]) = acz;
+        }
+    }
+#else
+    __attribute__ ((noinline))
+    void kernel_epj_nounroll_for_correction_with_linear_cutoff(const int ni, const int nj){
+        const v8sf veps2 = _mm256_set1_ps((float)eps2);
+        const v8sf vr_out2 = _mm256_set1_ps((float)r_crit2);
+        const v8sf v3p0 = _mm256_set1_ps(3.0f);
+        for(int i=0; i<ni; i+=8){
+            const v8sf xi = *(v8sf *)(xibuf[i/8][0]);
+            const v8sf yi = *(v8sf *)(xibuf[i/8][1]);
+            const v8sf zi = *(v8sf *)(xibuf[i/8][2]);
+            const v8sf axi = *(v8sf *)(xiaccbuf[i/8][0]);
+            const v8sf ayi = *(v8sf *)(xiaccbuf[i/8][1]);
+            const v8sf azi = *(v8sf *)(xiaccbuf[i/8][2]);
+
+            v8sf acx, acy, acz;
+            acx = acy = acz = _mm256_set1_ps(0.0f);
+            for(int j=0; j<nj; j++){
+                const v8sf jbuf = _mm256_broadcast_ps((v4sf *)(epjbuf + j));
+                const v8sf jabuf = _mm256_broadcast_ps((v4sf *)(epjaccbuf + j));
+
+                v8sf dx = _mm256_sub_ps(xi, _mm256_shuffle_ps(jbuf, jbuf, 0x00));
+                v8sf dy = _mm256_sub_ps(yi, _mm256_shuffle_ps(jbuf, jbuf, 0x55));
+                v8sf dz = _mm256_sub_ps(zi, _mm256_shuffle_ps(jbuf, jbuf, 0xaa));
+                v8sf mj = _mm256_shuffle_ps(jbuf, jbuf, 0xff);
+                v8sf dax = _mm256_sub_ps(axi, _mm256_shuffle_ps(jabuf, jabuf, 0x00));
+                v8sf day = _mm256_sub_ps(ayi, _mm256_shuffle_ps(jabuf, jabuf, 0x55));
+                v8sf daz = _mm256_sub_ps(azi, _mm256_shuffle_ps(jabuf, jabuf, 0xaa));
+
+                v8sf r2 = _mm256_fmadd_ps(dx, dx, veps2);
+                r2 = _mm256_fmadd_ps(dy, dy, r2);
+                r2 = _mm256_fmadd_ps(dz, dz, r2);
+                r2 = _mm256_max_ps(r2, vr_out2);
+                v8sf ri1 = _mm256_rsqrt_ps(r2);
+                v8sf ri2 = _mm256_mul_ps(ri1, ri1);
+#ifdef RSQRT_NR_EPJ_X4
+                v8sf v1 = _mm256_set1_ps(1.0f);
+                v8sf h = _mm256_fnmadd_ps(r2, ri2, v1);
+                ri2 = _mm256_fmadd_ps(h, _mm256_set1_ps(5.0f), _mm256_set1_ps(6.0f));
+                ri2 = _mm256_fmadd_ps(h, ri2, _mm256_set1_ps(8.0f));
+                ri2 = _mm256_mul_ps(h, ri2);
+                ri2 = _mm256_fmadd_ps(ri2, _mm256_set1_ps((float)1.0/16.0), v1);
+                ri1 = _mm256_mul_ps(ri2, ri1);
+                ri2 = _mm256_mul_ps(ri1, ri1);
+#elif defined(RSQRT_NR_EPJ_X2)
+                ri2 = _mm256_fnmadd_ps(r2, ri2, v3p0);
+                ri2 = _mm256_mul_ps(ri2, _mm256_set1_ps(0.5f));
+                ri1 = _mm256_mul_ps(ri2, ri1);
+                ri2 = _mm256_mul_ps(ri1, ri1);
+#endif
+                v8sf mri3 = _mm256_mul_ps(_mm256_mul_ps(mj, ri1), ri2);
+
+                // alpha = 3 (dr.da) / r^2
+                v8sf drda = _mm256_mul_ps(dx, dax);
+                drda = _mm256_fmadd_ps(dy, day, drda);
+                drda = _mm256_fmadd_ps(dz, daz, drda);
+                v8sf alpha = _mm256_mul_ps(_mm256_mul_ps(v3p0, drda), ri2);
+
+                // acorr -= m/r^3 (da - alpha dr)
+                acx = _mm256_fnmadd_ps(mri3, _mm256_fnmadd_ps(alpha, dx, dax), acx);
+                acy = _mm256_fnmadd_ps(mri3, _mm256_fnmadd_ps(alpha, dy, day), acy);
+                acz = _mm256_fnmadd_ps(mri3, _mm256_fnmadd_ps(alpha, dz, daz), acz);
+            }
+            *(v8sf *)(acorrbuf[i/8][0]) = acx;
+            *(v8sf *)(acorrbuf[i/8][1]) = acy;
+            *(v8sf *)(acorrbuf[i/8][2]) = acz;
+        }
+    }
+#endif
+#endif
+
 #ifdef USE__AVX512
     __attribute__ ((noinline))
     void kernel_epj_nounroll(const int ni, const int nj){
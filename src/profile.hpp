@@ -4,6 +4,8 @@
 #include<iostream>
 //#include<fstream>
 #include<map>
+#include"trace.hpp"
+#include"perf_counter.hpp"
 
 #define PROFILE_PRINT_WIDTH 13
 
@@ -177,20 +179,63 @@ struct Tprofile{
     PS::F64 time;
     PS::F64 tbar; // barrier time, measure before barrier near end()
     const char* name;
+    PS::F64 tstart; // start time of the current span for timeline trace
+    PS::F64 tbar_start; // barrier start time of the current span
+    std::vector<PS::S64> hw_count; // hardware counters of each thread [thread*PERF_COUNTER_N + counter], used when perf_counter is active
+    std::vector<PS::S64> hw_read;  // buffer of the current counter values
     
-    Tprofile(const char* _name): time(0.0), tbar(0.0), name(_name) {}
+    Tprofile(const char* _name): time(0.0), tbar(0.0), name(_name), tstart(0.0), tbar_start(0.0), hw_count(), hw_read() {}
     
     void start(){
-        time -= PS::GetWtime();
+        if (perf_counter.isActive()) addPerfCounter(-1);
+        tstart = PS::GetWtime();
+        tbar_start = 0.0;
+        time -= tstart;
     }
 
     void barrier(){
-        tbar -= PS::GetWtime();
+        tbar_start = PS::GetWtime();
+        tbar -= tbar_start;
     }
 
     void end(){
-        tbar += PS::GetWtime();
-        time += PS::GetWtime();
+        const PS::F64 tend = PS::GetWtime();
+        tbar += tend;
+        time += tend;
+        // timeline span including the barrier waiting time in ns
+        if (trace_log.isActive()) trace_log.add(name, tstart, tend, "barrier_ns", tbar_start>0.0? PS::S64((tend-tbar_start)*1e9): 0);
+        if (perf_counter.isActive()) addPerfCounter(1);
+    }
+
+    //! add (_sign=1) or subtract (_sign=-1) the current hardware counter values of all threads, call outside parallel regions
+    void addPerfCounter(const PS::S64 _sign) {
+        const PS::S32 n = perf_counter.getSize();
+        hw_read.resize(n);
+        if ((PS::S32)hw_count.size()!=n) hw_count.assign(n, 0);
+        perf_counter.read(hw_read.data());
+        for (PS::S32 i=0; i<n; i++) hw_count[i] += _sign*hw_read[i];
+    }
+
+    //! get hardware counter summed over threads
+    PS::S64 getPerfCounterSum(const PS::S32 _k) const {
+        PS::S64 sum = 0;
+        for (PS::S32 i=_k; i<(PS::S32)hw_count.size(); i+=PERF_COUNTER_N) sum += hw_count[i];
+        return sum;
+    }
+
+    //! get maximum hardware counter among threads
+    PS::S64 getPerfCounterMax(const PS::S32 _k) const {
+        PS::S64 nmax = 0;
+        for (PS::S32 i=_k; i<(PS::S32)hw_count.size(); i+=PERF_COUNTER_N) nmax = std::max(nmax, hw_count[i]);
+        return nmax;
+    }
+
+    //! print hardware counters per call summed over threads, instructions per cycle and the maximum cycles among threads
+    void dumpPerfCounter(std::ostream & fout, const PS::S64 divider=1, const PS::S32 width=PROFILE_PRINT_WIDTH) const {
+        for (PS::S32 k=0; k<PERF_COUNTER_N; k++) fout<<std::setw(width)<<(PS::F64)getPerfCounterSum(k)/divider;
+        const PS::S64 ncycle = getPerfCounterSum(0);
+        fout<<std::setw(width)<<(ncycle>0? (PS::F64)getPerfCounterSum(1)/ncycle: 0.0)
+            <<std::setw(width)<<(PS::F64)getPerfCounterMax(0)/divider;
     }
     
     void print(std::ostream & fout, const PS::S32 divider=1){
@@ -226,6 +271,7 @@ struct Tprofile{
     void reset() {
         time = 0.0;
         tbar = 0.0;
+        for (auto& c: hw_count) c = 0;
     }
 
 };
@@ -266,11 +312,66 @@ struct NumCounter{
 
 class FDPSProfile: public PS::TimeProfile {
 public:
+    PS::S64 n_let_ep_send; // number of EPJ sent in the 1st LET exchange
+    PS::S64 n_let_sp_send; // number of SPJ sent in the 1st LET exchange
+    PS::F64 let_byte_send; // bytes sent in the 1st LET exchange
+
+    FDPSProfile(): TimeProfile(), n_let_ep_send(0), n_let_sp_send(0), let_byte_send(0.0) {}
+
     FDPSProfile &operator+=(const PS::TimeProfile _tp) {
         *(TimeProfile*)this = *(TimeProfile*)this + _tp;
         return *this;
     }
 
+private:
+    //! get numbers of EPJ and SPJ sent in the 1st LET exchange if the tree provides the counters
+    template <class Ttree>
+    static auto getLETSendNumber(const Ttree& _tree, PS::S64& _n_ep, PS::S64& _n_sp, int) 
+        -> decltype(_tree.getNumberOfLETEPSend1stLocal(), _tree.getNumberOfLETSPSend1stLocal(), void()) {
+        _n_ep = _tree.getNumberOfLETEPSend1stLocal();
+        _n_sp = _tree.getNumberOfLETSPSend1stLocal();
+    }
+
+    //! the FDPS version has no LET counters, nothing is counted
+    template <class Ttree>
+    static void getLETSendNumber(const Ttree& _tree, PS::S64& _n_ep, PS::S64& _n_sp, long) {
+        _n_ep = _n_sp = 0;
+    }
+
+public:
+    //! accumulate LET sending volume of the last force calculation
+    /*! The counters are read only if the FDPS TreeForForce provides getNumberOfLETEPSend1stLocal/getNumberOfLETSPSend1stLocal, otherwise zero is recorded.
+      @param[in] _tree: long-range tree
+      \tparam Tepj: j particle type of the tree
+      \tparam Tspj: super particle type of the tree
+     */
+    template <class Tepj, class Tspj, class Ttree>
+    void addLETSend(const Ttree& _tree) {
+        PS::S64 n_ep, n_sp;
+        getLETSendNumber(_tree, n_ep, n_sp, 0);
+        n_let_ep_send += n_ep;
+        n_let_sp_send += n_sp;
+        let_byte_send += (PS::F64)n_ep*sizeof(Tepj) + (PS::F64)n_sp*sizeof(Tspj);
+    }
+
+    void clear() {
+        TimeProfile::clear();
+        n_let_ep_send = n_let_sp_send = 0;
+        let_byte_send = 0.0;
+    }
+
+    void dumpLETName(std::ostream & fout, const PS::S32 width=PROFILE_PRINT_WIDTH) const {
+        fout<<std::setw(width)<<"LET_EP_N"
+            <<std::setw(width)<<"LET_SP_N"
+            <<std::setw(width)<<"LET_MByte";
+    }
+
+    void dumpLET(std::ostream & fout, const PS::S64 n_loop=1, const PS::S32 width=PROFILE_PRINT_WIDTH) const {
+        fout<<std::setw(width)<<(PS::F64)n_let_ep_send/n_loop
+            <<std::setw(width)<<(PS::F64)n_let_sp_send/n_loop
+            <<std::setw(width)<<let_byte_send/(1024.0*1024.0)/n_loop;
+    }
+
     void dumpName(std::ostream & fout, const PS::S32 width=PROFILE_PRINT_WIDTH) const {
         fout<<std::setw(width)<<"Sample_ptcl"
             <<std::setw(width)<<"Domain_deco"
@@ -386,6 +487,19 @@ public:
         }
     }
 
+    //! print hardware counters per step of all phases, one phase per line
+    void dumpPerfCounter(std::ostream & fout, const PS::S64 n_loop=1, const PS::S32 width=PROFILE_PRINT_WIDTH) const {
+        fout<<std::setw(width)<<"Phase";
+        for (PS::S32 k=0; k<PERF_COUNTER_N; k++) fout<<std::setw(width)<<PerfCounter::getName(k);
+        fout<<std::setw(width)<<"IPC"<<std::setw(width)<<"Cycles_max"<<std::endl;
+        for(PS::S32 i=0; i<n_profile; i++) {
+            Tprofile* iptr = (Tprofile*)this+i;
+            iptr->dumpName(fout, width);
+            iptr->dumpPerfCounter(fout, n_loop, width);
+            fout<<std::endl;
+        }
+    }
+
     SysProfile getMax() {
         SysProfile pmax;
         for(PS::S32 i=0; i<n_profile; i++) {
@@ -431,6 +545,7 @@ public:
     NumCounter n_neighbor_zero;
     NumCounter ep_ep_interact;
     NumCounter ep_sp_interact;
+    NumCounter collective;
     //NumCounter ARC_step_group;
     const PS::S32 n_counter;
     std::map<PS::S32,PS::S32> n_cluster; ///<Histogram of number of particles in clusters
@@ -449,8 +564,9 @@ public:
                  n_neighbor_zero  (NumCounter("H4_no_NB   ")),
                  ep_ep_interact   (NumCounter("Ep-Ep_sum  ")),
                  ep_sp_interact   (NumCounter("Ep-Sp_sum  ")),
+                 collective       (NumCounter("Collective ")),
                  //ARC_step_group   (NumCounter("ARC step per group")),
-                 n_counter(14) {}
+                 n_counter(15) {}
 
     void clusterCount(const PS::S32 n, const PS::S32 ntimes=1) {
         if (n_cluster.count(n)) n_cluster[n] += ntimes;
@@ -14,10 +14,14 @@ public:
     /*! Create three particles that have the same quadrupole moment as orbit-averaged binaries.
         @param[in] _ptcl_artificial: particle array to store the sample particles, 2*n_split_ will be used
         @param[in] _bin: binary orbit 
+        @param[in] _shift_cm: if false, the positions and velocities are relative to the c.m. of _bin
      */
     template <class Tptcl>
     void createSampleParticles(Tptcl* _ptcl_artificial,
-                               COMM::BinaryTree<Tptcl,COMM::Binary> &_bin) {
+                               COMM::BinaryTree<Tptcl,COMM::Binary> &_bin,
+                               const bool _shift_cm=true) {
+        const PS::F64vec pos_cm = _shift_cm? _bin.pos: PS::F64vec(0.0);
+        const PS::F64vec vel_cm = _shift_cm? _bin.vel: PS::F64vec(0.0);
         PS::F64 m12 = _bin.mass;
         PS::F64 mu = _bin.m1*_bin.m2/m12;
         PS::F64 prefactor = _bin.semi*std::sqrt(mu/m12);
@@ -31,25 +35,25 @@ public:
         pi->mass = pmass;
         pi->pos = PS::F64vec(0, 2*beta, 0 );
         _bin.rotateToOriginalFrame(&(pi->pos.x));
-        pi->pos += _bin.pos;
-        pi->vel = _bin.vel;
+        pi->pos += pos_cm;
+        pi->vel = vel_cm;
         
         pi = &(_ptcl_artificial[1]);
         pi->mass = pmass;
         pi->pos = PS::F64vec(alpha, -beta, 0 );
         _bin.rotateToOriginalFrame(&(pi->pos.x));
-        pi->pos += _bin.pos;
-        pi->vel = _bin.vel;
+        pi->pos += pos_cm;
+        pi->vel = vel_cm;
 
         pi = &(_ptcl_artificial[2]);
         pi->mass = pmass;
         pi->pos = PS::F64vec(-alpha, -beta, 0 );
         _bin.rotateToOriginalFrame(&(pi->pos.x));
-        pi->pos += _bin.pos;
-        pi->vel = _bin.vel;
+        pi->pos += pos_cm;
+        pi->vel = vel_cm;
 
 #ifdef ARTIFICIAL_PARTICLE_DEBUG
-        PS::F64vec dv = (_ptcl_artificial[0].pos + _ptcl_artificial[1].pos + _ptcl_artificial[2].pos)/3 - _bin.pos;
+        PS::F64vec dv = (_ptcl_artificial[0].pos + _ptcl_artificial[1].pos + _ptcl_artificial[2].pos)/3 - pos_cm;
         assert(dv*dv<1e-10);
 #endif
     }
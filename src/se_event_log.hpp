@@ -0,0 +1,141 @@
+#pragma once
+#include <particle_simulator.hpp>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cassert>
+
+//! maximum label size (including '\0') of one stellar evolution event record
+#define SE_EVENT_LABEL_SIZE 24
+//! maximum column number of one stellar evolution event record
+#define SE_EVENT_COLUMN_MAX 64
+
+//! one stellar evolution (SSE/BSE) event record with fixed size
+/*! The record stores the same columns as the text output of the event: a label followed by integer or floating-point columns.
+    The text line is obtained by printing the label and then each column with width and precision (std::setw and std::setprecision),
+    see tools/se_event_convert.py.
+ */
+struct SEEventRecord{
+    char label[SE_EVENT_LABEL_SIZE]; // label printed before columns, including the padding
+    PS::S32 n_col;       // number of columns
+    PS::S32 width;       // print width of columns
+    PS::S32 precision;   // print precision of floating-point columns
+    PS::S32 reserved;    // for alignment
+    PS::U64 int_mask;    // bit i is 1: column i is integer
+    union {
+        PS::F64 f;
+        PS::S64 i;
+    } value[SE_EVENT_COLUMN_MAX];
+
+    //! set label
+    /*! @param[in] _label: label string
+        @param[in] _width: right-aligned print width of the label, same as std::setw (default: 0, no padding)
+     */
+    void setLabel(const char* _label, const int _width=0) {
+        snprintf(label, SE_EVENT_LABEL_SIZE, "%*s", _width, _label);
+    }
+
+    //! add an integer column
+    void add(const PS::S64 _value) {
+        assert(n_col<SE_EVENT_COLUMN_MAX);
+        value[n_col].i = _value;
+        int_mask |= (PS::U64(1)<<n_col);
+        n_col++;
+    }
+
+    //! add an integer column
+    void add(const PS::S32 _value) {
+        add(PS::S64(_value));
+    }
+
+    //! add a floating-point column
+    void add(const PS::F64 _value) {
+        assert(n_col<SE_EVENT_COLUMN_MAX);
+        value[n_col].f = _value;
+        n_col++;
+    }
+};
+
+//! per-thread buffers of stellar evolution event records
+/*! Events are appended to the buffer of the current OpenMP thread without locks and text formatting.
+    flush() writes all buffers to the binary file in the order of threads, it must be called outside parallel regions.
+    Events that print objects with layouts defined outside PeTar (e.g. slowdown binary) are still formatted as text,
+    but into the text buffer of the current thread, which is written to a given text file in flush().
+ */
+class SEEventLog{
+private:
+    std::vector<std::vector<SEEventRecord>> record_; // record buffer of each thread
+    std::vector<std::ostringstream> text_;  // text buffer of each thread
+    std::ofstream fout_;  // binary file
+    PS::S32 width_;
+    PS::S32 precision_;
+
+public:
+    SEEventLog(): record_(), text_(), fout_(), width_(20), precision_(6) {}
+
+    //! open binary file and prepare thread buffers
+    /*! @param[in] _fname: binary file name
+        @param[in] _append_flag: true: append to existing file
+        @param[in] _n_thread: number of OpenMP threads
+        @param[in] _width: print width of columns for text conversion
+        @param[in] _precision: print precision for text conversion
+     */
+    void open(const std::string& _fname, const bool _append_flag, const PS::S32 _n_thread, const PS::S32 _width, const PS::S32 _precision) {
+        if (_append_flag) fout_.open(_fname.c_str(), std::ofstream::out|std::ofstream::binary|std::ofstream::app);
+        else fout_.open(_fname.c_str(), std::ofstream::out|std::ofstream::binary);
+        width_ = _width;
+        precision_ = _precision;
+        record_.resize(_n_thread);
+        text_.resize(_n_thread);
+        for (auto& text: text_) text<<std::setprecision(_precision);
+    }
+
+    bool isOpen() const {
+        return fout_.is_open();
+    }
+
+    //! create a new record in the buffer of the current thread
+    SEEventRecord& createRecord() {
+        const PS::S32 ith = PS::Comm::getThreadNum();
+        assert(ith<PS::S32(record_.size()));
+        record_[ith].emplace_back();
+        SEEventRecord& record = record_[ith].back();
+        record.label[0] = '\0';
+        record.n_col = 0;
+        record.width = width_;
+        record.precision = precision_;
+        record.reserved = 0;
+        record.int_mask = 0;
+        return record;
+    }
+
+    //! get the text buffer of the current thread
+    std::ostream& getTextBuffer() {
+        const PS::S32 ith = PS::Comm::getThreadNum();
+        assert(ith<PS::S32(text_.size()));
+        return text_[ith];
+    }
+
+    //! write buffered records to the binary file and text to _fout_text, then clear buffers
+    void flush(std::ostream& _fout_text) {
+        for (auto& buffer: record_) {
+            if (buffer.size()>0 && fout_.is_open())
+                fout_.write((const char*)buffer.data(), sizeof(SEEventRecord)*buffer.size());
+            buffer.clear();
+        }
+        if (fout_.is_open()) fout_.flush();
+        for (auto& text: text_) {
+            const std::string& str = text.str();
+            if (str.size()>0) _fout_text<<str;
+            text.str("");
+        }
+    }
+
+    //! close binary file, buffers should be flushed before
+    void close() {
+        if (fout_.is_open()) fout_.close();
+    }
+};
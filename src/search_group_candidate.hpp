@@ -1,10 +1,16 @@
 #pragma once
 #include<particle_simulator.hpp>
+#include<algorithm>
 
 #ifndef ARRAY_ALLOW_LIMIT
 #define ARRAY_ALLOW_LIMIT 1000000000
 #endif
 
+//! minimum cluster size to use cell list in partner search
+#ifndef SEARCH_GROUP_CANDIDATE_GRID_THRESHOLD
+#define SEARCH_GROUP_CANDIDATE_GRID_THRESHOLD 256
+#endif
+
 template<class Tptcl>
 class SearchGroupCandidate{
 private:
@@ -15,7 +21,7 @@ private:
     PS::ReallocatableArray<PS::S32> group_list_disp_;
     PS::ReallocatableArray<PS::S32> group_list_n_;
 
-    //! Search partner to create group
+    //! Search partner by checking all pairs
     /* If r.v >0, Use bin factor sqrt(r^2 - (r*v/|v|)^2) to check, otherwise use distance to check. The mass ratio is also considered.
        The perturber acceleration from non-partner member is stored in mass_bk for the later stablility check
        @param[out] _part_list: partner index in _ptcl for each particle
@@ -24,7 +30,7 @@ private:
        @param[in,out] _ptcl: particle data, mass_bk is updated
        @param[in] _n: number of particles
     */
-    void searchPartner(PS::ReallocatableArray<PS::S32> & _part_list,
+    void searchPartnerDirect(PS::ReallocatableArray<PS::S32> & _part_list,
                        PS::ReallocatableArray<PS::S32> & _part_list_disp,
                        PS::ReallocatableArray<PS::S32> & _part_list_n,
                        Tptcl *_ptcl,
@@ -105,6 +111,118 @@ private:
         }
     }
 
+    //! Search partner using a cell list
+    /*! The cell size is the maximum group candidate radius (changeover inner radius) of members,
+        thus partners of a particle are always in the neighbor 27 cells.
+        Particles are sorted by the cell key and the partners found in neighbor cells are sorted by index,
+        so that the partner lists are identical to those from searchPartnerDirect.
+        @param[out] _part_list: partner index in _ptcl for each particle
+        @param[out] _part_list_disp: offset to separate partner index for different particles
+        @param[out] _part_list_n: number of partners for each particle
+        @param[in] _ptcl: particle data
+        @param[in] _n: number of particles
+        \return false if the cell list is not used (zero radius, too many or too few cells), partner lists are not changed in this case
+    */
+    bool searchPartnerGrid(PS::ReallocatableArray<PS::S32> & _part_list,
+                           PS::ReallocatableArray<PS::S32> & _part_list_disp,
+                           PS::ReallocatableArray<PS::S32> & _part_list_n,
+                           Tptcl *_ptcl,
+                           const PS::S32 _n) {
+        if (_n<=0) return false;
+
+        // cell size and boundary
+        PS::F64 r_cell = 0.0;
+        PS::F64vec pos_min = _ptcl[0].pos, pos_max = _ptcl[0].pos;
+        for(int i=0; i<_n; i++) {
+            r_cell = std::max(r_cell, _ptcl[i].getRGroupCandidate());
+            const PS::F64vec& pos = _ptcl[i].pos;
+            pos_min.x = std::min(pos_min.x, pos.x);
+            pos_min.y = std::min(pos_min.y, pos.y);
+            pos_min.z = std::min(pos_min.z, pos.z);
+            pos_max.x = std::max(pos_max.x, pos.x);
+            pos_max.y = std::max(pos_max.y, pos.y);
+            pos_max.z = std::max(pos_max.z, pos.z);
+        }
+        if (!(r_cell>0.0)) return false;
+
+        const PS::F64 r_cell_inv = 1.0/r_cell;
+        const PS::F64vec box = pos_max - pos_min;
+        // one extra cell on each side avoids boundary checks for neighbor cells
+        const PS::F64 nx_f = box.x*r_cell_inv + 3.0;
+        const PS::F64 ny_f = box.y*r_cell_inv + 3.0;
+        const PS::F64 nz_f = box.z*r_cell_inv + 3.0;
+        // avoid overflow of the cell key for very sparse clusters
+        if (!(nx_f*ny_f*nz_f<4.0e18)) return false;
+        // when the neighbor cells cover a large fraction of the cluster, checking all pairs is faster
+        if ((nx_f-2.0)*(ny_f-2.0)*(nz_f-2.0)<64.0) return false;
+        const PS::S64 nx = PS::S64(nx_f);
+        const PS::S64 ny = PS::S64(ny_f);
+
+        // cell key and sorted index
+        PS::ReallocatableArray<std::pair<PS::S64,PS::S32>> cell;
+        cell.resizeNoInitialize(_n);
+        for(int i=0; i<_n; i++) {
+            const PS::F64vec dr = (_ptcl[i].pos - pos_min)*r_cell_inv;
+            const PS::S64 ix = PS::S64(dr.x) + 1;
+            const PS::S64 iy = PS::S64(dr.y) + 1;
+            const PS::S64 iz = PS::S64(dr.z) + 1;
+            cell[i].first = ix + nx*(iy + ny*iz);
+            cell[i].second = i;
+        }
+        std::sort(cell.getPointer(), cell.getPointer()+_n);
+
+        _part_list.clearSize();
+        _part_list_disp.reserve(_n);
+        _part_list_disp.resizeNoInitialize(_n);
+        _part_list_n.reserve(_n);
+        _part_list_n.resizeNoInitialize(_n);
+
+        PS::ReallocatableArray<PS::S32> cell_index;
+        cell_index.resizeNoInitialize(_n);
+        for(int k=0; k<_n; k++) cell_index[cell[k].second] = k;
+
+        PS::S32 offset = 0;
+        for(int i=0; i<_n; i++) {
+            _part_list_n[i] = 0;
+            _part_list_disp[i] = offset;
+            const PS::S64 key_i = cell[cell_index[i]].first;
+            const PS::F64 rc_i = _ptcl[i].getRGroupCandidate();
+
+            // check candidates from neighbor cells
+            for(PS::S64 dz=-1; dz<=1; dz++) {
+                for(PS::S64 dy=-1; dy<=1; dy++) {
+                    // three cells along x are contiguous in key
+                    const PS::S64 key_start = key_i + nx*(dy + ny*dz) - 1;
+                    const PS::S64 key_end = key_start + 2;
+                    const std::pair<PS::S64,PS::S32>* iter = std::lower_bound(cell.getPointer(), cell.getPointer()+_n, std::make_pair(key_start, PS::S32(-1)));
+                    for(; iter!=cell.getPointer()+_n && iter->first<=key_end; iter++) {
+                        const PS::S32 j = iter->second;
+                        if(i==j) continue;
+                        PS::F64vec dr = _ptcl[i].pos-_ptcl[j].pos;
+                        PS::F64 r2 = dr*dr;
+                        // use the same criterion as searchPartnerDirect
+                        PS::F64 rin_min = std::min(rc_i, _ptcl[j].getRGroupCandidate());
+                        if (r2<rin_min*rin_min) {
+                            _part_list.push_back(j);
+                            _part_list_n[i]++;
+                            offset++;
+                        }
+#ifdef HARD_DEBUG
+                        if(r2==0) {
+                            std::cerr<<"Error: zero distance! i="<<i<<" j="<<j<<std::endl;
+                            abort();
+                        }
+#endif
+                    }
+                }
+            }
+            // keep the same partner order as searchPartnerDirect
+            PS::S32* part_i = _part_list.getPointer() + _part_list_disp[i];
+            std::sort(part_i, part_i + _part_list_n[i]);
+        }
+        return true;
+    }
+
     void mergeGroup(PS::ReallocatableArray<PS::S32> & group_list,
                       PS::ReallocatableArray<PS::S32> & group_list_disp,
                       PS::ReallocatableArray<PS::S32> & group_list_n,
@@ -220,6 +338,29 @@ private:
 
 
 public:
+    PS::S32 n_grid_threshold; // minimum particle number to use the cell list in partner search
+
+    SearchGroupCandidate(): group_list_(), group_list_disp_(), group_list_n_(), n_grid_threshold(SEARCH_GROUP_CANDIDATE_GRID_THRESHOLD) {}
+
+    //! Search partner to create group
+    /*! Use the cell list when the particle number is not less than n_grid_threshold, otherwise check all pairs.
+        Both give identical partner lists.
+       @param[out] _part_list: partner index in _ptcl for each particle
+       @param[out] _part_list_disp: offset to separate partner index for different particles
+       @param[out] _part_list_n: number of partners for each particle
+       @param[in,out] _ptcl: particle data
+       @param[in] _n: number of particles
+    */
+    void searchPartner(PS::ReallocatableArray<PS::S32> & _part_list,
+                       PS::ReallocatableArray<PS::S32> & _part_list_disp,
+                       PS::ReallocatableArray<PS::S32> & _part_list_n,
+                       Tptcl *_ptcl,
+                       const PS::S32 _n) {
+        if (_n>=n_grid_threshold) {
+            if (searchPartnerGrid(_part_list, _part_list_disp, _part_list_n, _ptcl, _n)) return;
+        }
+        searchPartnerDirect(_part_list, _part_list_disp, _part_list_n, _ptcl, _n);
+    }
 
     void searchAndMerge(Tptcl *_ptcl_in_cluster, const PS::S32 _n_ptcl) {
         PS::ReallocatableArray<PS::S32> part_list;      ///partner list
@@ -0,0 +1,167 @@
+#include <iostream>
+#include <iomanip>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <random>
+#include <getopt.h>
+#include <particle_simulator.hpp>
+#include "search_group_candidate.hpp"
+
+//! lightweight particle for partner search benchmark
+struct PtclBench{
+    PS::F64vec pos;
+    PS::F64 r_in;
+
+    PS::F64 getRGroupCandidate() const {
+        return r_in;
+    }
+};
+
+//! generate a Plummer sphere with scale radius 1, a fraction of particles are binaries
+/*! @param[out] _ptcl: particle array
+    @param[in] _n: number of particles
+    @param[in] _r_in: average changeover inner radius
+    @param[in] _fbin: binary fraction
+    @param[in] _seed: random seed
+ */
+void generatePlummer(PS::ReallocatableArray<PtclBench>& _ptcl, const PS::S32 _n, const PS::F64 _r_in, const PS::F64 _fbin, const PS::S32 _seed) {
+    std::mt19937_64 gen(_seed);
+    std::uniform_real_distribution<PS::F64> uni(0.0, 1.0);
+    _ptcl.resizeNoInitialize(_n);
+    const PS::F64 pi = 4.0*std::atan(1.0);
+    auto randomDirection = [&](const PS::F64 _r) {
+        PS::F64 cth = 2.0*uni(gen) - 1.0;
+        PS::F64 sth = std::sqrt(1.0 - cth*cth);
+        PS::F64 phi = 2.0*pi*uni(gen);
+        return PS::F64vec(_r*sth*std::cos(phi), _r*sth*std::sin(phi), _r*cth);
+    };
+    PS::S32 i=0;
+    while (i<_n) {
+        // truncate the halo to keep the cluster compact
+        PS::F64 x = std::min(uni(gen), 0.99);
+        PS::F64 r = 1.0/std::sqrt(std::pow(x, -2.0/3.0) - 1.0);
+        PS::F64vec pos = randomDirection(r);
+        // changeover radius of members varies by a factor of 2 (mass dependent)
+        PS::F64 r_in = _r_in*(0.5 + uni(gen));
+        _ptcl[i].pos = pos;
+        _ptcl[i].r_in = r_in;
+        i++;
+        if (i<_n && uni(gen)<_fbin) {
+            _ptcl[i].pos = pos + randomDirection(0.1*r_in*uni(gen)+1e-8);
+            _ptcl[i].r_in = r_in;
+            i++;
+        }
+    }
+}
+
+//! compare two partner lists
+bool isSameList(PS::ReallocatableArray<PS::S32>& _list1, PS::ReallocatableArray<PS::S32>& _list2) {
+    if (_list1.size()!=_list2.size()) return false;
+    for (PS::S32 i=0; i<_list1.size(); i++)
+        if (_list1[i]!=_list2[i]) return false;
+    return true;
+}
+
+int main(int argc, char **argv){
+    PS::S32 n_min = 256;
+    PS::S32 n_max = 16384;
+    PS::S32 n_loop = 5;
+    PS::F64 r_in = 0.0;
+    PS::F64 fbin = 0.3;
+    PS::S32 seed = 1;
+
+    int copt;
+    while ((copt = getopt(argc, argv, "n:N:l:r:b:s:h")) != -1)
+        switch (copt) {
+        case 'n':
+            n_min = atoi(optarg);
+            break;
+        case 'N':
+            n_max = atoi(optarg);
+            break;
+        case 'l':
+            n_loop = atoi(optarg);
+            break;
+        case 'r':
+            r_in = atof(optarg);
+            break;
+        case 'b':
+            fbin = atof(optarg);
+            break;
+        case 's':
+            seed = atoi(optarg);
+            break;
+        case 'h':
+            std::cout<<"Benchmark of partner search in SearchGroupCandidate: all pairs vs. cell list\n"
+                     <<"Synthetic clusters are Plummer spheres (scale radius 1) with binaries; particle number is doubled from n_min to n_max\n"
+                     <<"Options:\n"
+                     <<"  -n [int]:    minimum particle number ("<<n_min<<")\n"
+                     <<"  -N [int]:    maximum particle number ("<<n_max<<")\n"
+                     <<"  -l [int]:    number of repeats for timing ("<<n_loop<<")\n"
+                     <<"  -r [double]: average changeover inner radius (0: 0.1*N^(-1/3))\n"
+                     <<"  -b [double]: binary fraction ("<<fbin<<")\n"
+                     <<"  -s [int]:    random seed ("<<seed<<")\n"
+                     <<"  -h:          help\n";
+            return 0;
+        default:
+            std::cerr<<"Unknown argument. check '-h' for help.\n";
+            abort();
+        }
+
+    const int width=14;
+    std::cout<<std::setw(width)<<"N"
+             <<std::setw(width)<<"r_in"
+             <<std::setw(width)<<"N_partner"
+             <<std::setw(width)<<"T_direct[s]"
+             <<std::setw(width)<<"T_grid[s]"
+             <<std::setw(width)<<"Speedup"
+             <<std::setw(width)<<"Identical"
+             <<std::endl;
+
+    bool fail_flag = false;
+    for (PS::S32 n=n_min; n<=n_max; n*=2) {
+        PS::ReallocatableArray<PtclBench> ptcl;
+        PS::F64 r_in_n = r_in>0.0? r_in: 0.1*std::pow(PS::F64(n), -1.0/3.0);
+        generatePlummer(ptcl, n, r_in_n, fbin, seed);
+
+        SearchGroupCandidate<PtclBench> search_direct, search_grid;
+        search_direct.n_grid_threshold = n+1;
+        search_grid.n_grid_threshold = 0;
+
+        PS::ReallocatableArray<PS::S32> list_direct, disp_direct, n_direct;
+        PS::ReallocatableArray<PS::S32> list_grid, disp_grid, n_grid;
+
+        PS::F64 t_direct = 0.0, t_grid = 0.0;
+        for (PS::S32 k=0; k<n_loop; k++) {
+            PS::F64 t0 = PS::GetWtime();
+            search_direct.searchPartner(list_direct, disp_direct, n_direct, ptcl.getPointer(), n);
+            PS::F64 t1 = PS::GetWtime();
+            search_grid.searchPartner(list_grid, disp_grid, n_grid, ptcl.getPointer(), n);
+            PS::F64 t2 = PS::GetWtime();
+            t_direct += t1 - t0;
+            t_grid += t2 - t1;
+        }
+        t_direct /= n_loop;
+        t_grid /= n_loop;
+
+        bool same_flag = isSameList(list_direct, list_grid) && isSameList(disp_direct, disp_grid) && isSameList(n_direct, n_grid);
+        if (!same_flag) fail_flag = true;
+
+        std::cout<<std::setw(width)<<n
+                 <<std::setw(width)<<r_in_n
+                 <<std::setw(width)<<list_direct.size()
+                 <<std::setw(width)<<t_direct
+                 <<std::setw(width)<<t_grid
+                 <<std::setw(width)<<(t_grid>0.0? t_direct/t_grid: 0.0)
+                 <<std::setw(width)<<(same_flag? "yes": "no")
+                 <<std::endl;
+    }
+
+    if (fail_flag) {
+        std::cerr<<"Error: partner lists from cell list differ from those of all-pair search!\n";
+        abort();
+    }
+
+    return 0;
+}
@@ -82,6 +82,11 @@ int main(int argc, char **argv){
         ptcl[i].id =  i + 1;
         ptcl[i].group_data.artificial.setParticleTypeToSingle();
         ptcl[i].changeover.setR(1.0, 0.001, 0.01);
+#ifdef KDKDK_4TH
+        // smooth acceleration field of Plummer potential for gradient correction test
+        PS::F64 r2p1 = pos[i]*pos[i] + 1.0;
+        ptcl[i].acc = -1.0/(r2p1*std::sqrt(r2p1)) * pos[i];
+#endif
     }    
 
     EPISoft epi[Nepi];
@@ -99,6 +104,12 @@ int main(int argc, char **argv){
     ForceSoft force_sp_simd[Nepi];
     ForceSoft force_nb_simd[Nepi];
 #endif
+#ifdef KDKDK_4TH
+    ForceSoft force_corr[Nepi];
+#ifdef USE_SIMD
+    ForceSoft force_corr_simd[Nepi];
+#endif
+#endif
 #ifdef USE_FUGAKU
     ForceSoft force_fgk[Nepi];
     ForceSoft force_sp_fgk[Nepi];
@@ -114,6 +125,12 @@ int main(int argc, char **argv){
         force_gpu[i].clear();
 #endif
         force_sp[i].clear();
+#ifdef KDKDK_4TH
+        force_corr[i].clear();
+#ifdef USE_SIMD
+        force_corr_simd[i].clear();
+#endif
+#endif
 #ifdef USE_SIMD
         force_simd[i].clear();
         force_sp_simd[i].clear();
@@ -176,6 +193,15 @@ int main(int argc, char **argv){
     f_ep_sp_simd(epi, Nepi, spj, Nspj, force_sp_simd);
     t_sp_simd += PS::GetWtime();
 
+#ifdef KDKDK_4TH
+    std::cout<<"calc Ep Ep correction simd\n";
+    CalcCorrectEpEpWithLinearCutoffSimd f_corr_simd;
+    PS::F64 t_corr_simd=0;
+    t_corr_simd -= PS::GetWtime();
+    f_corr_simd(epi, Nepi, epj, Nepj, force_corr_simd);
+    t_corr_simd += PS::GetWtime();
+#endif
+
     std::cout<<"neighbor search simd\n";
     SearchNeighborEpEpSimd f_nb_simd;
     PS::F64 t_nb_simd=0;
@@ -231,6 +257,25 @@ int main(int argc, char **argv){
     f_ep_sp(epi, Nepi, spj, Nspj, force_sp);
     t_sp_no += PS::GetWtime();
 
+#if defined(SOFT_LET_COMPRESS) && defined(USE_QUAD)
+    // compressed LET super particles compared with the full precision ones
+    std::cout<<"calc Ep Sp quad compressed\n";
+    SPJQuadrupoleInAndOutF32 spj_f32[Nspj];
+    ForceSoft force_sp_f32[Nepi];
+    for (int i=0; i<Nspj; i++) spj_f32[i].copyFromMoment(spj[i]);
+    for (int i=0; i<Nepi; i++) force_sp_f32[i].clear();
+    f_ep_sp(epi, Nepi, spj_f32, Nspj, force_sp_f32);
+#endif
+
+#ifdef KDKDK_4TH
+    std::cout<<"calc Ep Ep correction\n";
+    CalcCorrectEpEpWithLinearCutoffNoSimd f_corr;
+    PS::F64 t_corr_no=0;
+    t_corr_no -= PS::GetWtime();
+    f_corr(epi, Nepi, epj, Nepj, force_corr);
+    t_corr_no += PS::GetWtime();
+#endif
+
     std::cout<<"neighbor search\n";
     SearchNeighborEpEpNoSimd f_nb;
     PS::F64 t_nb=0;
@@ -247,6 +292,9 @@ int main(int argc, char **argv){
     PS::F64 dfmax_simd=0, dfpmax_simd=0;
     PS::F64 dsmax_simd=0, dspmax_simd=0;
     PS::F64 nbcount_ave_simd=0;
+#ifdef KDKDK_4TH
+    PS::F64 dcmax_simd=0;
+#endif
 #endif
 #ifdef USE_GPU
     PS::F64 dfmax_gpu=0, dfpmax_gpu=0;
@@ -256,10 +304,18 @@ int main(int argc, char **argv){
     PS::F64 dfmax_fgk=0,dfpmax_fgk=0;
     PS::F64 dsmax_fgk=0,dspmax_fgk=0;
     PS::F64 nbcount_ave_fgk=0;
+#endif
+#if defined(SOFT_LET_COMPRESS) && defined(USE_QUAD)
+    PS::F64 dsmax_f32=0, dspmax_f32=0;
 #endif
     PS::F64 df;
 
     for(int i=0; i<Nepi; i++) {
+#if defined(SOFT_LET_COMPRESS) && defined(USE_QUAD)
+        PS::F64vec dacc_f32 = force_sp[i].acc - force_sp_f32[i].acc;
+        dsmax_f32 = std::max(dsmax_f32, std::sqrt((dacc_f32*dacc_f32)/(force_sp[i].acc*force_sp[i].acc)));
+        dspmax_f32 = std::max(dspmax_f32, std::abs((force_sp[i].pot-force_sp_f32[i].pot)/force_sp[i].pot));
+#endif
         for (int j=0; j<3; j++) {
 #ifdef USE_SIMD
             df=(force[i].acc[j]-force_simd[i].acc[j])/force[i].acc[j];
@@ -295,6 +351,15 @@ int main(int argc, char **argv){
             std::cerr<<"NB search diff: i="<<i<<" nosimd "<<force[i].n_ngb<<" simd "<<force_nb_simd[i].n_ngb<<std::endl;
         }
         nbcount_ave_simd += force_simd[i].n_ngb;
+#ifdef KDKDK_4TH
+        // compare the vector difference to avoid large relative errors of components close to zero
+        PS::F64vec dacorr = force_corr[i].acorr - force_corr_simd[i].acorr;
+        df = std::sqrt((dacorr*dacorr)/(force_corr[i].acorr*force_corr[i].acorr));
+        dcmax_simd = std::max(dcmax_simd, df);
+        if(df>DF_MAX) std::cerr<<"Correction diff: i="<<i<<" nosimd "<<force_corr[i].acorr<<" simd "<<force_corr_simd[i].acorr<<std::endl;
+        if(force_corr_simd[i].acc[0]!=force_corr[i].acc[0]||force_corr_simd[i].acc[1]!=force_corr[i].acc[1]||force_corr_simd[i].acc[2]!=force_corr[i].acc[2]) 
+            std::cerr<<"Correction acc diff: i="<<i<<" nosimd "<<force_corr[i].acc<<" simd "<<force_corr_simd[i].acc<<std::endl;
+#endif
 #endif
 #ifdef USE_GPU
         dfpmax_gpu = std::max(dfpmax_gpu, (force_sp[i].pot+force[i].pot - force_gpu[i].pot)/force_gpu[i].pot);
@@ -369,6 +434,13 @@ int main(int argc, char **argv){
 #ifdef USE_SIMD    
     std::cout<<"SIMD EP-EP force diff max: "<<dfmax_simd<<" Pot diff max: "<<dfpmax_simd<<std::endl
              <<"SIMD EP-Sp force diff max: "<<dsmax_simd<<" Pot diff max: "<<dspmax_simd<<std::endl;
+#ifdef KDKDK_4TH
+    std::cout<<"SIMD EP-EP correction diff max: "<<dcmax_simd<<std::endl;
+#endif
+#endif
+#if defined(SOFT_LET_COMPRESS) && defined(USE_QUAD)
+    std::cout<<"Compressed EP-Sp force diff max: "<<dsmax_f32<<" Pot diff max: "<<dspmax_f32<<std::endl;
+    if(dsmax_f32>DF_MAX||dspmax_f32>DF_MAX) std::cerr<<"Compressed super particle force diff is larger than "<<DF_MAX<<std::endl;
 #endif
 #ifdef USE_GPU
     std::cout<<"GPU EP+SP force diff max: "<<dfmax_gpu<<" Pot diff max: "<<dfpmax_gpu<<std::endl;
@@ -396,6 +468,9 @@ int main(int argc, char **argv){
 #ifdef USE_SIMD
     std::cout<<"Time: epj  simd="<<t_ep_simd<<" no="<<t_ep_no<<" ratio="<<t_ep_no/t_ep_simd<<std::endl;
     std::cout<<"Time: spj  simd="<<t_sp_simd<<" no="<<t_sp_no<<" ratio="<<t_sp_no/t_sp_simd<<std::endl;
+#ifdef KDKDK_4TH
+    std::cout<<"Time: corr simd="<<t_corr_simd<<" no="<<t_corr_no<<" ratio="<<t_corr_no/t_corr_simd<<std::endl;
+#endif
 #endif
 #ifdef USE_GPU
     std::cout<<"Time: gpu ="<<t_gpu<<" no="<<t_ep_no+t_sp_no<<" ratio="<<(t_ep_no+t_sp_no)/t_gpu<<std::endl;
@@ -6,12 +6,28 @@
 #include"phantomquad_for_p3t_x86.hpp"
 #endif
 
+//! reference position of relative coordinates in SIMD soft force kernels
+/*! With SOFT_MIXED_PRECISION, the positions are shifted by EPISoft::pos_ref (center of local particles) in double precision before they are rounded to single precision,
+    thus the rounding error is relative to the size of the local domain instead of the distance to the origin.
+    The changeover corrections in SystemHard round i and j positions relative to the same reference, so the linear cutoff force is subtracted exactly.
+    It only improves the accuracy of the single precision SIMD kernels far from the origin, the kernels without SIMD are in double precision and do not use it.
+    Otherwise zero is returned and the SIMD kernels use absolute coordinates.
+ */
+inline PS::F64vec getSoftKernelPosRef() {
+#ifdef SOFT_MIXED_PRECISION
+    return EPISoft::pos_ref;
+#else
+    return PS::F64vec(0.0);
+#endif
+}
 
-// Neighbor search function
+
+// Neighbor search function, j particles can be EPJSoft or EPJNB
 struct SearchNeighborEpEpNoSimd{
+    template <class Tepj>
     void operator () (const EPISoft * ep_i,
                       const PS::S32 n_ip,
-                      const EPJSoft * ep_j,
+                      const Tepj * ep_j,
                       const PS::S32 n_jp,
                       ForceSoft * force){
         for(PS::S32 i=0; i<n_ip; i++){
@@ -176,7 +192,7 @@ struct CalcForceEpSpQuadNoSimd{
                 PS::F64vec xj= sp_j[jp].pos;
                 PS::F64vec rij= xi - xj;
                 PS::F64 r2 = rij * rij + eps2;
-                PS::F64mat qj = sp_j[jp].quad;
+                const auto& qj = sp_j[jp].quad;
                 PS::F64 tr = qj.getTrace();
                 PS::F64vec qr( (qj.xx*rij.x + qj.xy*rij.y + qj.xz*rij.z),
                                (qj.yy*rij.y + qj.yz*rij.z + qj.xy*rij.x),
@@ -237,9 +253,10 @@ struct CalcForcePPNoSimd {
 
 #ifdef USE_SIMD
 struct SearchNeighborEpEpSimd{
+    template <class Tepj>
     void operator () (const EPISoft * ep_i,
                       const PS::S32 n_ip,
-                      const EPJSoft * ep_j,
+                      const Tepj * ep_j,
                       const PS::S32 n_jp,
                       ForceSoft * force){
     #ifdef __HPC_ACE__
@@ -256,8 +273,9 @@ struct SearchNeighborEpEpSimd{
         }
         assert(n_ip<=pg.NIMAX);
         assert(n_jp<=pg.NJMAX);
+        const PS::F64vec pos_ref = getSoftKernelPosRef();
         for(PS::S32 i=0; i<n_ip; i++){
-            const PS::F64vec pos_i = ep_i[i].getPos();
+            const PS::F64vec pos_i = ep_i[i].getPos() - pos_ref;
             pg.set_xi_one(i, pos_i.x, pos_i.y, pos_i.z, ep_i[i].r_search);
         }
         PS::S32 loop_max = (n_jp-1) / PhantomGrapeQuad::NJMAX + 1;
@@ -268,7 +286,7 @@ struct SearchNeighborEpEpSimd{
             PS::S32 i_tmp = 0;
             for(PS::S32 i=ih; i<it; i++, i_tmp++){
                 const PS::F64 m_j = ep_j[i].getCharge();
-                const PS::F64vec pos_j = ep_j[i].getPos();
+                const PS::F64vec pos_j = ep_j[i].getPos() - pos_ref;
                 pg.set_epj_one(i_tmp, pos_j.x, pos_j.y, pos_j.z, m_j, ep_j[i].r_search);
 
             }
@@ -378,11 +396,12 @@ struct CalcForceEpEpWithLinearCutoffSimd{
         assert(n_jp<=pg.NJMAX);
         pg.set_eps2(eps2);
         pg.set_r_crit2(EPISoft::r_out*EPISoft::r_out);
+        const PS::F64vec pos_ref = getSoftKernelPosRef();
         for(PS::S32 i=0; i<n_ip; i++){
             // remove the orbital sample for the force calculation
             if (ep_i[i].type==1) {
                 ep_i_list[n_ip_local] = i;
-                const PS::F64vec pos_i = ep_i[i].getPos();
+                const PS::F64vec pos_i = ep_i[i].getPos() - pos_ref;
                 pg.set_xi_one(n_ip_local, pos_i.x, pos_i.y, pos_i.z, ep_i[i].r_search);
                 n_ip_local++;
             }
@@ -397,7 +416,7 @@ struct CalcForceEpEpWithLinearCutoffSimd{
             for(PS::S32 i=ih; i<it; i++, i_tmp++){
                 const PS::S32 ij = ep_j_list[i];
                 const PS::F64 m_j = ep_j[ij].getCharge();
-                const PS::F64vec pos_j = ep_j[ij].getPos();
+                const PS::F64vec pos_j = ep_j[ij].getPos() - pos_ref;
                 pg.set_epj_one(i_tmp, pos_j.x, pos_j.y, pos_j.z, m_j, ep_j[ij].r_search);
 
             }
@@ -424,6 +443,67 @@ struct CalcForceEpEpWithLinearCutoffSimd{
     }
 };
 
+#ifdef KDKDK_4TH
+//! gradient correction kernel for EP EP (KDKDK_4TH)
+/*! Same as CalcCorrectEpEpWithLinearCutoffNoSimd. Single precision is always used since the correction is scaled by dt^2 in the kick.
+    Accelerations are rounded without a reference, the same as the changeover correction in SystemHard, so the linear cutoff term cancels exactly.
+ */
+struct CalcCorrectEpEpWithLinearCutoffSimd{
+    void operator () (const EPISoft * ep_i,
+                      const PS::S32 n_ip,
+                      const EPJSoft * ep_j,
+                      const PS::S32 n_jp,
+                      ForceSoft * force){
+        const PS::F64 eps2 = EPISoft::eps * EPISoft::eps;
+        PS::S32 ep_j_list[n_jp], n_jp_local=0;
+        for (PS::S32 i=0; i<n_jp; i++){
+            if(ep_j[i].mass>0) ep_j_list[n_jp_local++] = i;
+        }
+        static thread_local PhantomGrapeQuad pg;
+        assert(n_ip<=pg.NIMAX);
+        assert(n_jp<=pg.NJMAX);
+        pg.set_eps2(eps2);
+        pg.set_r_crit2(EPISoft::r_out*EPISoft::r_out);
+
+        const PS::F64vec pos_ref = getSoftKernelPosRef();
+        for(PS::S32 i=0; i<n_ip; i++){
+            const PS::F64vec pos_i = ep_i[i].getPos() - pos_ref;
+            const PS::F64vec acc_i = ep_i[i].acc;
+            pg.set_xi_one(i, pos_i.x, pos_i.y, pos_i.z, ep_i[i].r_search);
+            pg.set_xi_acc_one(i, acc_i.x, acc_i.y, acc_i.z);
+        }
+        PS::S32 loop_max = (n_jp_local-1) / PhantomGrapeQuad::NJMAX + 1;
+        for(PS::S32 loop=0; loop<loop_max; loop++){
+            const PS::S32 ih = PhantomGrapeQuad::NJMAX*loop;
+            const PS::S32 n_jp_tmp = ( (n_jp_local - ih) < PhantomGrapeQuad::NJMAX) ? (n_jp_local - ih) : PhantomGrapeQuad::NJMAX;
+            const PS::S32 it =ih + n_jp_tmp;
+            PS::S32 i_tmp = 0;
+            for(PS::S32 i=ih; i<it; i++, i_tmp++){
+                const PS::S32 ij = ep_j_list[i];
+                const PS::F64vec pos_j = ep_j[ij].getPos() - pos_ref;
+                const PS::F64vec acc_j = ep_j[ij].acc;
+                pg.set_epj_one(i_tmp, pos_j.x, pos_j.y, pos_j.z, ep_j[ij].mass, ep_j[ij].r_search);
+                pg.set_epj_acc_one(i_tmp, acc_j.x, acc_j.y, acc_j.z);
+            }
+            pg.run_epj_for_correction_with_linear_cutoff(n_ip, n_jp_tmp);
+            for(PS::S32 i=0; i<n_ip; i++){
+                PS::F64 ac[3]= {0,0,0};
+                pg.accum_acorr_one(i, ac[0], ac[1], ac[2]);
+#ifdef NAN_CHECK_DEBUG
+                assert(!std::isnan(ac[0]));
+                assert(!std::isnan(ac[1]));
+                assert(!std::isnan(ac[2]));
+#endif
+                force[i].acorr[0] += 2.0*ac[0];
+                force[i].acorr[1] += 2.0*ac[1];
+                force[i].acorr[2] += 2.0*ac[2];
+            }
+        }
+        for(PS::S32 i=0; i<n_ip; i++) force[i].acc = ep_i[i].acc;
+    }
+};
+#endif
+
 struct CalcForceEpSpMonoSimd{
     template<class Tsp>
     void operator () (const EPISoft * ep_i,
@@ -447,11 +527,12 @@ struct CalcForceEpSpMonoSimd{
         assert(n_ip<=pg.NIMAX);
         assert(n_jp<=pg.NJMAX);
         pg.set_eps2(eps2);
+        const PS::F64vec pos_ref = getSoftKernelPosRef();
         for(PS::S32 i=0; i<n_ip; i++){
             // remove the orbital sample for the force calculation
             if (ep_i[i].type==1) {
                 ep_i_list[n_ip_local] = i;
-                const PS::F64vec pos_i = ep_i[i].getPos();
+                const PS::F64vec pos_i = ep_i[i].getPos() - pos_ref;
                 pg.set_xi_one(n_ip_local, pos_i.x, pos_i.y, pos_i.z, 0.0);
                 n_ip_local++;
             }                
@@ -464,7 +545,7 @@ struct CalcForceEpSpMonoSimd{
             PS::S32 i_tmp = 0;
             for(PS::S32 i=ih; i<it; i++, i_tmp++){
                 const PS::F64 m_j = sp_j[i].getCharge();
-                const PS::F64vec pos_j = sp_j[i].getPos();
+                const PS::F64vec pos_j = sp_j[i].getPos() - pos_ref;
                 pg.set_epj_one(i_tmp, pos_j.x, pos_j.y, pos_j.z, m_j, 0.0);
             }
             pg.run_epj(n_ip, n_jp_tmp);
@@ -510,11 +591,12 @@ struct CalcForceEpSpQuadSimd{
         assert(n_ip<=pg.NIMAX);
         assert(n_jp<=pg.NJMAX);
         pg.set_eps2(eps2);
+        const PS::F64vec pos_ref = getSoftKernelPosRef();
         for(PS::S32 i=0; i<n_ip; i++){
             // remove the orbital sample for the force calculation
             if (ep_i[i].type==1) {
                 ep_i_list[n_ip_local] = i;
-                const PS::F64vec pos_i = ep_i[i].getPos();
+                const PS::F64vec pos_i = ep_i[i].getPos() - pos_ref;
                 pg.set_xi_one(n_ip_local, pos_i.x, pos_i.y, pos_i.z, 0.0);
                 n_ip_local++;
             }                
@@ -527,8 +609,8 @@ struct CalcForceEpSpQuadSimd{
             PS::S32 i_tmp = 0;
             for(PS::S32 i=ih; i<it; i++, i_tmp++){
                 const PS::F64 m_j = sp_j[i].getCharge();
-                const PS::F64vec pos_j = sp_j[i].getPos();
-                const PS::F64mat q = sp_j[i].quad;
+                const PS::F64vec pos_j = sp_j[i].getPos() - pos_ref;
+                const auto& q = sp_j[i].quad;
                 pg.set_spj_one(i, pos_j.x, pos_j.y, pos_j.z, m_j,
                                q.xx, q.yy, q.zz, q.xy, q.yz, q.xz);
             }
@@ -16,6 +16,9 @@ public:
     void clear(){
         acc = 0.0;
         pot = 0.0;
+#ifdef KDKDK_4TH
+        acorr = 0.0;
+#endif
         n_ngb = 0;
 #ifdef SAVE_NEIGHBOR_ID_IN_FORCE_KERNEL
         id_ngb[0] = id_ngb[1] = id_ngb[2] = id_ngb[3] = 0;
@@ -280,6 +283,9 @@ public:
 #endif
     static PS::F64 eps;
     static PS::F64 r_out;
+#ifdef SOFT_MIXED_PRECISION
+    static PS::F64vec pos_ref; // reference position of relative coordinates in SIMD kernels and changeover corrections
+#endif
     PS::F64vec getPos() const { return pos;}
     void copyFromFP(const FPSoft & fp){ 
         id = fp.id;
@@ -308,12 +314,16 @@ public:
 };
 
 
+//! j particle of the soft force tree
+/*! Used by the force kernels (mass, pos; acc for KDKDK_4TH) and by the changeover force corrections with tree neighbor lists
+    (id, changeover radii, r_scale_next, group_data and r_search for the symmetric search).
+    The neighbor search tree for clusters uses EPJNB instead, thus velocity and rank are not carried in the LET of the force tree.
+ */
 class EPJSoft{
 public:
     PS::S64 id;
     PS::F64 mass;
     PS::F64vec pos;
-    PS::F64vec vel;
 #ifdef KDKDK_4TH
     PS::F64vec acc;
 #endif
@@ -322,8 +332,6 @@ public:
     PS::F64 r_search;
     PS::F64 r_scale_next;
     GroupDataDeliver group_data;
-    PS::S32 rank_org;
-    PS::S32 adr_org;
 //    static PS::F64 r_out;
 //    static PS::F64 m_average;
 //    static PS::F64 r_search_min;
@@ -331,7 +339,6 @@ public:
         id = fp.id;
         mass = fp.mass;
         pos = fp.pos;
-        vel = fp.vel;
 #ifdef KDKDK_4TH
         acc = fp.acc;
 #endif
@@ -340,8 +347,6 @@ public:
         r_scale_next = fp.changeover.r_scale_next;
         r_search = fp.r_search;
         group_data = fp.group_data;
-        rank_org = fp.rank_org;
-        adr_org = fp.adr;
     }
     PS::F64vec getPos() const { return pos; }
     void setPos(const PS::F64vec & pos_new){ pos = pos_new;}
@@ -356,6 +361,58 @@ public:
         return id;
     }
 
+    // FORDEBUG
+    void print(std::ostream & fout=std::cout) const {
+        fout<<" id="<<id
+            <<" mass="<<mass
+            <<" pos="<<pos
+            <<" r_search="<<r_search;
+    }
+    void clear(){
+        mass = 0.0;
+        pos = 0.0;
+        r_in = r_out = 0.0;
+        r_search = 0.0;
+        r_scale_next = 1.0;
+        id = -1;
+    }
+};
+
+//! j particle of the neighbor search tree for clusters
+/*! Carries what the cluster search reads from neighbors: id, rank for remote neighbors, and
+    mass, velocity, outer changeover radius and group_data (c.m. mass and velocity of members) for the velocity criterion.
+ */
+class EPJNB{
+public:
+    PS::S64 id;
+    PS::F64 mass;
+    PS::F64vec pos;
+    PS::F64vec vel;
+    PS::F64 r_out;
+    PS::F64 r_search;
+    GroupDataDeliver group_data;
+    PS::S32 rank_org;
+    void copyFromFP(const FPSoft & fp){
+        id = fp.id;
+        mass = fp.mass;
+        pos = fp.pos;
+        vel = fp.vel;
+        r_out = fp.changeover.getRout();
+        r_search = fp.r_search;
+        group_data = fp.group_data;
+        rank_org = fp.rank_org;
+    }
+    PS::F64vec getPos() const { return pos; }
+    void setPos(const PS::F64vec & pos_new){ pos = pos_new;}
+    PS::F64 getCharge() const { return mass; }
+    PS::F64 getRSearch() const {
+        return r_search*SAFTY_FACTOR_FOR_SEARCH;
+    }
+
+    PS::S64 getId() const {
+        return id;
+    }
+
     // FORDEBUG
     void print(std::ostream & fout=std::cout) const {
         fout<<" id="<<id
@@ -368,10 +425,65 @@ public:
     void clear(){
         mass = 0.0;
         pos = vel = 0.0;
-        r_in = r_out = 0.0;
+        r_out = 0.0;
         r_search = 0.0;
-        r_scale_next = 1.0;
-        id = rank_org = adr_org = -1;
+        id = rank_org = -1;
     }
 };
 
+
+#ifdef SOFT_LET_COMPRESS
+//! quadrupole super particle with single precision mass and quadrupole for a compressed LET exchange
+/*! The super particles of the soft force tree are the major part of the LET sent to distant ranks.
+    The mass and quadrupole moment are stored in single precision, this saves 28 of the 80 bytes of PS::SPJQuadrupoleInAndOut,
+    but with the alignment of the double precision position the size is 56 bytes, i.e. 24 bytes (30%) less per super particle.
+    The total LET volume decreases less since EPJSoft is not compressed, the LET_MByte column of the profile shows the sent volume.
+    The relative rounding error of 2^-24 is far below the truncation error of the quadrupole expansion (~theta^3) for theta > 0.01,
+    and the default (not P3T_64BIT) SIMD kernel rounds super particles to single precision anyway.
+    The position is kept in double precision, because FDPS does not send the cell geometry to quantize it relative to the sending cell and 
+    absolute single precision positions lose accuracy for a system far from the origin.
+    The EPJSoft is not compressed since the changeover corrections need the exact neighbor positions and masses.
+ */
+class SPJQuadrupoleInAndOutF32{
+public:
+    PS::F64vec pos;
+    PS::F32 mass;
+    PS::F32mat quad;
+
+    template<class Tmom>
+    void copyFromMoment(const Tmom & mom){
+        mass = mom.mass;
+        pos = mom.pos;
+        quad.xx = mom.quad.xx;
+        quad.yy = mom.quad.yy;
+        quad.zz = mom.quad.zz;
+        quad.xy = mom.quad.xy;
+        quad.xz = mom.quad.xz;
+        quad.yz = mom.quad.yz;
+    }
+
+    //! convert to moment, only mass, pos and quad are set, the same as the copyFromMoment access
+    PS::MomentQuadrupoleInAndOut convertToMoment() const {
+        PS::MomentQuadrupoleInAndOut mom;
+        mom.mass = mass;
+        mom.pos = pos;
+        mom.quad.xx = quad.xx;
+        mom.quad.yy = quad.yy;
+        mom.quad.zz = quad.zz;
+        mom.quad.xy = quad.xy;
+        mom.quad.xz = quad.xz;
+        mom.quad.yz = quad.yz;
+        return mom;
+    }
+
+    PS::F64vec getPos() const { return pos; }
+    void setPos(const PS::F64vec & pos_new){ pos = pos_new;}
+    PS::F64 getCharge() const { return mass; }
+
+    void clear(){
+        mass = 0.0;
+        pos = 0.0;
+        quad = 0.0;
+    }
+};
+#endif
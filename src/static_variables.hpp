@@ -1,4 +1,6 @@
 #pragma once
+#include "trace.hpp"
+#include "perf_counter.hpp"
 
 PS::F64 Ptcl::r_search_min = 0.0;
 PS::F64 Ptcl::search_factor= 0.0;
@@ -8,5 +10,9 @@ PS::F64 Ptcl::r_group_crit_ratio =0.0;
 GroupDataMode Ptcl::group_data_mode = GroupDataMode::none;
 PS::F64 EPISoft::eps = 0.0;
 PS::F64 EPISoft::r_out = 0.0;
+#ifdef SOFT_MIXED_PRECISION
+PS::F64vec EPISoft::pos_ref = PS::F64vec(0.0);
+#endif
 PS::F64 ForceSoft::grav_const = 1.0;
-
+TraceLog trace_log;
+PerfCounter perf_counter;
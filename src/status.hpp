@@ -2,6 +2,7 @@
 
 #include "particle_base.hpp"
 #include "energy.hpp"
+#include "global_reduction.hpp"
 
 //! class for measure the status of the system
 class Status {
@@ -145,6 +146,7 @@ public:
 #ifdef SMOOTH_CM_USING_VEL_PRED
         PS::F64vec acc_cm = PS::F64vec(0.0);
 #endif
+        PS::F64 weight = 0.0; // normalization factor: 1: mass; 2: particle number; 3: total soft potential
 
         if (_mode==1) { // center of the mass
 //#pragma omp declare reduction(+:PS::F64vec:omp_out += omp_in) initializer (omp_priv=PS::F64vec(0.0))
@@ -164,29 +166,7 @@ public:
                 acc_cm += mi*pi.acc;
 #endif
             }        
-
-#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
-            pcm.mass = PS::Comm::getSum(mass);
-            pcm.pos  = PS::Comm::getSum(pos_cm);
-            pcm.vel  = PS::Comm::getSum(vel_cm);
-#ifdef SMOOTH_CM_USING_VEL_PRED
-            pcm.acc  = PS::Comm::getSum(acc_cm);
-#endif
-#else
-            pcm.mass = mass;
-            pcm.pos  = pos_cm;
-            pcm.vel  = vel_cm;
-#ifdef SMOOTH_CM_USING_VEL_PRED
-            pcm.acc  = acc_cm;
-#endif
-#endif
-            if (pcm.mass>0) {
-                pcm.pos /= pcm.mass;
-                pcm.vel /= pcm.mass;
-#ifdef SMOOTH_CM_USING_VEL_PRED
-                pcm.acc /= pcm.mass;
-#endif
-            }
+            weight = mass;
         }
         else if (_mode==2) { // no mass weighted center
 //#pragma omp declare reduction(+:PS::F64vec:omp_out += omp_in) initializer (omp_priv=PS::F64vec(0.0))
@@ -206,34 +186,9 @@ public:
                 acc_cm += pi.acc;
 #endif
             }        
-
-#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
-            pcm.mass = PS::Comm::getSum(mass);
-            pcm.pos  = PS::Comm::getSum(pos_cm);
-            pcm.vel  = PS::Comm::getSum(vel_cm);
-#ifdef SMOOTH_CM_USING_VEL_PRED
-            pcm.acc  = PS::Comm::getSum(acc_cm);
-#endif
-            PS::S64 n_glb = PS::Comm::getSum(_n);
-#else
-            pcm.mass = mass;
-            pcm.pos  = pos_cm;
-            pcm.vel  = vel_cm;
-#ifdef SMOOTH_CM_USING_VEL_PRED
-            pcm.acc  = acc_cm;
-#endif
-            PS::S64 n_glb = _n;
-#endif
-            if (n_glb>0) {
-                pcm.pos /= PS::F64(n_glb);
-                pcm.vel /= PS::F64(n_glb);
-#ifdef SMOOTH_CM_USING_VEL_PRED
-                pcm.acc /= PS::F64(n_glb);
-#endif
-            }
+            weight = PS::F64(_n);
         }
         else if (_mode==3) { // soft potential
-            PS::F64 pot_tot = 0.0;
             for (int i=0; i<_n; i++) {
                 auto& pi = _tsys[i];
                 PS::F64 mi = pi.mass;
@@ -252,33 +207,34 @@ public:
 #ifdef SMOOTH_CM_USING_VEL_PRED
                 acc_cm += poti*pi.acc;
 #endif
-                pot_tot += poti;
+                weight += poti;
             }        
+        }
 
-#ifdef PARTICLE_SIMULATOR_MPI_PARALLEL
-            pcm.mass = PS::Comm::getSum(mass);
-            pcm.pos  = PS::Comm::getSum(pos_cm);
-            pcm.vel  = PS::Comm::getSum(vel_cm);
+        // all summations are done in one collective
+        GlobalReduction reduction;
+        const PS::S32 i_mass   = reduction.add(mass);
+        const PS::S32 i_weight = reduction.add(weight);
+        const PS::S32 i_pos    = reduction.add(pos_cm);
+        const PS::S32 i_vel    = reduction.add(vel_cm);
 #ifdef SMOOTH_CM_USING_VEL_PRED
-            pcm.acc  = PS::Comm::getSum(acc_cm);
+        const PS::S32 i_acc    = reduction.add(acc_cm);
 #endif
-            PS::F64 pot_tot_glb = PS::Comm::getSum(pot_tot);
-#else
-            pcm.mass = mass;
-            pcm.pos  = pos_cm;
-            pcm.vel  = vel_cm;
+        reduction.reduce();
+
+        pcm.mass = reduction.getSum(i_mass);
+        pcm.pos  = reduction.getSumVec(i_pos);
+        pcm.vel  = reduction.getSumVec(i_vel);
 #ifdef SMOOTH_CM_USING_VEL_PRED
-            pcm.acc  = acc_cm;
-#endif
-            PS::F64 pot_tot_glb = pot_tot;
+        pcm.acc  = reduction.getSumVec(i_acc);
 #endif
-            if (pot_tot_glb!=0) {
-                pcm.pos /= pot_tot_glb;
-                pcm.vel /= pot_tot_glb;
+        PS::F64 weight_glb = reduction.getSum(i_weight);
+        if ((_mode==3 && weight_glb!=0) || (_mode!=3 && weight_glb>0)) {
+            pcm.pos /= weight_glb;
+            pcm.vel /= weight_glb;
 #ifdef SMOOTH_CM_USING_VEL_PRED
-                pcm.acc /= pot_tot_glb;
+            pcm.acc /= weight_glb;
 #endif
-            }
         }
     }
 
@@ -0,0 +1,192 @@
+#pragma once
+#include <particle_simulator.hpp>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cassert>
+#include <cstring>
+#include <cstdlib>
+
+//! one span of the timeline trace
+struct TraceEvent{
+    const char* name;  // name of the span, must be a static string
+    PS::F64 t_start;   // wall time of start
+    PS::F64 t_end;     // wall time of end
+    const char* arg_name[2]; // names of optional arguments, NULL: unused
+    PS::S64 arg[2];    // optional arguments (e.g. number of particles and groups in a hard cluster)
+};
+
+//! span counter of one thread, padded to a cache line to avoid false sharing between threads
+struct TraceEventCounter{
+    PS::S64 n;
+    char pad[64-sizeof(PS::S64)];
+};
+
+//! timeline trace of phases, hard clusters and collectives for each MPI rank and OpenMP thread
+/*! Each thread appends spans to its own preallocated ring buffer without locks; if the buffer is full, the oldest spans are overwritten.
+    flush() writes the buffers of all threads to the file [prefix].trace.[MPI rank] in the Chrome trace-event (JSON array) format
+    and must be called outside parallel regions. The array is not closed so that the file can be appended;
+    tools/trace_merge.py merges the files of all ranks to one JSON file for chrome://tracing or Perfetto.
+    The process ID is the MPI rank and the thread ID is the OpenMP thread index.
+    Timestamps are relative to the barrier in initial(). When the file is appended (e.g. after restart),
+    the timestamps are shifted after the last span already in the files of all ranks, thus the timeline continues.
+    When the trace is not initialized, the cost of a span is one branch.
+ */
+class TraceLog{
+private:
+    std::vector<std::vector<TraceEvent>> buffer_; // ring buffer of each thread
+    std::vector<TraceEventCounter> n_event_;  // number of spans added by each thread since last flush
+    std::ofstream fout_;
+    PS::F64 time_origin_;
+    PS::F64 ts_offset_; // timestamp offset [us] of appended spans
+    PS::S32 rank_;
+    bool active_flag_;
+
+    void writeName(const char* _name) {
+        // profile names are padded with spaces
+        std::string name(_name);
+        name.erase(name.find_last_not_of(' ')+1);
+        fout_<<"\"name\":\""<<name<<"\"";
+    }
+
+    //! find the end of the last span in an existing trace file
+    /*! @param[in] _fname: trace file name
+        \return the maximum ts+dur [us], 0 if the file does not exist
+     */
+    static PS::F64 readLastTime(const std::string& _fname) {
+        std::ifstream fin(_fname.c_str());
+        PS::F64 t_last = 0.0;
+        std::string line;
+        while (std::getline(fin, line)) {
+            const char* ts = std::strstr(line.c_str(), "\"ts\":");
+            if (ts==NULL) continue;
+            PS::F64 t = std::atof(ts+5);
+            const char* dur = std::strstr(line.c_str(), "\"dur\":");
+            if (dur!=NULL) t += std::atof(dur+6);
+            t_last = std::max(t_last, t);
+        }
+        return t_last;
+    }
+
+    //! timestamp in the file [us]
+    PS::F64 getTimeStamp(const PS::F64 _t) const {
+        return (_t-time_origin_)*1e6 + ts_offset_;
+    }
+
+public:
+    TraceLog(): buffer_(), n_event_(), fout_(), time_origin_(0.0), ts_offset_(0.0), rank_(0), active_flag_(false) {}
+
+    //! initialization, the barrier aligns the time origins of all ranks
+    /*! @param[in] _fname_prefix: prefix of trace file
+      @param[in] _n_thread: number of OpenMP threads
+      @param[in] _n_buffer: ring buffer size (number of spans) of each thread
+      @param[in] _rank: MPI rank
+      @param[in] _append_flag: append to existing file
+     */
+    void initial(const std::string& _fname_prefix, const PS::S32 _n_thread, const PS::S64 _n_buffer, const PS::S32 _rank, const bool _append_flag) {
+        assert(_n_buffer>0);
+        rank_ = _rank;
+        buffer_.resize(_n_thread);
+        n_event_.resize(_n_thread);
+        for (PS::S32 i=0; i<_n_thread; i++) {
+            buffer_[i].resize(_n_buffer);
+            n_event_[i].n = 0;
+        }
+        std::string fname = _fname_prefix + ".trace." + std::to_string(rank_);
+        // continue after the last span of all ranks
+        ts_offset_ = 0.0;
+        if (_append_flag) ts_offset_ = PS::Comm::getMaxValue(readLastTime(fname));
+        if (_append_flag) fout_.open(fname.c_str(), std::ofstream::out|std::ofstream::app);
+        else fout_.open(fname.c_str(), std::ofstream::out);
+        fout_<<std::fixed<<std::setprecision(3);
+        if (!_append_flag) {
+            fout_<<"[\n";
+            fout_<<"{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":"<<rank_<<",\"args\":{\"name\":\"rank "<<rank_<<"\"}},\n";
+            for (PS::S32 i=0; i<_n_thread; i++)
+                fout_<<"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":"<<rank_<<",\"tid\":"<<i<<",\"args\":{\"name\":\"thread "<<i<<"\"}},\n";
+        }
+        PS::Comm::barrier();
+        time_origin_ = PS::GetWtime();
+        active_flag_ = true;
+    }
+
+    //! whether tracing is switched on
+    bool isActive() const {
+        return active_flag_;
+    }
+
+    //! add a span to the buffer of the current thread
+    /*! @param[in] _name: static name string
+      @param[in] _t_start: start wall time
+      @param[in] _t_end: end wall time
+      @param[in] _arg_name0: static name string of the first argument (NULL: unused)
+      @param[in] _arg0: first argument
+      @param[in] _arg_name1: static name string of the second argument (NULL: unused)
+      @param[in] _arg1: second argument
+     */
+    void add(const char* _name, const PS::F64 _t_start, const PS::F64 _t_end,
+             const char* _arg_name0=NULL, const PS::S64 _arg0=0, const char* _arg_name1=NULL, const PS::S64 _arg1=0) {
+        const PS::S32 ith = PS::Comm::getThreadNum();
+        auto& buffer = buffer_[ith];
+        PS::S64& n_event = n_event_[ith].n;
+        TraceEvent& event = buffer[n_event%buffer.size()];
+        event.name = _name;
+        event.t_start = _t_start;
+        event.t_end = _t_end;
+        event.arg_name[0] = _arg_name0;
+        event.arg_name[1] = _arg_name1;
+        event.arg[0] = _arg0;
+        event.arg[1] = _arg1;
+        n_event++;
+    }
+
+    //! write spans of all threads to the file and clear buffers
+    void flush() {
+        if (!active_flag_) return;
+        for (PS::S32 i=0; i<(PS::S32)buffer_.size(); i++) {
+            auto& buffer = buffer_[i];
+            PS::S64& n_event = n_event_[i].n;
+            const PS::S64 n_buffer = buffer.size();
+            const PS::S64 n_keep = std::min(n_event, n_buffer);
+            // spans overwritten in the ring buffer
+            if (n_event>n_keep) {
+                const TraceEvent& first = buffer[(n_event-n_keep)%n_buffer];
+                fout_<<"{\"name\":\"Dropped\",\"ph\":\"i\",\"s\":\"t\",\"pid\":"<<rank_<<",\"tid\":"<<i
+                     <<",\"ts\":"<<getTimeStamp(first.t_start)
+                     <<",\"args\":{\"n\":"<<n_event-n_keep<<"}},\n";
+            }
+            for (PS::S64 k=n_event-n_keep; k<n_event; k++) {
+                const TraceEvent& event = buffer[k%n_buffer];
+                fout_<<"{";
+                writeName(event.name);
+                fout_<<",\"ph\":\"X\",\"pid\":"<<rank_<<",\"tid\":"<<i
+                     <<",\"ts\":"<<getTimeStamp(event.t_start)
+                     <<",\"dur\":"<<(event.t_end-event.t_start)*1e6;
+                if (event.arg_name[0]!=NULL) {
+                    fout_<<",\"args\":{\""<<event.arg_name[0]<<"\":"<<event.arg[0];
+                    if (event.arg_name[1]!=NULL) fout_<<",\""<<event.arg_name[1]<<"\":"<<event.arg[1];
+                    fout_<<"}";
+                }
+                fout_<<"},\n";
+            }
+            n_event = 0;
+        }
+        fout_.flush();
+    }
+
+    //! flush and close the file
+    void close() {
+        flush();
+        if (fout_.is_open()) fout_.close();
+        active_flag_ = false;
+    }
+
+    ~TraceLog() {
+        active_flag_ = false;
+        if (fout_.is_open()) fout_.close();
+    }
+};
+
+// global trace, defined in static_variables.hpp
+extern TraceLog trace_log;
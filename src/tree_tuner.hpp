@@ -0,0 +1,250 @@
+#pragma once
+#include <particle_simulator.hpp>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <cassert>
+
+//! online tuning of the leaf and group limits of the particle trees
+/*! The tree wall time per step depends on n_leaf_limit and n_group_limit, and the best values change with N, clustering and hardware.
+    At the beginning of a run (also after a restart), candidates around the current values are measured one after another for a few tree steps each
+    (cross search: halve or double one of the two limits). The candidate with the smallest tree time per step becomes the new center
+    and the search is repeated until the center is the best or the round limit is reached.
+    In the adaptive mode, the tree time per step is monitored afterwards; when it becomes larger than the time of the chosen candidate by a fraction
+    of drift_limit_, a new search around the current values starts.
+    The first step of each candidate is not measured, since the trees are rebuilt and reallocated in that step.
+    The time per step of a candidate is the maximum among MPI ranks, thus all ranks make the same choices.
+    The opening angle theta is not changed: a larger theta is always faster, so the input value is kept as the accuracy bound.
+ */
+class TreeParameterTuner{
+private:
+    //! tree parameter candidate
+    struct Candidate{
+        PS::S64 n_leaf_limit;
+        PS::S64 n_group_limit;
+        PS::F64 time;   // accumulated tree time, maximum time per step among ranks after measurement
+        PS::S32 n_step; // number of measured steps
+    };
+
+    std::vector<Candidate> candidate_;
+    PS::S32 i_candidate_;   // current candidate index
+    PS::S32 i_round_;       // current search round
+    PS::S32 n_skip_;        // number of skipped steps of current candidate
+    bool explore_flag_;     // whether candidates are being measured
+
+    PS::S32 mode_;          // 0: off; 1: search at the beginning; 2: also search again when the tree time drifts
+    PS::S32 n_step_measure_;// number of measured steps per candidate
+    PS::S64 n_leaf_limit_;  // current leaf limit
+    PS::S64 n_group_limit_; // current group limit
+
+    PS::F64 time_last_;     // cumulative tree time at the last update
+    bool time_valid_;       // whether the time difference to the last update is one tree step
+    PS::F64 time_best_;     // tree time per step of the chosen candidate
+    PS::F64 time_run_;      // accumulated tree time for drift check
+    PS::S32 n_step_run_;    // number of steps for drift check
+
+    //! add a candidate if it is in the allowed range and not a duplicate
+    void addCandidate(const PS::S64 _n_leaf_limit, const PS::S64 _n_group_limit) {
+        if (_n_leaf_limit<n_leaf_min_ || _n_leaf_limit>n_leaf_max_) return;
+        if (_n_group_limit<n_group_min_ || _n_group_limit>n_group_max_) return;
+        if (_n_leaf_limit>_n_group_limit) return;
+        for (auto& c: candidate_)
+            if (c.n_leaf_limit==_n_leaf_limit && c.n_group_limit==_n_group_limit) return;
+        candidate_.push_back(Candidate{_n_leaf_limit, _n_group_limit, 0.0, 0});
+    }
+
+    //! start a search round around the current parameters, the first candidate is the current one
+    void startRound() {
+        candidate_.clear();
+        // the current parameters are always the first candidate (trees in use), extend the allowed range if they are outside
+        n_leaf_min_ = std::min(n_leaf_min_, n_leaf_limit_);
+        n_leaf_max_ = std::max(n_leaf_max_, n_leaf_limit_);
+        n_group_min_ = std::min(n_group_min_, n_group_limit_);
+        n_group_max_ = std::max(n_group_max_, n_group_limit_);
+        candidate_.push_back(Candidate{n_leaf_limit_, n_group_limit_, 0.0, 0});
+        addCandidate(n_leaf_limit_, n_group_limit_/2);
+        addCandidate(n_leaf_limit_, n_group_limit_*2);
+        addCandidate(n_leaf_limit_/2, n_group_limit_);
+        addCandidate(n_leaf_limit_*2, n_group_limit_);
+        assert(!candidate_.empty());
+        i_candidate_ = 0;
+        n_skip_ = 0;
+        explore_flag_ = true;
+    }
+
+    //! get the fastest candidate with finished measurement, NULL if none or no search runs
+    const Candidate* getBestMeasured() const {
+        if (!explore_flag_) return NULL;
+        const Candidate* c_best = NULL;
+        for (auto& c: candidate_) 
+            if (c.n_step>=n_step_measure_ && (c_best==NULL || c.time<c_best->time)) c_best = &c;
+        return c_best;
+    }
+
+    //! set the current parameters to a candidate
+    /*! \return true if the parameters are changed
+     */
+    bool setCurrent(const Candidate& _c) {
+        bool change_flag = (_c.n_leaf_limit!=n_leaf_limit_ || _c.n_group_limit!=n_group_limit_);
+        n_leaf_limit_ = _c.n_leaf_limit;
+        n_group_limit_ = _c.n_group_limit;
+        return change_flag;
+    }
+
+public:
+    PS::S64 n_leaf_min_;   // minimum leaf limit
+    PS::S64 n_leaf_max_;   // maximum leaf limit
+    PS::S64 n_group_min_;  // minimum group limit
+    PS::S64 n_group_max_;  // maximum group limit
+    PS::S32 n_round_max_;  // maximum number of search rounds at one time
+    PS::F64 drift_limit_;  // relative increase of tree time per step to start a new search
+    PS::S32 n_step_drift_factor_; // number of steps for drift check in unit of n_step_measure_
+
+    TreeParameterTuner(): candidate_(), i_candidate_(0), i_round_(0), n_skip_(0), explore_flag_(false),
+                          mode_(0), n_step_measure_(4), n_leaf_limit_(0), n_group_limit_(0),
+                          time_last_(0.0), time_valid_(false), time_best_(0.0), time_run_(0.0), n_step_run_(0),
+                          n_leaf_min_(4), n_leaf_max_(256), n_group_min_(64), n_group_max_(8192),
+                          n_round_max_(3), drift_limit_(0.2), n_step_drift_factor_(8) {}
+
+    //! initialize and start the first search (call at the beginning of a run or a restart)
+    /*! @param[in] _mode: 0: off; 1: search at the beginning; 2: also search again when the tree time drifts
+      @param[in] _n_step_measure: number of measured tree steps per candidate
+      @param[in] _n_leaf_limit: initial leaf limit
+      @param[in] _n_group_limit: initial group limit
+     */
+    void initialize(const PS::S32 _mode, const PS::S32 _n_step_measure, const PS::S64 _n_leaf_limit, const PS::S64 _n_group_limit) {
+        assert(_mode>=0 && _mode<=2);
+        assert(_n_step_measure>0);
+        mode_ = _mode;
+        n_step_measure_ = _n_step_measure;
+        n_leaf_limit_ = _n_leaf_limit;
+        n_group_limit_ = _n_group_limit;
+        time_valid_ = false;
+        time_last_ = 0.0;
+        i_round_ = 0;
+        time_run_ = 0.0;
+        n_step_run_ = 0;
+        explore_flag_ = false;
+        if (mode_>0) startRound();
+    }
+
+    //! the cumulative tree time is reset (e.g. the profile is cleared), the next difference is not a tree step
+    void clearTimeReference() {
+        time_last_ = 0.0;
+        time_valid_ = false;
+    }
+
+    //! update with the cumulative tree time at the beginning of a tree step (call on all ranks)
+    /*! @param[in] _time_tree_cum: cumulative wall time of tree phases since the last clearTimeReference
+      @param[in] _print_flag: print the measurement and the choices
+      @param[in] _time: current time for printing
+      \return true if the tree parameters are changed, use getNumberOfLeafLimit and getNumberOfGroupLimit to get the new values
+     */
+    bool update(const PS::F64 _time_tree_cum, const bool _print_flag, const PS::F64 _time) {
+        const PS::F64 dt_step = _time_tree_cum - time_last_;
+        const bool step_valid = time_valid_;
+        time_last_ = _time_tree_cum;
+        time_valid_ = true;
+        if (mode_==0 || !step_valid) return false;
+
+        if (explore_flag_) {
+            Candidate& c = candidate_[i_candidate_];
+            // the first step after changing the trees includes the reallocation
+            if (n_skip_<1) {
+                n_skip_++;
+                return false;
+            }
+            c.time += dt_step;
+            c.n_step++;
+            if (c.n_step<n_step_measure_) return false;
+
+            c.time = PS::Comm::getMaxValue(c.time/c.n_step);
+            if (_print_flag)
+                std::cout<<"Tree tuning: time = "<<_time
+                         <<" round = "<<i_round_
+                         <<" n_leaf_limit = "<<c.n_leaf_limit
+                         <<" n_group_limit = "<<c.n_group_limit
+                         <<" tree time per step = "<<c.time
+                         <<std::endl;
+
+            // next candidate
+            i_candidate_++;
+            n_skip_ = 0;
+            if (i_candidate_<(PS::S32)candidate_.size()) return setCurrent(candidate_[i_candidate_]);
+
+            // finish one round
+            PS::S32 i_best = 0;
+            for (PS::S32 i=1; i<(PS::S32)candidate_.size(); i++)
+                if (candidate_[i].time<candidate_[i_best].time) i_best = i;
+            const Candidate best = candidate_[i_best];
+            const bool change_flag = setCurrent(best);
+            i_round_++;
+            if (i_best>0 && i_round_<n_round_max_) {
+                // search around the new center, its time is already measured
+                startRound();
+                candidate_[0].time = best.time;
+                candidate_[0].n_step = n_step_measure_;
+                i_candidate_ = 1;
+                if (i_candidate_<(PS::S32)candidate_.size()) {
+                    setCurrent(candidate_[i_candidate_]);
+                    return true;
+                }
+            }
+            explore_flag_ = false;
+            i_round_ = 0;
+            time_best_ = best.time;
+            time_run_ = 0.0;
+            n_step_run_ = 0;
+            if (_print_flag)
+                std::cout<<"Tree tuning: time = "<<_time
+                         <<" choose n_leaf_limit = "<<n_leaf_limit_
+                         <<" n_group_limit = "<<n_group_limit_
+                         <<" tree time per step = "<<time_best_
+                         <<std::endl;
+            return change_flag;
+        }
+        else if (mode_==2) {
+            time_run_ += dt_step;
+            n_step_run_++;
+            if (n_step_run_<n_step_measure_*n_step_drift_factor_) return false;
+            const PS::F64 time_run = PS::Comm::getMaxValue(time_run_/n_step_run_);
+            time_run_ = 0.0;
+            n_step_run_ = 0;
+            if (time_run>time_best_*(1.0+drift_limit_)) {
+                if (_print_flag)
+                    std::cout<<"Tree tuning: time = "<<_time
+                             <<" tree time per step increases from "<<time_best_<<" to "<<time_run
+                             <<", search again"<<std::endl;
+                startRound();
+            }
+            // follow the decrease of tree time, e.g. particles escape
+            else if (time_run<time_best_) time_best_ = time_run;
+        }
+        return false;
+    }
+
+    //! whether candidates are being measured
+    bool isExploring() const {
+        return explore_flag_;
+    }
+
+    PS::S64 getNumberOfLeafLimit() const {
+        return n_leaf_limit_;
+    }
+
+    PS::S64 getNumberOfGroupLimit() const {
+        return n_group_limit_;
+    }
+
+    //! leaf limit of the fastest measured candidate in the current search, or the current one if no search runs
+    PS::S64 getNumberOfLeafLimitBest() const {
+        const Candidate* c = getBestMeasured();
+        return c==NULL? n_leaf_limit_: c->n_leaf_limit;
+    }
+
+    //! group limit of the fastest measured candidate in the current search, or the current one if no search runs
+    PS::S64 getNumberOfGroupLimitBest() const {
+        const Candidate* c = getBestMeasured();
+        return c==NULL? n_group_limit_: c->n_group_limit;
+    }
+};
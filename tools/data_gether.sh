@@ -71,6 +71,12 @@ do
 	    echo $flist
 	    cat $flist >$fout.$s
 	fi
+	# binary SSE/BSE event records
+	if [ -e $file.bin.0 ]; then
+	    echo 'convert '$file'.bin.* to '$fout.$s
+	    flist=`ls |egrep $file'.bin.[0-9]+$'`
+	    petar.se.event.convert -o $fout.$s $flist
+	fi
     fi
 done
 
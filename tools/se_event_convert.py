@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+
+import struct
+import sys
+import getopt
+
+# layout of SEEventRecord in src/se_event_log.hpp
+SE_EVENT_LABEL_SIZE = 24
+SE_EVENT_COLUMN_MAX = 64
+record_header = struct.Struct('<%ds4iQ' % SE_EVENT_LABEL_SIZE)
+record_size = record_header.size + 8*SE_EVENT_COLUMN_MAX
+
+def convertRecords(filename, fout):
+    """ Convert binary SSE/BSE event records to the text lines printed by petar
+
+    Parameters:
+    -----------
+    filename: binary event file name
+    fout: output text stream
+    """
+    with open(filename, 'rb') as fin:
+        while True:
+            data = fin.read(record_size)
+            if len(data) < record_size: break
+            label, n_col, width, precision, reserved, int_mask = record_header.unpack_from(data, 0)
+            fmt_int = '%'+str(width)+'d'
+            fmt_float = '%'+str(width)+'.'+str(precision)+'g'
+            line = [label.split(b'\0',1)[0].decode()]
+            offset = record_header.size
+            for i in range(n_col):
+                if (int_mask>>i)&1:
+                    line.append(fmt_int % struct.unpack_from('<q', data, offset)[0])
+                else:
+                    line.append(fmt_float % struct.unpack_from('<d', data, offset)[0])
+                offset += 8
+            fout.write(''.join(line)+'\n')
+
+if __name__ == '__main__':
+
+    filename_out = ''
+
+    def usage():
+        print("A tool to convert binary SSE/BSE event files to the text format.")
+        print("When stellar evolution is switched on, petar writes events (type change, SN kick, dynamical merger, binary events) ")
+        print("to binary files with the suffix '.[sse/bse].bin.[MPI rank]', e.g., 'data.bse.bin.0'. ")
+        print("The text lines generated by this tool have the same columns as those in '.[sse/bse].[MPI rank]'.")
+        print("The tool 'petar.data.gether' calls this tool automatically.")
+        print("Usage: petar.se.event.convert [options] [binary event filenames]")
+        print("Options (default arguments shown in parentheses at the end):")
+        print("  -h(--help)          Display help information.")
+        print("  -o(--output)    [S] Output text filename; append to the file if it exists (default: print to screen).")
+
+    try:
+        shortargs = 'o:h'
+        longargs = ['output=','help']
+        opts,remainder= getopt.getopt( sys.argv[1:], shortargs, longargs)
+
+        for opt,arg in opts:
+            if opt in ('-h','--help'):
+                usage()
+                sys.exit(1)
+            elif opt in ('-o','--output'):
+                filename_out = arg
+            else:
+                assert False, "unhandled option"
+
+    except getopt.GetoptError as err:
+        print(err)
+        usage()
+        sys.exit(2)
+
+    if len(remainder)==0:
+        print('Error, binary event filename not provided')
+        usage()
+        sys.exit(2)
+
+    fout = open(filename_out, 'a') if filename_out != '' else sys.stdout
+    for filename in remainder:
+        convertRecords(filename, fout)
+    if filename_out != '':
+        fout.close()
@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+
+import json
+import sys
+import getopt
+
+def readTrace(filename):
+    """ Read one timeline trace file written by petar
+
+    The file is a JSON array of trace events which is not closed, and each event ends with a comma.
+
+    Parameters:
+    -----------
+    filename: trace file name
+
+    Return:
+    -----------
+    list of trace events
+    """
+    with open(filename, 'r') as fin:
+        text = fin.read().strip()
+    if text.startswith('['): text = text[1:]
+    if text.endswith(']'): text = text[:-1]
+    text = text.strip().rstrip(',')
+    return json.loads('['+text+']')
+
+if __name__ == '__main__':
+
+    filename_out = 'trace.json'
+
+    def usage():
+        print("A tool to merge the timeline trace files of all MPI ranks to one file in Chrome trace-event format.")
+        print("When petar runs with the option '--trace-buffer-size' >0, the spans of phases, hard clusters and collectives of each thread ")
+        print("are written to the files with the suffix '.trace.[MPI rank]', e.g., 'data.trace.0'. ")
+        print("The merged file can be viewed with chrome://tracing or https://ui.perfetto.dev; the process ID is the MPI rank and the thread ID is the OpenMP thread index.")
+        print("Usage: petar.trace.merge [options] [trace filenames]")
+        print("Options (default arguments shown in parentheses at the end):")
+        print("  -h(--help)          Display help information.")
+        print("  -o(--output)    [S] Output filename (%s)." % filename_out)
+
+    try:
+        shortargs = 'o:h'
+        longargs = ['output=','help']
+        opts,remainder= getopt.getopt( sys.argv[1:], shortargs, longargs)
+
+        for opt,arg in opts:
+            if opt in ('-h','--help'):
+                usage()
+                sys.exit(1)
+            elif opt in ('-o','--output'):
+                filename_out = arg
+            else:
+                assert False, "unhandled option"
+
+    except getopt.GetoptError as err:
+        print(err)
+        usage()
+        sys.exit(2)
+
+    if len(remainder)==0:
+        print('Error, trace filename not provided')
+        usage()
+        sys.exit(2)
+
+    events = []
+    for filename in remainder:
+        events += readTrace(filename)
+
+    with open(filename_out, 'w') as fout:
+        json.dump({'traceEvents': events, 'displayTimeUnit': 'ms'}, fout)
+    print('Merge %d events from %d files to %s' % (len(events), len(remainder), filename_out))